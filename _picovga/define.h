@@ -10,6 +10,7 @@
 #define LAYERS_MAX	4	// max. number of layers (should be 4)
 
 #define BLACK_MAX	MAXX	// size of buffer with black color (used to clear rest of unused line)
+#define ARENA_MAX	(2*DBUF_MAX+2*CBUF_MAX*4+BLACK_MAX) // size of arena with scanline buffers
 
 // VGA PIO program
 #define BASE_OFFSET	17	// offset of base layer program
@@ -95,12 +96,26 @@
 #define SSEGM_WRAPY	10	// u16	wrapy;	// wrap width in Y direction (number of lines, cannot be 0)
 #define SSEGM_DATA	12	// const void* data; // pointer to video buffer with image data
 #define SSEGM_FORM	16	// u8	form;	// graphics format GF_*
-#define SSEGM_DBLY	17	// bool dbly;	// double Y (2 scanlines per 1 image line)
+#define SSEGM_DBLY	17	// u8	dbly:1;	// bit 0: double Y (2 scanlines per 1 image line)
+				// u8	dblx:2;	// bits 1..2: repeat pixels in X direction DBLX_*
 #define SSEGM_PAR3	18	// u16	par3;	// SSEGM_PAR3 parameter 3
 #define SSEGM_PAR	20	// u32	par;	// parameter 1: color, pointer to palettes, tile source, font
 #define SSEGM_PAR2	24	// u32	par2;	// parameter 2
 #define SSEGM_SIZE	28	// size of sSegm structure
 
+// repeat pixels in X direction (sSegm.dblx)
+//  Segment is rendered with width/2 or width/4 pixels and then expanded. Used by formats
+//  of 3rd group (rendered into data buffer), other formats ignore it (GF_GRAPH8 is sent
+//  by DMA directly from the image, expanding it would cost more than whole width).
+//  GF_GRAPH4, GF_GRAPH2 and GF_GRAPH1 with DBLX_2 are rendered with doubled pixels
+//  directly (GF_GRAPH2 reads colors from entries 0x00, 0x55, 0xAA and 0xFF of palette
+//  translation table, so the table must be generated by GenPal4Trans).
+//  Segment width should be multiple of 8 (DBLX_2) or 16 (DBLX_4), rest of the segment
+//  is displayed black. offx and wrapx are in source pixels.
+#define DBLX_1		0	// single pixels
+#define DBLX_2		1	// double pixels
+#define DBLX_4		2	// quadruple pixels
+
 // Structure of video strip sStrip (on change update structure sStrip in vga_screen.h)
 #define SSTRIP_HEIGHT	0	// u16	height;		// height of this strip in number of scanlines
 #define SSTRIP_NUM	2	// u16	num;		// number of video segments
@@ -113,6 +128,36 @@
 #define SSCREEN_STRIP	4	// sStrip	strip[STRIPMAX]; // list of video strips
 #define SSCREEN_SIZE	(4+SSTRIP_SIZE*STRIPMAX) // size of sScreen structure (= 4 + 228*8 = 1828 bytes)
 
+// Structure of oscilloscope trace sMOscTrace (on change update structure sMOscTrace in vga_screen.h)
+#define SMOSCTRACE_DATA	0	// const u8* data; // source samples 0..255 (NULL = trace is off)
+#define SMOSCTRACE_BUF	4	// u8*	buf;	// buffer of Y ranges of pixels, MOSCIL_BUFSIZE(width) bytes
+#define SMOSCTRACE_BLK	8	// u8*	blk;	// pointer to Y ranges of 16-pixel blocks (prepared by MOscilPrep, NULL = trace is off)
+#define SMOSCTRACE_OFF	12	// s16	off;	// Y offset of sample 0 (in lines from bottom)
+#define SMOSCTRACE_GAIN	14	// s16	gain;	// gain (256 = 1 line per sample step, negative = inverted)
+#define SMOSCTRACE_COL	16	// u8	col;	// trace color
+#define SMOSCTRACE_YLO	17	// u8	ylo;	// first line of Y range of whole trace (prepared by MOscilPrep)
+#define SMOSCTRACE_YLEN	18	// u8	ylen;	// number of lines - 1 of Y range of whole trace (prepared by MOscilPrep)
+				// u8	res;	// ...reserved, structure align
+#define SMOSCTRACE_SIZE	20	// size of sMOscTrace structure
+
+// Structure of multi-trace oscilloscope sMOscil (on change update structure sMOscil in vga_screen.h)
+#define SMOSCIL_WIDTH	0	// u16	width;	// number of samples (= wrapx of the segment)
+#define SMOSCIL_NUM	2	// u8	num;	// number of traces (0..MOSCIL_MAX)
+#define SMOSCIL_BG	3	// u8	bg;	// background color
+#define SMOSCIL_GRID	4	// u8	grid;	// graticule color
+#define SMOSCIL_GRIDX	5	// u8	gridx;	// X step of graticule in pixels (0 = no vertical lines)
+#define SMOSCIL_GRIDY	6	// u8	gridy;	// Y step of graticule in lines (0 = no horizontal lines)
+#define SMOSCIL_LINE	7	// u8	line;	// True = connect samples with lines, False = pixels
+#define SMOSCIL_TRACE	8	// sMOscTrace trace[MOSCIL_MAX]; // traces
+#define SMOSCIL_SIZE	88	// size of sMOscil structure
+
+#define MOSCIL_MAX	4	// max. number of traces
+#define MOSCIL_BUFSIZE(w) ((w)*2+((w)+15)/16*2) // size of trace buffer with Y ranges for width w
+
+// Translation table of GF_PLANE4: u32 expand[256] + (unused) + u16 trans[256]
+#define PLANE4_PALOFF	2560	// offset of 16-color palette translation table u16 trans[256]
+#define PLANE4_TRANSSIZE (PLANE4_PALOFF+512) // size of GF_PLANE4 translation table (= 3072 bytes)
+
 // --- graphics formats
 // There are 3 groups of formats - separated due internal reasons, do not mix them.
 
@@ -173,14 +218,14 @@
 				//	par2 = pointer to 4-color palette translation table)
 #define GF_ATTRIB8	21	// 2x4 bit color attribute per 8x8 pixel sample (data=mono graphic, par=offset of color attributes,
 				//	par2 = pointer to 16-color palette table)
-#define GF_GRAPH8MAT	22	// 8-bit graphics with 2D matrix transformation, using hardware interpolator inter1 (inter1 state is not saved during interrup)
+#define GF_GRAPH8MAT	22	// 8-bit graphics with 2D matrix transformation, using hardware interpolator inter1 (inter1 state is saved by scanline interrupt)
 				//	(data=image, par=pointer to 6 matrix integer parameters m11,m12..m23 ((int)(m*FRACTMUL)),
 				//	par2 LOW=number of bits of image width, par2 HIGH=number of bits of image height)
-#define GF_GRAPH8PERSP	23	// 8-bit graphics with perspective, using hardware interpolator inter1 (inter1 state is not saved during interrup)
+#define GF_GRAPH8PERSP	23	// 8-bit graphics with perspective, using hardware interpolator inter1 (inter1 state is saved by scanline interrupt)
 				//	(data=image, par=pointer to 6 matrix integer parameters m11,m12..m23 ((int)(m*FRACTMUL)),
 				//	par2 LOW=number of bits of image width, par2 HIGH=number of bits of image height,
 				//	par3=horizon offset)
-#define GF_TILEPERSP	24	// tiles with perspective, using hardware interpolators inter0 and inter1 (their state is not saved during interrup)
+#define GF_TILEPERSP	24	// tiles with perspective, using hardware interpolators inter0 and inter1 (their state is saved by scanline interrupt)
 				//	(data=tile map, par=one column of tiles, par2=pointer to integer matrix,
 				//	wb LOW=number of bits of map width, wb HIGH=number of bits of map height,
 				//	par3 LOW=number of bits of tile size, par3 HIGH=horizon offset/4 or 0=no perspective or <0=ceilling,
@@ -189,9 +234,22 @@
 #define GF_TILEPERSP2	26	// tiles with perspective, double pixels (parameters as GF_TILEPERSP)
 #define GF_TILEPERSP3	27	// tiles with perspective, triple pixels (parameters as GF_TILEPERSP)
 #define GF_TILEPERSP4	28	// tiles with perspective, quadruple pixels (parameters as GF_TILEPERSP)
+#define GF_PTEXT	29	// proportional mono text, 8-pixel glyphs with advance 0..PTEXT_MAXW pixels (par = pointer to 1-bit font
+				//	with line of glyph widths after last font line, par2 = 2 colors of palettes)
+#define GF_WTEXT	30	// 8-pixel wide character attribute text, 16-bit character + 2x4 bit attributes
+				//	(par = pointer to 1-bit font pages, par2 = pointer to 16 colors of palettes,
+				//	par3 LOW = font height, par3 HIGH = number of font pages)
+
+#define GF_MOSCIL	31	// multi-trace oscilloscope graph (par = pointer to descriptor sMOscil with traces prepared by MOscilPrep)
+#define GF_FRC		32	// 8-bit paletted graphics with temporal dithering (FRC) of 12-bit colors (data = 8-bit indices,
+				//	par = pointer to FRC palette table u8[512] generated with GenFrcPal)
+#define GF_PLANE4	33	// 16 colors on 4 graphic planes (data=graphic, par=offset of next graphic plane,
+				//	par2 = pointer to 16-color plane translation table u8[PLANE4_TRANSSIZE] generated with GenPal16Plane)
 
 #define GF_GRP3MIN	GF_GRAPH4	// 3rd group minimal format
-#define GF_GRP3MAX	GF_TILEPERSP4	// 3rd group maximal format
+#define GF_GRP3MAX	GF_PLANE4	// 3rd group maximal format
+
+#define PTEXT_MAXW	24	// max. glyph advance of GF_PTEXT (8-pixel glyph + spacing; 7 pending + 24 pixels fit into 32-bit accumulator)
 
 
 #define FRACT		12	// number of bits of fractional part of fractint number (use max. 13, min. 8)
@@ -7,215 +7,491 @@
 
 #include "include.h"
 
+// fill bytes with color pattern (unaligned start and end are stored by bytes, aligned middle by words)
+//  d ... destination
+//  col ... color pattern
+//  n ... number of bytes
+static void DrawFillBytes(u8* d, u8 col, int n)
+{
+	// short span
+	if (n < 16)
+	{
+		for (; n > 0; n--) *d++ = col;
+		return;
+	}
+
+	// store start unaligned 1..3 bytes
+	for (; ((u32)(uintptr_t)d & 3) != 0; n--) *d++ = col;
+
+	// store aligned words
+	d = (u8*)MemSet4((u32*)d, (u32)col*0x01010101, n >> 2);
+
+	// store end unaligned 1..3 bytes
+	for (n &= 3; n > 0; n--) *d++ = col;
+}
+
+// fill bits with color pattern (pixels are stored from highest bits of the byte)
+//  d ... destination row
+//  bit ... bit offset of first pixel in the row
+//  n ... number of bits
+//  col ... color pattern
+static void DrawFillBits(u8* d, int bit, int n, u8 col)
+{
+	d += bit >> 3;
+	bit &= 7;
+	u8 m;
+
+	// store start unaligned bits
+	if (bit != 0)
+	{
+		m = 0xff >> bit; // mask of bits to end of byte
+		bit += n;
+		if (bit < 8) m &= ~(0xff >> bit); // mask of end of span
+		*d = (*d & ~m) | (col & m);
+		d++;
+		n = bit - 8; // remaining bits
+		if (n <= 0) return;
+	}
+
+	// store aligned bytes
+	DrawFillBytes(d, col, n >> 3);
+	d += n >> 3;
+
+	// store end unaligned bits
+	n &= 7;
+	if (n > 0)
+	{
+		m = ~(0xff >> n); // mask of start of byte
+		*d = (*d & ~m) | (col & m);
+	}
+}
+
+// get clipping box of canvas in image coordinates (x2 and y2 are exclusive)
+static inline void CanvasBox(const sCanvas* canvas, int* x1, int* y1, int* x2, int* y2)
+{
+	int bx1 = canvas->ox;
+	int by1 = canvas->oy;
+	int bx2 = bx1 + canvas->w;
+	int by2 = by1 + canvas->h;
+	if (canvas->clipnum > 0)
+	{
+		const sDirtyRect* r = &canvas->clip[canvas->clipnum - 1];
+		if (r->x1 > bx1) bx1 = r->x1;
+		if (r->y1 > by1) by1 = r->y1;
+		if (r->x2 < bx2) bx2 = r->x2;
+		if (r->y2 < by2) by2 = r->y2;
+	}
+	*x1 = bx1;
+	*y1 = by1;
+	*x2 = bx2;
+	*y2 = by2;
+}
+
+// get clipping box in canvas coordinates (x2 and y2 are exclusive)
+static inline void CanvasClipBox(const sCanvas* canvas, int* x1, int* y1, int* x2, int* y2)
+{
+	CanvasBox(canvas, x1, y1, x2, y2);
+	*x1 -= canvas->ox;
+	*y1 -= canvas->oy;
+	*x2 -= canvas->ox;
+	*y2 -= canvas->oy;
+}
+
+// initialize canvas of whole image
+void CanvasInit(sCanvas* canvas, u8 format, int w, int h, int wb, u8* img, u8* img2 /* = NULL */)
+{
+	memset(canvas, 0, sizeof(sCanvas));
+	if ((img2 == NULL) && ((format == CANVAS_PLANE2) || (format == CANVAS_PLANE4) ||
+		(format == CANVAS_ATTRIB8))) img2 = img + wb*h;
+	canvas->img = img;
+	canvas->img2 = img2;
+	canvas->w = w;
+	canvas->h = h;
+	canvas->wb = wb;
+	canvas->format = format;
+}
+
+// create sub-canvas view of rectangle of canvas
+void CanvasView(sCanvas* view, const sCanvas* canvas, int x, int y, int w, int h)
+{
+	int bx1, by1, bx2, by2;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+
+	*view = *canvas;
+	x += canvas->ox;
+	y += canvas->oy;
+	view->ox = x;
+	view->oy = y;
+	view->w = w;
+	view->h = h;
+	view->clipnum = 0;
+
+	// view is not inside parent, clip it by parent
+	if ((x < bx1) || (y < by1) || (x + w > bx2) || (y + h > by2))
+	{
+		sDirtyRect* r = &view->clip[0];
+		r->x1 = (s16)bx1;
+		r->y1 = (s16)by1;
+		r->x2 = (s16)bx2;
+		r->y2 = (s16)by2;
+		view->clipnum = 1;
+	}
+}
+
+// push clipping rectangle (intersection with current clipping; returns False if stack is full)
+Bool CanvasClipPush(sCanvas* canvas, int x, int y, int w, int h)
+{
+	if (canvas->clipnum >= CANVAS_CLIPMAX) return False;
+
+	int bx1, by1, bx2, by2;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+	x += canvas->ox;
+	y += canvas->oy;
+	w += x;
+	h += y;
+	if (x < bx1) x = bx1;
+	if (y < by1) y = by1;
+	if (w > bx2) w = bx2;
+	if (h > by2) h = by2;
+	if (w < x) w = x;
+	if (h < y) h = y;
+
+	sDirtyRect* r = &canvas->clip[canvas->clipnum++];
+	r->x1 = (s16)x;
+	r->y1 = (s16)y;
+	r->x2 = (s16)w;
+	r->y2 = (s16)h;
+	return True;
+}
+
+// pop clipping rectangle
+void CanvasClipPop(sCanvas* canvas)
+{
+	if (canvas->clipnum > 0) canvas->clipnum--;
+}
+
+// start tracking of dirty region (NULL = stop tracking), whole canvas is marked as dirty
+void CanvasDirtyOn(sCanvas* canvas, sDirty* dirty)
+{
+	canvas->dirty = dirty;
+	if (dirty == NULL) return;
+	dirty->num = 1;
+	dirty->rect[0].x1 = (s16)canvas->ox;
+	dirty->rect[0].y1 = (s16)canvas->oy;
+	dirty->rect[0].x2 = (s16)(canvas->ox + canvas->w);
+	dirty->rect[0].y2 = (s16)(canvas->oy + canvas->h);
+}
+
+// clear dirty region
+void CanvasDirtyClear(sCanvas* canvas)
+{
+	if (canvas->dirty != NULL) canvas->dirty->num = 0;
+}
+
+// add rectangle to dirty region (negative w or h = rectangle lies to the left or up)
+void CanvasDirtyAdd(sCanvas* canvas, int x, int y, int w, int h)
+{
+	sDirty* d = canvas->dirty;
+	if (d == NULL) return;
+
+	// normalize rectangle
+	if (w < 0)
+	{
+		x += w + 1;
+		w = -w;
+	}
+
+	if (h < 0)
+	{
+		y += h + 1;
+		h = -h;
+	}
+
+	// limit coordinates (dirty region is in image coordinates)
+	int bx1, by1, bx2, by2;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+	x += canvas->ox;
+	y += canvas->oy;
+	int x2 = x + w;
+	int y2 = y + h;
+	if (x < bx1) x = bx1;
+	if (y < by1) y = by1;
+	if (x2 > bx2) x2 = bx2;
+	if (y2 > by2) y2 = by2;
+	if ((x >= x2) || (y >= y2)) return;
+
+	// quick check of last changed rectangle
+	int n = d->num;
+	sDirtyRect* r;
+	if (n > 0)
+	{
+		r = &d->rect[n-1];
+		if ((x >= r->x1) && (y >= r->y1) && (x2 <= r->x2) && (y2 <= r->y2)) return;
+	}
+
+	// merge with rectangles
+	int i, a1, a2, u, best, bestwaste;
+	for (;;)
+	{
+		// find rectangle adding least of clean area
+		best = -1;
+		bestwaste = 0;
+		a1 = (x2 - x)*(y2 - y);
+		for (i = 0; i < n; i++)
+		{
+			r = &d->rect[i];
+			a2 = (r->x2 - r->x1)*(r->y2 - r->y1);
+			u = (((x2 > r->x2) ? x2 : r->x2) - ((x < r->x1) ? x : r->x1)) *
+				(((y2 > r->y2) ? y2 : r->y2) - ((y < r->y1) ? y : r->y1));
+			u -= a1 + a2;
+			if ((best < 0) || (u < bestwaste))
+			{
+				best = i;
+				bestwaste = u;
+			}
+		}
+
+		// no merge, list is not full
+		if ((best < 0) || ((bestwaste > DIRTY_WASTE) && (n < DIRTY_MAX))) break;
+
+		// merge rectangle and delete it from the list
+		r = &d->rect[best];
+		if (r->x1 < x) x = r->x1;
+		if (r->y1 < y) y = r->y1;
+		if (r->x2 > x2) x2 = r->x2;
+		if (r->y2 > y2) y2 = r->y2;
+		n--;
+		*r = d->rect[n];
+	}
+
+	// add new rectangle to the end of the list
+	r = &d->rect[n];
+	r->x1 = (s16)x;
+	r->y1 = (s16)y;
+	r->x2 = (s16)x2;
+	r->y2 = (s16)y2;
+	d->num = n + 1;
+}
+
+// list of chained DMA transfers, entry = 4 words written to alias 1 registers of
+// data channel: control word, read address, write address, count (with trigger)
+static u32 CanvasDmaList[(CANVAS_DMAROWS+1)*4];
+static int CanvasDmaNum = 0;	// number of entries in the list
+static u32 CanvasDmaCtrl;	// control word of data channel
+
+// run list of chained DMA transfers and wait for its end
+static void CanvasDmaRun()
+{
+	if (CanvasDmaNum == 0) return;
+
+	// terminate list with null trigger (in quiet mode it sets IRQ flag of data channel,
+	// interrupt itself is not enabled)
+	u32* e = &CanvasDmaList[CanvasDmaNum*4];
+	e[0] = CanvasDmaCtrl;
+	e[1] = 0;
+	e[2] = 0;
+	e[3] = 0;
+
+	// start control channel and wait for end of the list
+	dma_hw->ints0 = 1u << CANVAS_DMA;
+	dma_channel_set_read_addr(CANVAS_DMA_CB, CanvasDmaList, true);
+	while ((dma_hw->intr & (1u << CANVAS_DMA)) == 0) {}
+	dma_hw->ints0 = 1u << CANVAS_DMA;
+	CanvasDmaNum = 0;
+}
+
+// add row to list of chained DMA transfers (run the list if it is full)
+static void CanvasDmaAdd(u8* d, const u8* s, int n)
+{
+	if (CanvasDmaNum >= CANVAS_DMAROWS) CanvasDmaRun();
+	u32* e = &CanvasDmaList[CanvasDmaNum*4];
+	e[0] = CanvasDmaCtrl;
+	e[1] = (u32)(uintptr_t)s;
+	e[2] = (u32)(uintptr_t)d;
+	e[3] = n/4;
+	CanvasDmaNum++;
+}
+
+// copy rows of one image plane (returns number of copied bytes)
+//  d ... destination plane
+//  wbd ... destination pitch
+//  s ... source plane
+//  wbs ... source pitch
+//  b1, b2 ... range of bytes in the row
+//  y1, y2 ... range of rows
+static int CanvasCopyRows(u8* d, int wbd, const u8* s, int wbs, int b1, int b2, int y1, int y2)
+{
+	// round to 32-bit words
+	int wb = (wbd < wbs) ? wbd : wbs;
+	b1 &= ~3;
+	b2 = (b2 + 3) & ~3;
+	if (b2 > wb) b2 = wb;
+
+	// prepare rows
+	d += b1 + y1*wbd;
+	s += b1 + y1*wbs;
+	int n = b2 - b1;
+	int rows = y2 - y1;
+	int size = n*rows;
+
+	// whole rows are copied as one block
+	if ((n == wbd) && (n == wbs))
+	{
+		n = size;
+		rows = 1;
+	}
+
+	// use DMA on long aligned rows
+	Bool dma = (n >= CANVAS_DMAMIN) && ((((u32)(uintptr_t)d | (u32)(uintptr_t)s | (u32)n | (u32)wbd | (u32)wbs) & 3) == 0);
+
+	for (; rows > 0; rows--)
+	{
+		if (dma)
+			CanvasDmaAdd(d, s, n);
+		else
+			memcpy(d, s, n);
+		d += wbd;
+		s += wbs;
+	}
+	return size;
+}
+
+// copy dirty region of back canvas to displayed canvas and clear it (returns number of copied bytes)
+int CanvasPresent(sCanvas* dst, sCanvas* src)
+{
+	sDirty* dirty = src->dirty;
+	if ((dirty == NULL) || (dst->format != src->format)) return 0;
+
+	// data channel: copy words, chain to control channel after each row
+	dma_channel_config cfg = dma_channel_get_default_config(CANVAS_DMA);
+	channel_config_set_read_increment(&cfg, true);
+	channel_config_set_write_increment(&cfg, true);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+	channel_config_set_chain_to(&cfg, CANVAS_DMA_CB);
+	channel_config_set_irq_quiet(&cfg, true);
+	CanvasDmaCtrl = channel_config_get_ctrl_value(&cfg);
+
+	// control channel: write one list entry (4 words) to alias 1 registers of data channel
+	cfg = dma_channel_get_default_config(CANVAS_DMA_CB);
+	channel_config_set_read_increment(&cfg, true);
+	channel_config_set_write_increment(&cfg, true);
+	channel_config_set_ring(&cfg, true, 4);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+	dma_channel_configure(CANVAS_DMA_CB, &cfg, &dma_hw->ch[CANVAS_DMA].al1_ctrl, CanvasDmaList, 4, false);
+
+	// bits per pixel and number of planes
+	int bits = 1;
+	int planes = 1;
+	switch (src->format)
+	{
+	case CANVAS_8: bits = 8; break;
+	case CANVAS_4: bits = 4; break;
+	case CANVAS_2: bits = 2; break;
+	case CANVAS_PLANE2: planes = 2; break;
+	case CANVAS_PLANE4: planes = 4; break;
+	}
+
+	// loop dirty rectangles
+	int i, j, size = 0;
+	for (i = 0; i < dirty->num; i++)
+	{
+		sDirtyRect* r = &dirty->rect[i];
+		int b1 = r->x1*bits/8;
+		int b2 = (r->x2*bits + 7)/8;
+
+		// copy planes
+		for (j = 0; j < planes; j++)
+			size += CanvasCopyRows(dst->img + j*(dst->img2 - dst->img), dst->wb,
+				src->img + j*(src->img2 - src->img), src->wb, b1, b2, r->y1, r->y2);
+
+		// copy attributes
+		if (src->format == CANVAS_ATTRIB8)
+			size += CanvasCopyRows(dst->img2, dst->wb, src->img2, src->wb,
+				b1, b2, r->y1/8, (r->y2 + 7)/8);
+	}
+
+	// copy rest of rows by DMA
+	CanvasDmaRun();
+
+	dirty->num = 0;
+	return size;
+}
+
 // Draw rectangle
 //  col with CANVAS_ATTRIB8 format: bit 0..3 = draw color, bit 4 = draw color is background color
 void DrawRect(sCanvas* canvas, int x, int y, int w, int h, u8 col)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x, y, w, h);
+
+	// clipping box, coordinates in image
+	int bx1, by1, bx2, by2;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+	x += canvas->ox;
+	y += canvas->oy;
+
 	// limit x
-	if (x < 0)
+	if (x < bx1)
 	{
-		w += x;
-		x = 0;
+		w += x - bx1;
+		x = bx1;
 	}
-	if (x + w > canvas->w) w = canvas->w - x;
+	if (x + w > bx2) w = bx2 - x;
 	if (w <= 0) return;
 
 	// limit y
-	if (y < 0)
+	if (y < by1)
 	{
-		h += y;
-		y = 0;
+		h += y - by1;
+		y = by1;
 	}
-	if (y + h > canvas->h) h = canvas->h - y;
+	if (y + h > by2) h = by2 - y;
 	if (h <= 0) return;
 
-	// check format
+	// prepare planes, bits per pixel and color patterns
+	int wb = canvas->wb;
+	u8* img[4];
+	u8 pat[4];
+	int planes = 1;
+	int bits = 1;
+	img[0] = canvas->img + y*wb;
 	switch(canvas->format)
 	{
 	// 8-bit pixels
 	case CANVAS_8:
-		{
-			int wb = canvas->wb;
-			u8* d = canvas->img + x + y*wb;
-			wb -= w;
-			int i;
-			for (; h > 0; h--)
-			{
-				for (i = w; i > 0; i--) *d++ = col;
-				d += wb;
-			}
-		}
+		bits = 8;
+		pat[0] = col;
 		break;
 
 	// 4-bit pixels
 	case CANVAS_4:
-		{
-			int wb = canvas->wb;
-			u8* d = canvas->img + x/2 + y*wb;
-			u8* d0;
-			u8 col2 = col << 4;
-			u8 col3 = col2 | col;
-			int i;
-			for (; h > 0; h--)
-			{
-				d0 = d;
-				i = w;
-				if ((x & 1) != 0)
-				{
-					*d = (*d & 0xf0) | col;
-					d++;
-					i--;
-				}
-
-				for (; i > 1; i -= 2) *d++ = col3;
-
-				if (i > 0) *d = (*d & 0x0f) | col2;
-				d = d0 + wb;
-			}
-		}
+		bits = 4;
+		pat[0] = (col & 0x0f)*0x11;
 		break;
 
 	// 2-bit pixels
 	case CANVAS_2:
-		{
-			int wb = canvas->wb;
-			u8* d = canvas->img + x/4 + y*wb;
-			u8* d0;
-			col = (col << 6) | (col << 4) | (col << 2) | col;
-			int i, m, dx;
-			for (; h > 0; h--)
-			{
-				d0 = d;
-				i = w;
-
-				// store start unaligned 1..3 pixels
-				dx = x & 3;
-				if (dx != 0)
-				{
-					m = 0xc0 >> (dx*2); // mask of 2 color bits
-					for (; i > 0; i--)
-					{
-						*d = (*d & ~m) | (col & m); // set 1 pixel
-						dx++; // shift x position
-						if (dx == 4) { i--; break; } // x is aligned
-						m >>= 2; // shift mask
-					}
-					d++;
-				}
-
-				// store aligned 4 pixels
-				for (; i > 3; i -= 4) *d++ = col;
-
-				// store end unaligned 1..3 pixels
-				m = 0xc0; // mask of 2 color bits
-				for (; i > 0; i--)
-				{
-					*d = (*d & ~m) | (col & m); // set 1 pixel
-					m >>= 2; // shift mask
-				}
-				d = d0 + wb;
-			}
-		}
+		bits = 2;
+		pat[0] = (col & 3)*0x55;
 		break;
 
 	// 1-bit pixels
 	case CANVAS_1:
-		{
-			int wb = canvas->wb;
-			u8* d = canvas->img + x/8 + y*wb;
-			u8* d0;
-			col = (col<<7)|(col<<6)|(col<<5)|(col<<4)|(col<<3)|(col<<2)|(col<<1)|col;
-			int i, m, dx;
-			for (; h > 0; h--)
-			{
-				d0 = d;
-				i = w;
-
-				// store start unaligned 1..7 pixels
-				dx = x & 7;
-				if (dx != 0)
-				{
-					m = 0x80 >> dx; // mask of 1 color bit
-					for (; i > 0; i--)
-					{
-						*d = (*d & ~m) | (col & m); // set 1 pixel
-						dx++; // shift x position
-						if (dx == 8) { i--; break; } // x is aligned
-						m >>= 1; // shift mask
-					}
-					d++;
-				}
-
-				// store aligned 8 pixels
-				for (; i > 7; i -= 8) *d++ = col;
-
-				// store end unaligned 1..7 pixels
-				m = 0x80; // mask of 1 color bit
-				for (; i > 0; i--)
-				{
-					*d = (*d & ~m) | (col & m); // set 1 pixel
-					m >>= 1; // shift mask
-				}
-
-				d = d0 + wb;
-			}
-		}
+		pat[0] = ((col & 1) != 0) ? 0xff : 0;
 		break;
 
 	// 4 colors on 2 planes
+	// 16 colors on 4 planes (planes follow at distance img2-img)
 	case CANVAS_PLANE2:
+	case CANVAS_PLANE4:
 		{
-			int wb = canvas->wb;
-			u8* d = canvas->img + x/8 + y*wb; // 1st plane
-			u8* d2 = canvas->img2 + x/8 + y*wb; // 2nd plane
-			u8* d0;
-			u8* d02;
-			u8 col2 = col >> 1;
-			col2 = (col2<<7)|(col2<<6)|(col2<<5)|(col2<<4)|(col2<<3)|(col2<<2)|(col2<<1)|col2;
-			col &= 1;
-			col = (col<<7)|(col<<6)|(col<<5)|(col<<4)|(col<<3)|(col<<2)|(col<<1)|col;
-			int i, m, dx;
-			for (; h > 0; h--)
+			planes = (canvas->format == CANVAS_PLANE2) ? 2 : 4;
+			int plane = canvas->img2 - canvas->img;
+			int i;
+			for (i = 0; i < planes; i++)
 			{
-				d0 = d;
-				d02 = d2;
-				i = w;
-
-				// store start unaligned 1..7 pixels
-				dx = x & 7;
-				if (dx != 0)
-				{
-					m = 0x80 >> dx; // mask of 1 color bit
-					for (; i > 0; i--)
-					{
-						*d = (*d & ~m) | (col & m); // set 1 pixel
-						*d2 = (*d2 & ~m) | (col2 & m); // set 1 pixel
-						dx++; // shift x position
-						if (dx == 8) { i--; break; } // x is aligned
-						m >>= 1; // shift mask
-					}
-					d++;
-					d2++;
-				}
-
-				// store aligned 8 pixels
-				for (; i > 7; i -= 8)
-				{
-					*d++ = col;
-					*d2++ = col2;
-				}
-
-				// store end unaligned 1..7 pixels
-				m = 0x80; // mask of 1 color bit
-				for (; i > 0; i--)
-				{
-					*d = (*d & ~m) | (col & m); // set 1 pixel
-					*d2 = (*d2 & ~m) | (col2 & m); // set 1 pixel
-					m >>= 1; // shift mask
-				}
-
-				d = d0 + wb;
-				d2 = d02 + wb;
+				img[i] = img[0] + i*plane;
+				pat[i] = (((col >> i) & 1) != 0) ? 0xff : 0;
 			}
 		}
 		break;
@@ -223,113 +499,55 @@ void DrawRect(sCanvas* canvas, int x, int y, int w, int h, u8 col)
 	// 2x4 bit color attributes per 8x8 pixel sample
 	case CANVAS_ATTRIB8:
 		{
-			int wb = canvas->wb;
-			u8* d = canvas->img + x/8 + y*wb; // pixels
-			u8* d0;
-			u8* d2 = canvas->img2 + x/8 + (y/8)*wb; // attributes
-			u8* d02;
-			int i, m, dx;
-
-			// draw color is foreground color
-			if ((col & B4) == 0)
+			// attributes, once per 8 lines
+			u8 m = 0xf0; // mask of attribute to keep
+			u8 c = col & 0x0f; // new attribute
+			if ((col & B4) != 0)
 			{
-				for (; h > 0; h--)
-				{
-					d0 = d;
-					d02 = d2;
-					i = w;
-
-					// store start unaligned 1..7 pixels
-					dx = x & 7;
-					if (dx != 0)
-					{
-						m = 0x80 >> dx; // mask of 1 color bit
-						for (; i > 0; i--)
-						{
-							*d = *d | m; // set 1 pixel
-							dx++; // shift x position
-							if (dx == 8) { i--; break; } // x is aligned
-							m >>= 1; // shift mask
-						}
-						*d2 = (*d2 & 0xf0) | col;
-						d++;
-						d2++;
-					}
-
-					// store aligned 8 pixels
-					for (; i > 7; i -= 8)
-					{
-						*d++ = 0xff;
-						*d2 = (*d2 & 0xf0) | col;
-						d2++;
-					}
-
-					// store end unaligned 1..7 pixels
-					if (i > 0)
-					{
-						m = 0xff << (8-i); // mask
-						*d = *d | m;
-						*d2 = (*d2 & 0xf0) | col;
-					}
-
-					d = d0 + wb;
-					d2 = d02;
-					y++;
-					if ((y & 7) == 0) d2 += wb;
-				}
+				m = 0x0f;
+				c <<= 4;
 			}
-
-			// draw color is background color
-			else
+			int x0 = x/8;
+			int n = (x + w - 1)/8 - x0 + 1;
+			int y0;
+			for (y0 = y/8; y0 <= (y + h - 1)/8; y0++)
 			{
-				col <<= 4;
-				for (; h > 0; h--)
+				u8* d = canvas->img2 + x0 + y0*wb;
+				int i;
+				for (i = n; i > 0; i--)
 				{
-					d0 = d;
-					d02 = d2;
-					i = w;
+					*d = (*d & m) | c;
+					d++;
+				}
+			}
 
-					// store start unaligned 1..7 pixels
-					dx = x & 7;
-					if (dx != 0)
-					{
-						m = 0x80 >> dx; // mask of 1 color bit
-						for (; i > 0; i--)
-						{
-							*d = *d & ~m; // set 1 pixel
-							dx++; // shift x position
-							if (dx == 8) { i--; break; } // x is aligned
-							m >>= 1; // shift mask
-						}
-						*d2 = (*d2 & 0x0f) | col;
-						d++;
-						d2++;
-					}
+			// pixels: set foreground, clear background
+			pat[0] = ((col & B4) == 0) ? 0xff : 0;
+		}
+		break;
 
-					// store aligned 8 pixels
-					for (; i > 7; i -= 8)
-					{
-						*d++ = 0;
-						*d2 = (*d2 & 0x0f) | col;
-						d2++;
-					}
+	default:
+		return;
+	}
 
-					// store end unaligned 1..7 pixels
-					if (i > 0)
-					{
-						m = 0xff << (8-i); // mask
-						*d = *d & ~m;
-						*d2 = (*d2 & 0x0f) | col;
-					}
+	// whole lines without padding, fill as one span
+	int i;
+	if ((x == 0) && (w*bits == wb*8))
+	{
+		for (i = 0; i < planes; i++) DrawFillBytes(img[i], pat[i], h*wb);
+		return;
+	}
 
-					d = d0 + wb;
-					d2 = d02;
-					y++;
-					if ((y & 7) == 0) d2 += wb;
-				}
-			}
+	// fill lines
+	x *= bits;
+	w *= bits;
+	for (; h > 0; h--)
+	{
+		for (i = 0; i < planes; i++)
+		{
+			DrawFillBits(img[i], x, w, pat[i]);
+			img[i] += wb;
 		}
-		break;
 	}
 }
 
@@ -350,13 +568,9 @@ void DrawClear(sCanvas* canvas)
 	DrawRect(canvas, 0, 0, canvas->w, canvas->h, 0);
 }
 
-// Draw point
-//  col with CANVAS_ATTRIB8 format: bit 0..3 = draw color, bit 4 = draw color is background color
-void DrawPoint(sCanvas* canvas, int x, int y, u8 col)
+// draw pixel in image coordinates (without clipping and dirty region)
+static void DrawPix(const sCanvas* canvas, int x, int y, u8 col)
 {
-	// check coordinates
-	if (((u32)x >= (u32)canvas->w) || ((u32)y >= (u32)canvas->h)) return;
-
 	// check format
 	switch(canvas->format)
 	{
@@ -498,6 +712,25 @@ void DrawPoint(sCanvas* canvas, int x, int y, u8 col)
 		}
 		break;
 
+	// 16 colors on 4 planes
+	case CANVAS_PLANE4:
+		{
+			int plane = canvas->img2 - canvas->img;
+			u8* d = canvas->img + x/8 + y*canvas->wb;
+			u8 m = 0x80 >> (x & 7);
+			int i;
+			for (i = 0; i < 4; i++)
+			{
+				if ((col & 1) != 0)
+					*d |= m;
+				else
+					*d &= ~m;
+				col >>= 1;
+				d += plane;
+			}
+		}
+		break;
+
 	// 2x4 bit color attributes per 8x8 pixel sample
 	case CANVAS_ATTRIB8:
 		{
@@ -523,11 +756,44 @@ void DrawPoint(sCanvas* canvas, int x, int y, u8 col)
 	}
 }
 
+// Draw point
+//  col with CANVAS_ATTRIB8 format: bit 0..3 = draw color, bit 4 = draw color is background color
+void DrawPoint(sCanvas* canvas, int x, int y, u8 col)
+{
+	// mark dirty region
+	CanvasDirty(canvas, x, y, 1, 1);
+
+	// check coordinates, in image
+	int bx1, by1, bx2, by2;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+	x += canvas->ox;
+	y += canvas->oy;
+	if ((x < bx1) || (x >= bx2) || (y < by1) || (y >= by2)) return;
+
+	DrawPix(canvas, x, y, col);
+}
+
 // Draw line
 //  using Bresenham's line algorithm
 //  col with CANVAS_ATTRIB8 format: bit 0..3 = draw color, bit 4 = draw color is background color
 void DrawLine(sCanvas* canvas, int x1, int y1, int x2, int y2, u8 col)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x1, y1, (x2 >= x1) ? (x2 - x1 + 1) : (x2 - x1 - 1), (y2 >= y1) ? (y2 - y1 + 1) : (y2 - y1 - 1));
+
+	// horizontal line is filled as span
+	if (y1 == y2)
+	{
+		if (x1 > x2)
+		{
+			int k = x1;
+			x1 = x2;
+			x2 = k;
+		}
+		DrawRect(canvas, x1, y1, x2 - x1 + 1, 1, col);
+		return;
+	}
+
 	// difference of coordinates
 	int dx = x2 - x1;
 	int dy = y2 - y1;
@@ -554,9 +820,19 @@ void DrawLine(sCanvas* canvas, int x1, int y1, int x2, int y2, u8 col)
 	// 8-bit pixels use faster service
 	if (canvas->format == CANVAS_8)
 	{
-		u32 w = canvas->w;
-		u32 h = canvas->h;
-		u8* d = canvas->img + x1 + y1*wb;
+		// coordinates relative to clipping box
+		int bx1, by1, bx2, by2;
+		CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+		if ((bx1 >= bx2) || (by1 >= by2)) return;
+		u32 w = bx2 - bx1;
+		u32 h = by2 - by1;
+		u8* d = canvas->img + (x1 + canvas->ox) + (y1 + canvas->oy)*wb;
+		bx1 -= canvas->ox;
+		by1 -= canvas->oy;
+		x1 -= bx1;
+		y1 -= by1;
+		x2 -= bx1;
+		y2 -= by1;
 
 		// steeply in X direction, X is prefered as base
 		if (dx > dy)
@@ -648,6 +924,24 @@ void DrawLine(sCanvas* canvas, int x1, int y1, int x2, int y2, u8 col)
 	// other formats
 	else
 	{
+		// coordinates relative to clipping box
+		int bx1, by1, bx2, by2;
+		CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+		if ((bx1 >= bx2) || (by1 >= by2)) return;
+		u32 w = bx2 - bx1;
+		u32 h = by2 - by1;
+		int ox = bx1;
+		int oy = by1;
+		bx1 -= canvas->ox;
+		by1 -= canvas->oy;
+		x1 -= bx1;
+		y1 -= by1;
+		x2 -= bx1;
+		y2 -= by1;
+
+		// check coordinates only if line is not whole inside clipping box
+		Bool check = ((u32)x1 >= w) || ((u32)x2 >= w) || ((u32)y1 >= h) || ((u32)y2 >= h);
+
 		// steeply in X direction, X is prefered as base
 		if (dx > dy)
 		{
@@ -658,10 +952,10 @@ void DrawLine(sCanvas* canvas, int x1, int y1, int x2, int y2, u8 col)
 			x2 += sx;
 			for (; x1 != x2; x1 += sx)
 			{
-				DrawPoint(canvas, x1, y1, col);
+				if (!check || (((u32)x1 < w) && ((u32)y1 < h))) DrawPix(canvas, x1 + ox, y1 + oy, col);
 				if (p > 0)
 				{
-					y1 += sy;;
+					y1 += sy;
 					p -= dx;
 				}
 				p += m;
@@ -678,7 +972,7 @@ void DrawLine(sCanvas* canvas, int x1, int y1, int x2, int y2, u8 col)
 			y2 += sy;
 			for (; y1 != y2; y1 += sy)
 			{
-				DrawPoint(canvas, x1, y1, col);
+				if (!check || (((u32)x1 < w) && ((u32)y1 < h))) DrawPix(canvas, x1 + ox, y1 + oy, col);
 				if (p > 0)
 				{
 					x1 += sx;
@@ -703,20 +997,32 @@ void DrawLine(sCanvas* canvas, int x1, int y1, int x2, int y2, u8 col)
 //         . B5|B6 .
 void DrawFillCircle(sCanvas* canvas, int x0, int y0, int r, u8 col, u8 mask /*=0xff*/)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x0-r, y0-r, 2*r+1, 2*r+1);
+
+	// circle is out of clipping box
 	int x, y;
 	if (r <= 0) return;
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+	if ((x0+r <= bx1) || (x0-r >= bx2) || (y0+r <= by1) || (y0-r >= by2)) return;
 	int r2 = r*(r-1);
 	r--;
 
-	// full circle (faster drawing)
+	// full circle (faster drawing, filled by horizontal spans)
 	if (mask == 0xff)
 	{
+		x = 0;
 		for (y = -r; y <= r; y++)
 		{
-			for (x = -r; x <= r; x++)
-			{
-				if ((x*x + y*y) <= r2) DrawPoint(canvas, x+x0, y+y0, col);
-			}
+			// half width of this line
+			if (y <= 0)
+				while ((x < r) && (((x+1)*(x+1) + y*y) <= r2)) x++;
+			else
+				while ((x >= 0) && ((x*x + y*y) > r2)) x--;
+
+			if ((x >= 0) && ((x*x + y*y) <= r2) && (y+y0 >= by1) && (y+y0 < by2))
+				DrawRect(canvas, x0-x, y+y0, 2*x+1, 1, col);
 		}
 		return;
 	}
@@ -832,8 +1138,15 @@ void DrawFillCircle(sCanvas* canvas, int x0, int y0, int r, u8 col, u8 mask /*=0
 //         . B5|B6 .
 void DrawCircle(sCanvas* canvas, int x0, int y0, int r, u8 col, u8 mask /*=0xff*/)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x0-r, y0-r, 2*r+1, 2*r+1);
+
+	// circle is out of clipping box
 	int x, y;
 	if (r <= 0) return;
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+	if ((x0+r <= bx1) || (x0-r >= bx2) || (y0+r <= by1) || (y0-r >= by2)) return;
 	r--;
 
 	x = 0;
@@ -861,11 +1174,295 @@ void DrawCircle(sCanvas* canvas, int x0, int y0, int r, u8 col, u8 mask /*=0xff*
 	}
 }
 
+// polygon edge (X coordinates in 16.16 fixed point, sampled at pixel centers)
+typedef struct {
+	int	x;	// X coordinate on current scanline
+	int	dx;	// X increment per scanline
+	int	y1;	// top Y coordinate (first scanline)
+	int	y2;	// bottom Y coordinate (exclusive)
+	int	x1;	// top X coordinate
+	int	x2;	// bottom X coordinate
+} sDrawEdge;
+
+// prepare edge stepping from scanline y (y1 < y2, y1 <= y < y2)
+static void DrawEdgeInit(sDrawEdge* e, int x1, int y1, int x2, int y2, int y)
+{
+	int dx = ((x2 - x1) << 16) / (y2 - y1);
+	e->dx = dx;
+	e->x = (x1 << 16) + dx*(y - y1) + dx/2;
+}
+
+// first pixel covered by edge (pixel center lies right of the edge)
+#define DRAWEDGE_PIX(x) (((x) + 0x7fff) >> 16)
+
+// Draw filled polygon
+void DrawFillPoly(sCanvas* canvas, const s16* xy, int n, u8 col)
+{
+	// polygon with too many vertices is not drawn (as in DrawListFillPoly)
+	if ((n < 3) || (n > DRAWPOLY_MAX)) return;
+
+	// bounding box, mark dirty region
+	int i, j, x1, y1, x2, y2;
+	int xmin = xy[0], xmax = xmin, ymin = xy[1], ymax = ymin;
+	for (i = 1; i < n; i++)
+	{
+		x1 = xy[2*i];
+		y1 = xy[2*i+1];
+		if (x1 < xmin) xmin = x1;
+		if (x1 > xmax) xmax = x1;
+		if (y1 < ymin) ymin = y1;
+		if (y1 > ymax) ymax = y1;
+	}
+	CanvasDirty(canvas, xmin, ymin, xmax - xmin + 1, ymax - ymin + 1);
+
+	// limit rows by clipping box (spans are clipped by DrawRect)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+	if (ymin < by1) ymin = by1;
+	if (ymax > by2) ymax = by2;
+	if ((ymin >= ymax) || (xmax < bx1) || (xmin >= bx2)) return;
+
+	// edge table, sorted by top Y (horizontal and invisible edges are skipped)
+	sDrawEdge edge[DRAWPOLY_MAX];
+	sDrawEdge* e;
+	int num = 0;
+	x2 = xy[2*n-2];
+	y2 = xy[2*n-1];
+	for (i = 0; i < n; i++)
+	{
+		x1 = x2;
+		y1 = y2;
+		x2 = xy[2*i];
+		y2 = xy[2*i+1];
+		if (y1 == y2) continue;
+		e = &edge[num];
+		if (y1 < y2)
+		{
+			e->x1 = x1; e->y1 = y1; e->x2 = x2; e->y2 = y2;
+		}
+		else
+		{
+			e->x1 = x2; e->y1 = y2; e->x2 = x1; e->y2 = y1;
+		}
+		if ((e->y2 <= ymin) || (e->y1 >= ymax)) continue;
+
+		// insert sort
+		for (j = num; (j > 0) && (edge[j-1].y1 > e->y1); j--) {}
+		if (j < num)
+		{
+			sDrawEdge t = *e;
+			memmove(&edge[j+1], &edge[j], (num - j)*sizeof(sDrawEdge));
+			edge[j] = t;
+		}
+		num++;
+	}
+
+	// active edges, sorted by X
+	sDrawEdge* act[DRAWPOLY_MAX];
+	int na = 0, next = 0, y;
+	for (y = ymin; y < ymax; y++)
+	{
+		// remove finished edges
+		for (i = 0, j = 0; i < na; i++) if (act[i]->y2 > y) act[j++] = act[i];
+		na = j;
+
+		// add new edges
+		for (; (next < num) && (edge[next].y1 <= y); next++)
+		{
+			e = &edge[next];
+			DrawEdgeInit(e, e->x1, e->y1, e->x2, e->y2, y);
+			act[na++] = e;
+		}
+		if ((na == 0) && (next >= num)) break;
+
+		// sort active edges by X (insert sort, order changes only on crossing)
+		for (i = 1; i < na; i++)
+		{
+			e = act[i];
+			for (j = i; (j > 0) && (act[j-1]->x > e->x); j--) act[j] = act[j-1];
+			act[j] = e;
+		}
+
+		// fill spans between pairs of edges (even-odd rule)
+		for (i = 0; i + 1 < na; i += 2)
+		{
+			x1 = DRAWEDGE_PIX(act[i]->x);
+			x2 = DRAWEDGE_PIX(act[i+1]->x);
+			if (x2 > x1) DrawRect(canvas, x1, y, x2 - x1, 1, col);
+		}
+
+		// step edges
+		for (i = 0; i < na; i++) act[i]->x += act[i]->dx;
+	}
+}
+
+// color gradient of Gouraud triangle (colors in 16.16 fixed point)
+typedef struct {
+	u32	c0;	// color in pixel 0,0
+	u32	dx;	// color increment in X direction
+	u32	dy;	// color increment in Y direction
+	int	cmin;	// minimal color
+	int	cmax;	// maximal color
+} sDrawGrad;
+
+// fill span of Gouraud triangle
+static void DrawGradSpan(sCanvas* canvas, int x1, int x2, int y, const sDrawGrad* g)
+{
+	// limit X by clipping box
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+	if (x1 < bx1) x1 = bx1;
+	if (x2 > bx2) x2 = bx2;
+	if (x1 >= x2) return;
+
+	// colors at start and end of span (wrap of partial terms is OK, result is in range)
+	u32 c = g->c0 + g->dx*x1 + g->dy*y;
+	int ca = (s32)c >> 16;
+	int cb = (s32)(c + g->dx*(x2 - x1 - 1)) >> 16;
+	Bool clamp = (ca < g->cmin) || (ca > g->cmax) || (cb < g->cmin) || (cb > g->cmax);
+	int k;
+
+	// 8-bit pixels
+	if (canvas->format == CANVAS_8)
+	{
+		u8* d = canvas->img + (x1 + canvas->ox) + (y + canvas->oy)*canvas->wb;
+		if (!clamp)
+		{
+			for (; x1 < x2; x1++)
+			{
+				*d++ = (u8)(c >> 16);
+				c += g->dx;
+			}
+			return;
+		}
+
+		for (; x1 < x2; x1++)
+		{
+			k = (s32)c >> 16;
+			if (k < g->cmin) k = g->cmin;
+			if (k > g->cmax) k = g->cmax;
+			*d++ = (u8)k;
+			c += g->dx;
+		}
+		return;
+	}
+
+	// other formats (span is inside clipping box, dirty region is marked by triangle)
+	x1 += canvas->ox;
+	x2 += canvas->ox;
+	y += canvas->oy;
+	for (; x1 < x2; x1++)
+	{
+		k = (s32)c >> 16;
+		if (k < g->cmin) k = g->cmin;
+		if (k > g->cmax) k = g->cmax;
+		DrawPix(canvas, x1, y, (u8)k);
+		c += g->dx;
+	}
+}
+
+// rasterize triangle (g = NULL to fill with color col)
+static void DrawTri(sCanvas* canvas, int x1, int y1, int x2, int y2, int x3, int y3,
+	u8 col, const sDrawGrad* g)
+{
+	// sort vertices by Y
+	int t;
+	if (y1 > y2) { t = x1; x1 = x2; x2 = t; t = y1; y1 = y2; y2 = t; }
+	if (y2 > y3) { t = x2; x2 = x3; x3 = t; t = y2; y2 = y3; y3 = t; }
+	if (y1 > y2) { t = x1; x1 = x2; x2 = t; t = y1; y1 = y2; y2 = t; }
+
+	// mark dirty region
+	int xmin = x1, xmax = x1;
+	if (x2 < xmin) xmin = x2;
+	if (x2 > xmax) xmax = x2;
+	if (x3 < xmin) xmin = x3;
+	if (x3 > xmax) xmax = x3;
+	CanvasDirty(canvas, xmin, y1, xmax - xmin + 1, y3 - y1 + 1);
+
+	// limit Y by clipping box (spans are clipped when filled)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+	int y = y1;
+	if (y < by1) y = by1;
+	int ye = y3;
+	if (ye > by2) ye = by2;
+	if ((y >= ye) || (xmax < bx1) || (xmin >= bx2)) return;
+
+	// long edge 1-3 and short edges 1-2 and 2-3
+	sDrawEdge l, s;
+	DrawEdgeInit(&l, x1, y1, x3, y3, y);
+	int part;
+	for (part = 0; part < 2; part++)
+	{
+		int yp = (part == 0) ? y2 : ye;
+		if (yp > ye) yp = ye;
+		if (y >= yp) continue;
+		if (part == 0)
+			DrawEdgeInit(&s, x1, y1, x2, y2, y);
+		else
+			DrawEdgeInit(&s, x2, y2, x3, y3, y);
+
+		for (; y < yp; y++)
+		{
+			int xa = DRAWEDGE_PIX(l.x);
+			int xb = DRAWEDGE_PIX(s.x);
+			if (xa > xb) { t = xa; xa = xb; xb = t; }
+			if (xb > xa)
+			{
+				if (g == NULL)
+					DrawRect(canvas, xa, y, xb - xa, 1, col);
+				else
+					DrawGradSpan(canvas, xa, xb, y, g);
+			}
+			l.x += l.dx;
+			s.x += s.dx;
+		}
+	}
+}
+
+// Draw filled triangle
+void DrawFillTriangle(sCanvas* canvas, int x1, int y1, int x2, int y2, int x3, int y3, u8 col)
+{
+	DrawTri(canvas, x1, y1, x2, y2, x3, y3, col, NULL);
+}
+
+// Draw Gouraud shaded triangle (color index is interpolated)
+void DrawGouraudTriangle(sCanvas* canvas, int x1, int y1, u8 c1, int x2, int y2, u8 c2,
+	int x3, int y3, u8 c3)
+{
+	// color range
+	sDrawGrad g;
+	g.cmin = c1;
+	if (c2 < g.cmin) g.cmin = c2;
+	if (c3 < g.cmin) g.cmin = c3;
+	g.cmax = c1;
+	if (c2 > g.cmax) g.cmax = c2;
+	if (c3 > g.cmax) g.cmax = c3;
+
+	// degenerated triangle or single color
+	int d = (x2 - x1)*(y3 - y1) - (x3 - x1)*(y2 - y1);
+	if ((d == 0) || (g.cmin == g.cmax))
+	{
+		DrawTri(canvas, x1, y1, x2, y2, x3, y3, c1, NULL);
+		return;
+	}
+
+	// color gradient (plane through 3 vertices, sampled at pixel centers)
+	g.dx = (u32)((((s64)((c2 - c1)*(y3 - y1) - (c3 - c1)*(y2 - y1))) << 16) / d);
+	g.dy = (u32)((((s64)((c3 - c1)*(x2 - x1) - (c2 - c1)*(x3 - x1))) << 16) / d);
+	g.c0 = ((u32)c1 << 16) - g.dx*x1 - g.dy*y1 + (u32)((s32)(g.dx + g.dy) >> 1) + 0x8000;
+
+	DrawTri(canvas, x1, y1, x2, y2, x3, y3, 0, &g);
+}
+
 // Draw text (transparent background)
 //   font = pointer to 1-bit font
 void DrawText(sCanvas* canvas, const char* text, int x, int y, u8 col,
 	const void* font, int fontheight /*=8*/, int scalex /*=1*/, int scaley /*=1*/)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x, y, (int)strlen(text)*8*scalex, fontheight*scaley);
+
 	// invalid scale
 	if ((scalex == 0) || (scaley == 0)) return;
 
@@ -875,6 +1472,10 @@ void DrawText(sCanvas* canvas, const char* text, int x, int y, u8 col,
 	int dx = sx * scalex; // number of sub-pixels per one pixel in X direction
 	int dy = sy * scaley; // number of sub-lines per one line in Y direction
 
+	// clipping box (characters and lines out of the box are skipped)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+
 	int x0 = x;
 	int y0 = y;
 	u8 ch, ch0;
@@ -885,6 +1486,14 @@ void DrawText(sCanvas* canvas, const char* text, int x, int y, u8 col,
 	// loop through characters of text
 	while ((ch = (u8)*text++) != 0) // until end of text
 	{
+		// skip character out of clipping box
+		k = (scalex > 0) ? x0 : (x0 + scalex*8 + 1);
+		if ((k + dx*8 <= bx1) || (k >= bx2))
+		{
+			x0 += scalex*8;
+			continue;
+		}
+
 		// prepare point to font sample
 		s = &fnt[ch];
 
@@ -899,6 +1508,13 @@ void DrawText(sCanvas* canvas, const char* text, int x, int y, u8 col,
 			// loop through sub-lines of one character line
 			for (m = dy; m > 0; m--)
 			{
+				// skip line out of clipping box
+				if ((y < by1) || (y >= by2))
+				{
+					y += sy;
+					continue;
+				}
+
 				ch = ch0;
 
 				// loop through pixels of one character line
@@ -933,6 +1549,9 @@ void DrawText(sCanvas* canvas, const char* text, int x, int y, u8 col,
 void DrawTextBg(sCanvas* canvas, const char* text, int x, int y, u8 col, u8 bgcol,
 	const void* font, int fontheight /*=8*/, int scalex /*=1*/, int scaley /*=1*/)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x, y, (int)strlen(text)*8*scalex, fontheight*scaley);
+
 	// invalid scale
 	if ((scalex == 0) || (scaley == 0)) return;
 
@@ -942,6 +1561,10 @@ void DrawTextBg(sCanvas* canvas, const char* text, int x, int y, u8 col, u8 bgco
 	int dx = sx * scalex; // number of sub-pixels per one pixel in X direction
 	int dy = sy * scaley; // number of sub-lines per one line in Y direction
 
+	// clipping box (characters and lines out of the box are skipped)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+
 	int x0 = x;
 	int y0 = y;
 	u8 ch, ch0;
@@ -953,6 +1576,14 @@ void DrawTextBg(sCanvas* canvas, const char* text, int x, int y, u8 col, u8 bgco
 	// loop through characters of text
 	while ((ch = (u8)*text++) != 0) // until end of text
 	{
+		// skip character out of clipping box
+		k = (scalex > 0) ? x0 : (x0 + scalex*8 + 1);
+		if ((k + dx*8 <= bx1) || (k >= bx2))
+		{
+			x0 += scalex*8;
+			continue;
+		}
+
 		// prepare point to font sample
 		s = &fnt[ch];
 
@@ -967,6 +1598,13 @@ void DrawTextBg(sCanvas* canvas, const char* text, int x, int y, u8 col, u8 bgco
 			// loop through sub-lines of one character line
 			for (m = dy; m > 0; m--)
 			{
+				// skip line out of clipping box
+				if ((y < by1) || (y >= by2))
+				{
+					y += sy;
+					continue;
+				}
+
 				ch = ch0;
 
 				// loop through pixels of one character line
@@ -997,45 +1635,61 @@ void DrawTextBg(sCanvas* canvas, const char* text, int x, int y, u8 col, u8 bgco
 // Draw image (source and destination must have same format)
 void DrawImg(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int w, int h)
 {
+	// mark dirty region
+	CanvasDirty(canvas, xd, yd, w, h);
+
 	// must have same format
 	if (canvas->format != src->format) return;
 
+	// clipping boxes of destination and source, coordinates in images
+	int bx1, by1, bx2, by2, sx1, sy1, sx2, sy2, k;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+	CanvasBox(src, &sx1, &sy1, &sx2, &sy2);
+	xd += canvas->ox;
+	yd += canvas->oy;
+	xs += src->ox;
+	ys += src->oy;
+
 	// limit coordinates X
-	if (xd < 0)
+	if (xd < bx1)
 	{
-		w += xd;
-		xs -= xd;
-		xd = 0;
+		k = bx1 - xd;
+		w -= k;
+		xs += k;
+		xd = bx1;
 	}
 
-	if (xs < 0)
+	if (xs < sx1)
 	{
-		w += xs;
-		xd -= xs;
-		xs = 0;
+		k = sx1 - xs;
+		w -= k;
+		xd += k;
+		xs = sx1;
 	}
 
-	if (xd + w > canvas->w) w = canvas->w - xd;
-	if (xs + w > src->w) w = src->w - xs;
+	if (xd + w > bx2) w = bx2 - xd;
+	if (xs + w > sx2) w = sx2 - xs;
 	if (w <= 0) return;
 
 	// limit coordinates Y
-	if (yd < 0)
+	if (yd < by1)
 	{
-		h += yd;
-		ys -= yd;
-		yd = 0;
+		k = by1 - yd;
+		h -= k;
+		ys += k;
+		yd = by1;
 	}
 
-	if (ys < 0)
+	if (ys < sy1)
 	{
-		h += ys;
-		yd -= ys;
-		ys = 0;
+		k = sy1 - ys;
+		h -= k;
+		yd += k;
+		ys = sy1;
 	}
 
-	if (yd + h > canvas->h) h = canvas->h - yd;
-	if (ys + h > src->h) h = src->h - ys;
+	if (yd + h > by2) h = by2 - yd;
+	if (ys + h > sy2) h = sy2 - ys;
 	if (h <= 0) return;
 
 	// check format
@@ -1368,6 +2022,20 @@ void DrawImg(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int
 		}
 		break;
 
+	// 16 colors on 4 planes
+	case CANVAS_PLANE4:
+		{
+			sCanvas c, c2;
+			int i;
+			for (i = 0; i < 4; i++)
+			{
+				CanvasPlane(&c, canvas, i);
+				CanvasPlane(&c2, src, i);
+				DrawImg(&c, &c2, xd - canvas->ox, yd - canvas->oy, xs - src->ox, ys - src->oy, w, h);
+			}
+		}
+		break;
+
 	// 2x4 bit color attributes per 8x8 pixel sample
 	case CANVAS_ATTRIB8:
 		{
@@ -1475,6 +2143,9 @@ void DrawImg(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int
 //  CANVAS_ATTRIB8 format replaced by DrawImg function
 void DrawBlit(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int w, int h, u8 col)
 {
+	// mark dirty region
+	CanvasDirty(canvas, xd, yd, w, h);
+
 	// must have same format
 	if (canvas->format != src->format) return;
 
@@ -1485,42 +2156,55 @@ void DrawBlit(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int
 		return;
 	}
 
+	// clipping boxes of destination and source, coordinates in images
+	int bx1, by1, bx2, by2, sx1, sy1, sx2, sy2, k;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+	CanvasBox(src, &sx1, &sy1, &sx2, &sy2);
+	xd += canvas->ox;
+	yd += canvas->oy;
+	xs += src->ox;
+	ys += src->oy;
+
 	// limit coordinates X
-	if (xd < 0)
+	if (xd < bx1)
 	{
-		w += xd;
-		xs -= xd;
-		xd = 0;
+		k = bx1 - xd;
+		w -= k;
+		xs += k;
+		xd = bx1;
 	}
 
-	if (xs < 0)
+	if (xs < sx1)
 	{
-		w += xs;
-		xd -= xs;
-		xs = 0;
+		k = sx1 - xs;
+		w -= k;
+		xd += k;
+		xs = sx1;
 	}
 
-	if (xd + w > canvas->w) w = canvas->w - xd;
-	if (xs + w > src->w) w = src->w - xs;
+	if (xd + w > bx2) w = bx2 - xd;
+	if (xs + w > sx2) w = sx2 - xs;
 	if (w <= 0) return;
 
 	// limit coordinates Y
-	if (yd < 0)
+	if (yd < by1)
 	{
-		h += yd;
-		ys -= yd;
-		yd = 0;
+		k = by1 - yd;
+		h -= k;
+		ys += k;
+		yd = by1;
 	}
 
-	if (ys < 0)
+	if (ys < sy1)
 	{
-		h += ys;
-		yd -= ys;
-		ys = 0;
+		k = sy1 - ys;
+		h -= k;
+		yd += k;
+		ys = sy1;
 	}
 
-	if (yd + h > canvas->h) h = canvas->h - yd;
-	if (ys + h > src->h) h = src->h - ys;
+	if (yd + h > by2) h = by2 - yd;
+	if (ys + h > sy2) h = sy2 - ys;
 	if (h <= 0) return;
 
 	// check format
@@ -1704,89 +2388,1133 @@ void DrawBlit(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int
 				}
 				if (rd != 0) *d = b2;
 
-				d = d0 + wbd;
-				s = s0 + wbs;
-			}
+				d = d0 + wbd;
+				s = s0 + wbs;
+			}
+		}
+		break;
+
+	// 4 colors on 2 planes
+	case CANVAS_PLANE2:
+		{
+			int wbd = canvas->wb;
+			int wbs = src->wb;
+			u8* d = canvas->img + xd/8 + yd*wbd;
+			u8* d2 = canvas->img2 + xd/8 + yd*wbd;
+			u8* s = src->img + xs/8 + ys*wbs;
+			u8* s2 = src->img2 + xs/8 + ys*wbs;
+			u8* d0;
+			u8* d02;
+			u8* s0;
+			u8* s02;
+			u8 b, b1, b12, b2, bb, bb2, ms, md;
+			int i, rs, rd, xs2, xd2;
+			
+			for (; h > 0; h--)
+			{
+				d0 = d;
+				d02 = d2;
+				s0 = s;
+				s02 = s2;
+				i = w;
+				b = *s; // source sample
+				bb = *s2;
+				s++;
+				s2++;
+				b2 = *d; // destination sample
+				bb2 = *d2;
+
+				rs = 7 - (xs & 0x07); // source shift 0..7 -> 7..0
+				rd = (xd & 0x07); // destination shift 0..7
+
+				for (; i > 0; i--)
+				{
+					// move source pixel to destination
+					b1 = (b >> rs) & 0x01;
+					b12 = (bb >> rs) & 0x01;
+					if ((b1 | (b12<<1)) != col)
+					{
+						b2 = (b2 & ~(0x80 >> rd)) | (b1 << (7 - rd));
+						bb2 = (bb2 & ~(0x80 >> rd)) | (b12 << (7 - rd));
+					}
+
+					rs--;
+					if (rs < 0)
+					{
+						rs = 7;
+						b = *s++;
+						bb = *s2++;
+					}
+
+					rd++;
+					if (rd >= 8)
+					{
+						rd = 0;
+						*d++ = b2;
+						b2 = *d;
+						*d2++ = bb2;
+						bb2 = *d2;
+					}
+				}
+
+				if (rd != 0)
+				{
+					*d = b2;
+					*d2 = bb2;
+				}
+
+				d = d0 + wbd;
+				s = s0 + wbs;
+				d2 = d02 + wbd;
+				s2 = s02 + wbs;
+			}
+		}
+		break;
+
+	// 16 colors on 4 planes
+	case CANVAS_PLANE4:
+		{
+			int wbd = canvas->wb;
+			int wbs = src->wb;
+			int pd = canvas->img2 - canvas->img;
+			int ps = src->img2 - src->img;
+			u8* d0 = canvas->img + yd*wbd;
+			u8* s0 = src->img + ys*wbs;
+			u8* d;
+			u8* s;
+			u8 c, ms, md;
+			int i, j, x;
+
+			for (; h > 0; h--)
+			{
+				for (i = 0; i < w; i++)
+				{
+					// get source pixel
+					x = xs + i;
+					s = s0 + x/8;
+					ms = 0x80 >> (x & 7);
+					c = 0;
+					for (j = 0; j < 4; j++)
+					{
+						if ((*s & ms) != 0) c |= 1 << j;
+						s += ps;
+					}
+
+					// write destination pixel
+					if (c != col)
+					{
+						x = xd + i;
+						d = d0 + x/8;
+						md = 0x80 >> (x & 7);
+						for (j = 0; j < 4; j++)
+						{
+							if ((c & 1) != 0)
+								*d |= md;
+							else
+								*d &= ~md;
+							c >>= 1;
+							d += pd;
+						}
+					}
+				}
+				d0 += wbd;
+				s0 += wbs;
+			}
+		}
+		break;
+	}
+}
+
+// prepare color map of cross-format blit
+void DrawConvInit(sDrawConv* conv, const u8* srcpal, int srcnum, const u8* dstpal, int dstnum)
+{
+	int i, j, d, best, bestdist;
+	u8 c;
+
+	if (srcpal == NULL) srcnum = 256;
+	if (dstpal == NULL) dstnum = 256;
+	conv->pal = dstpal;
+
+	for (i = 0; i < 256; i++)
+	{
+		// unused source value
+		if (i >= srcnum)
+		{
+			conv->map[i] = 0;
+			continue;
+		}
+
+		// source color
+		c = (srcpal == NULL) ? (u8)i : srcpal[i];
+
+		// destination pixels are colors
+		if (dstpal == NULL)
+		{
+			conv->map[i] = c;
+			continue;
+		}
+
+		// search nearest destination color
+		best = 0;
+		bestdist = 0x7fffffff;
+		for (j = 0; j < dstnum; j++)
+		{
+			d = ColDist(c, dstpal[j]);
+			if (d < bestdist)
+			{
+				best = j;
+				bestdist = d;
+				if (d == 0) break;
+			}
+		}
+		conv->map[i] = (u8)best;
+	}
+}
+
+// spread bits of byte into nibbles (bit 7 -> bit 28, bit 6 -> bit 24, ... bit 0 -> bit 0)
+static inline u32 DrawConvSpread(u32 b)
+{
+	b = (b | (b << 12)) & 0x000f000f;
+	b = (b | (b << 6)) & 0x03030303;
+	return (b | (b << 3)) & 0x11111111;
+}
+
+// gather bits 0 of nibbles into byte (inverse of DrawConvSpread)
+static inline u8 DrawConvGather(u32 b)
+{
+	b &= 0x11111111;
+	b = (b | (b >> 3)) & 0x03030303;
+	b = (b | (b >> 6)) & 0x000f000f;
+	return (u8)(b | (b >> 12));
+}
+
+// expand 8 pixels of CANVAS_ATTRIB8 format to color indices in nibbles
+static inline u32 DrawConvAttr(u8 b, u8 a)
+{
+	u32 m = DrawConvSpread(b)*15;
+	return (m & ((a & 0x0f)*0x11111111)) | (~m & ((a >> 4)*0x11111111));
+}
+
+// source pixel reader of cross-format blit
+typedef struct {
+	const u8*	s;	// next byte of source pixels
+	const u8*	attr;	// next attribute (CANVAS_ATTRIB8)
+	int		plane;	// distance of planes (CANVAS_PLANE2, CANVAS_PLANE4)
+	u32		reg;	// shift register with pixels (pixels of planar formats are expanded to nibbles)
+	int		n;	// number of unread bits in shift register
+	int		bits;	// bits per pixel in shift register
+	u8		mask;	// mask of pixel
+	u8		format;	// source format
+} sDrawConvRd;
+
+// load next byte of source pixels
+static inline void DrawConvLoad(sDrawConvRd* rd)
+{
+	const u8* s = rd->s;
+	int plane = rd->plane;
+	switch (rd->format)
+	{
+	case CANVAS_PLANE2:
+		rd->reg = DrawConvSpread(s[0]) | (DrawConvSpread(s[plane]) << 1);
+		rd->n = 32;
+		break;
+
+	case CANVAS_PLANE4:
+		rd->reg = DrawConvSpread(s[0]) | (DrawConvSpread(s[plane]) << 1) |
+			(DrawConvSpread(s[2*plane]) << 2) | (DrawConvSpread(s[3*plane]) << 3);
+		rd->n = 32;
+		break;
+
+	case CANVAS_ATTRIB8:
+		rd->reg = DrawConvAttr(s[0], *rd->attr++);
+		rd->n = 32;
+		break;
+
+	// packed pixels
+	default:
+		rd->reg = s[0];
+		rd->n = 8;
+		break;
+	}
+	rd->s = s + 1;
+}
+
+// start reading source pixels at given coordinates
+static inline void DrawConvRdInit(sDrawConvRd* rd, const sCanvas* src, int x, int y)
+{
+	int wb = src->wb;
+	u8 f = src->format;
+	rd->format = f;
+	if (f <= CANVAS_1)
+	{
+		// packed pixels, format is log2 of pixels per byte
+		rd->bits = 8 >> f;
+		rd->mask = (u8)((1 << rd->bits) - 1);
+		rd->s = src->img + y*wb + (x >> f);
+		DrawConvLoad(rd);
+		rd->n -= (x & ((1 << f) - 1))*rd->bits;
+	}
+	else
+	{
+		rd->bits = 4;
+		rd->mask = 0x0f;
+		rd->plane = src->img2 - src->img;
+		rd->attr = src->img2 + (y/8)*wb + x/8;
+		rd->s = src->img + y*wb + x/8;
+		DrawConvLoad(rd);
+		rd->n -= (x & 7)*4;
+	}
+}
+
+// read next source pixel
+static inline u8 DrawConvGet(sDrawConvRd* rd)
+{
+	if (rd->n == 0) DrawConvLoad(rd);
+	rd->n -= rd->bits;
+	return (u8)(rd->reg >> rd->n) & rd->mask;
+}
+
+// destination pixel writer of cross-format blit
+typedef struct {
+	u8*		d;	// destination (32-bit word of packed pixels, byte of 1st plane of planar formats)
+	int		plane;	// distance of planes (CANVAS_PLANE2, CANVAS_PLANE4)
+	u32		reg;	// accumulated pixels (pixels of planar formats are in nibbles)
+	u32		msk;	// mask of written pixels
+	int		n;	// number of accumulated bits
+	int		bits;	// bits per pixel
+	u32		pix;	// mask of one pixel
+	u8		format;	// destination format
+} sDrawConvWr;
+
+// start writing destination pixels at given coordinates
+static inline void DrawConvWrInit(sDrawConvWr* wr, sCanvas* canvas, int x, int y)
+{
+	int wb = canvas->wb;
+	u8 f = canvas->format;
+	wr->format = f;
+	wr->reg = 0;
+	wr->msk = 0;
+	if (f <= CANVAS_1)
+	{
+		// packed pixels, start accumulating at aligned 32-bit word
+		wr->bits = 8 >> f;
+		u8* d = canvas->img + y*wb + (x >> f);
+		int off = (u32)(uintptr_t)d & 3;
+		wr->d = d - off;
+		wr->n = off*8 + (x & ((1 << f) - 1))*wr->bits;
+	}
+	else
+	{
+		wr->bits = 4;
+		wr->plane = canvas->img2 - canvas->img;
+		wr->d = canvas->img + y*wb + x/8;
+		wr->n = (x & 7)*4;
+	}
+	wr->pix = (1 << wr->bits) - 1;
+}
+
+// store accumulated destination pixels (must not be empty)
+static inline void DrawConvStore(sDrawConvWr* wr)
+{
+	u32 r = wr->reg;
+	u32 m = wr->msk;
+	int n = wr->n;
+	u8* d = wr->d;
+	u8 b, mb;
+	int i;
+
+	// align incomplete word to the left
+	if (n < 32)
+	{
+		r <<= 32 - n;
+		m <<= 32 - n;
+	}
+	wr->n = 0;
+
+	// packed pixels
+	if (wr->format <= CANVAS_1)
+	{
+		wr->d = d + 4;
+
+		// whole word
+		if (m == 0xffffffff)
+		{
+			*(u32*)d = __builtin_bswap32(r);
+			return;
+		}
+
+		// bytes with written pixels
+		for (i = 0; i < 4; i++)
+		{
+			mb = (u8)(m >> 24);
+			if (mb != 0) d[i] = (d[i] & ~mb) | ((u8)(r >> 24) & mb);
+			r <<= 8;
+			m <<= 8;
+		}
+	}
+
+	// planar formats
+	else
+	{
+		wr->d = d + 1;
+		mb = DrawConvGather(m);
+		if (mb == 0) return;
+		n = (wr->format == CANVAS_PLANE2) ? 2 : 4;
+		for (i = 0; i < n; i++)
+		{
+			b = DrawConvGather(r >> i);
+			if (mb != 0xff) b = (*d & ~mb) | (b & mb);
+			*d = b;
+			d += wr->plane;
+		}
+	}
+}
+
+// write next destination pixel (m = pixel mask, 0 = transparent pixel)
+static inline void DrawConvPut(sDrawConvWr* wr, u8 c, u32 m)
+{
+	wr->reg = (wr->reg << wr->bits) | c;
+	wr->msk = (wr->msk << wr->bits) | m;
+	wr->n += wr->bits;
+	if (wr->n == 32) DrawConvStore(wr);
+}
+
+// draw converted image into CANVAS_ATTRIB8 format, select 2 most frequent colors of each cell
+static void DrawConvAttr8(sCanvas* canvas, const sCanvas* src, int xd, int yd, int xs, int ys,
+	int w, int h, const sDrawConv* conv, int key)
+{
+	int wb = canvas->wb;
+	const u8* map = conv->map;
+	const u8* pal = conv->pal;
+	int x, y, x1, x2, cx, cy, i, k, bestnum, best2num;
+	int hist[16];
+	u32 cell[8];
+	u32 r;
+	u16 fg;
+	u8 c, m, mr, out, best, best2;
+	u8* d;
+	u8* a;
+	sDrawConvRd rd;
+
+	// cells are aligned in image (image height is multiple of 8), pixels outside clipping
+	// box are not changed, their colors keep their place in attribute of partially covered cell
+	int bx1, by1, bx2, by2;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+
+	for (cy = yd & ~7; cy < yd + h; cy += 8)
+	{
+		for (cx = xd & ~7; cx < xd + w; cx += 8)
+		{
+			// range of new pixels in the cell
+			x1 = (cx < xd) ? xd : cx;
+			x2 = (cx + 8 > xd + w) ? (xd + w) : (cx + 8);
+
+			// mask of pixels inside clipping box
+			m = 0xff;
+			if (cx < bx1) m >>= bx1 - cx;
+			if (cx + 8 > bx2) m &= (u8)(0xff << (cx + 8 - bx2));
+
+			// get color indices of the cell and histogram of pixels inside clipping box
+			//  out ... bit 0: some pixel outside is background, bit 1: foreground
+			memset(hist, 0, 16*sizeof(int));
+			out = 0;
+			d = canvas->img + cy*wb + cx/8;
+			a = canvas->img2 + (cy/8)*wb + cx/8;
+			for (i = 0; i < 8; i++)
+			{
+				// old pixels
+				r = DrawConvAttr(d[i*wb], *a);
+
+				// new pixels
+				y = cy + i;
+				if ((y >= yd) && (y < yd + h))
+				{
+					DrawConvRdInit(&rd, src, x1 - xd + xs, y - yd + ys);
+					for (x = x1; x < x2; x++)
+					{
+						c = DrawConvGet(&rd);
+						if (c != key)
+						{
+							k = (7 - (x - cx))*4;
+							r = (r & ~((u32)15 << k)) | ((u32)(map[c] & 15) << k);
+						}
+					}
+				}
+
+				cell[i] = r;
+				mr = ((cy + i < by1) || (cy + i >= by2)) ? 0 : m;
+				if ((~d[i*wb] & ~mr & 0xff) != 0) out |= 1;
+				if ((d[i*wb] & ~mr) != 0) out |= 2;
+				for (k = 0; k < 8; k++) if (((mr >> k) & 1) != 0) hist[(r >> (k*4)) & 15]++;
+			}
+
+			// find 1st best color
+			best2 = 0;
+			best2num = 0;
+			for (k = 0; k < 16; k++)
+			{
+				if (hist[k] > best2num)
+				{
+					best2 = (u8)k;
+					best2num = hist[k];
+				}
+			}
+
+			// find 2nd best color
+			best = best2;
+			bestnum = 0;
+			for (k = 0; k < 16; k++)
+			{
+				if ((hist[k] > bestnum) && (k != best2))
+				{
+					best = (u8)k;
+					bestnum = hist[k];
+				}
+			}
+
+			// partially covered cell, keep colors of pixels outside clipping box
+			if (out == 3)
+			{
+				best = *a & 0x0f;
+				best2 = *a >> 4;
+			}
+			else if (out == 2)
+			{
+				if (best2 == (*a & 0x0f)) best2 = best;
+				best = *a & 0x0f;
+			}
+			else if (out == 1)
+			{
+				if (best2 == (*a >> 4)) best2 = best;
+				best = best2;
+				best2 = *a >> 4;
+			}
+
+			// sort colors, 'best' will be brighter (foreground) than 'best2' (background)
+			else if ((pal != NULL) ? (ColDist(pal[best], 0) < ColDist(pal[best2], 0)) : (best < best2))
+			{
+				c = best;
+				best = best2;
+				best2 = c;
+			}
+			*a = (best2 << 4) | best;
+
+			// colors nearer to foreground color
+			fg = 0;
+			for (k = 0; k < 16; k++)
+			{
+				if ((hist[k] > 0) && ((pal != NULL) ?
+					(ColDist(pal[k], pal[best]) < ColDist(pal[k], pal[best2])) : (k == best)))
+					fg |= 1 << k;
+			}
+
+			// write pixels inside clipping box
+			for (i = 0; i < 8; i++)
+			{
+				if ((cy + i < by1) || (cy + i >= by2)) continue;
+				r = cell[i];
+				c = 0;
+				for (k = 28; k >= 0; k -= 4) c = (c << 1) | ((fg >> ((r >> k) & 15)) & 1);
+				d[i*wb] = (d[i*wb] & ~m) | (c & m);
+			}
+		}
+	}
+}
+
+// draw converted image (key = transparency key, -1 = none)
+static void DrawConv(sCanvas* canvas, const sCanvas* src, int xd, int yd, int xs, int ys,
+	int w, int h, const sDrawConv* conv, int key)
+{
+	// mark dirty region
+	CanvasDirty(canvas, xd, yd, w, h);
+
+	// clipping boxes of destination and source, coordinates in images
+	int bx1, by1, bx2, by2, sx1, sy1, sx2, sy2, k;
+	CanvasBox(canvas, &bx1, &by1, &bx2, &by2);
+	CanvasBox(src, &sx1, &sy1, &sx2, &sy2);
+	xd += canvas->ox;
+	yd += canvas->oy;
+	xs += src->ox;
+	ys += src->oy;
+
+	// limit coordinates X
+	if (xd < bx1)
+	{
+		k = bx1 - xd;
+		w -= k;
+		xs += k;
+		xd = bx1;
+	}
+
+	if (xs < sx1)
+	{
+		k = sx1 - xs;
+		w -= k;
+		xd += k;
+		xs = sx1;
+	}
+
+	if (xd + w > bx2) w = bx2 - xd;
+	if (xs + w > sx2) w = sx2 - xs;
+	if (w <= 0) return;
+
+	// limit coordinates Y
+	if (yd < by1)
+	{
+		k = by1 - yd;
+		h -= k;
+		ys += k;
+		yd = by1;
+	}
+
+	if (ys < sy1)
+	{
+		k = sy1 - ys;
+		h -= k;
+		yd += k;
+		ys = sy1;
+	}
+
+	if (yd + h > by2) h = by2 - yd;
+	if (ys + h > sy2) h = sy2 - ys;
+	if (h <= 0) return;
+
+	// attribute format
+	if (canvas->format == CANVAS_ATTRIB8)
+	{
+		DrawConvAttr8(canvas, src, xd, yd, xs, ys, w, h, conv, key);
+		return;
+	}
+
+	// convert rows
+	const u8* map = conv->map;
+	sDrawConvRd rd;
+	sDrawConvWr wr;
+	int i;
+	u8 c;
+	for (; h > 0; h--)
+	{
+		DrawConvRdInit(&rd, src, xs, ys);
+		DrawConvWrInit(&wr, canvas, xd, yd);
+		if (key < 0)
+		{
+			for (i = w; i > 0; i--) DrawConvPut(&wr, map[DrawConvGet(&rd)], wr.pix);
+		}
+		else
+		{
+			for (i = w; i > 0; i--)
+			{
+				c = DrawConvGet(&rd);
+				DrawConvPut(&wr, map[c], (c == key) ? 0 : wr.pix);
+			}
+		}
+		if (wr.n > 0) DrawConvStore(&wr);
+		ys++;
+		yd++;
+	}
+}
+
+// Draw image of different format, pixels are converted by color map
+void DrawImgConv(sCanvas* canvas, const sCanvas* src, int xd, int yd, int xs, int ys, int w, int h,
+	const sDrawConv* conv)
+{
+	DrawConv(canvas, src, xd, yd, xs, ys, w, h, conv, -1);
+}
+
+// Draw image of different format with transparency (col = transparency key, source pixel value)
+void DrawBlitConv(sCanvas* canvas, const sCanvas* src, int xd, int yd, int xs, int ys, int w, int h,
+	const sDrawConv* conv, u8 col)
+{
+	DrawConv(canvas, src, xd, yd, xs, ys, w, h, conv, col);
+}
+
+// pending span of flood fill
+typedef struct {
+	s16	y;	// row to scan
+	s16	xl;	// first pixel of span of parent row
+	s16	xr;	// last pixel of span of parent row
+	s16	dy;	// direction from parent row (+1 or -1)
+} sDrawFillSpan;
+
+// flood fill state
+typedef struct {
+	sCanvas*	canvas;	// destination canvas
+	const u8*	pat;	// 8x8 pattern (NULL = solid fill)
+	const u8*	mask;	// image of mask of filled pixels (NULL = not used)
+	int		maskwb;	// pitch of mask
+	int		plane;	// distance of planes (CANVAS_PLANE2, CANVAS_PLANE4)
+	u32		tw;	// color of region, pattern of 32-bit word (packed formats)
+	u8		tpat[4];// color of region, pattern of byte of planes (pixel bit with CANVAS_ATTRIB8)
+	u8		col;	// fill color
+	u8		bgcol;	// background color of pattern
+	s16		x1, y1, x2, y2; // filled rectangle (inclusive, image coordinates)
+	int		bx1, by1, bx2, by2; // clipping box (image coordinates)
+	int		sp;	// number of pending spans
+	Bool		over;	// stack overflow, some spans were lost
+	sDrawFillSpan	stack[DRAWFILL_STACK]; // pending spans
+} sDrawFill;
+
+// get color of pixel (pixel bit with CANVAS_ATTRIB8 format)
+static u8 DrawFillGet(const sCanvas* canvas, int x, int y)
+{
+	const u8* s = canvas->img + y*canvas->wb;
+	int plane = canvas->img2 - canvas->img;
+	switch (canvas->format)
+	{
+	case CANVAS_8:
+		return s[x];
+
+	case CANVAS_4:
+		return (s[x/2] >> (((x & 1) ^ 1)*4)) & 0x0f;
+
+	case CANVAS_2:
+		return (s[x/4] >> ((3 - (x & 3))*2)) & 3;
+
+	case CANVAS_PLANE2:
+		return ((s[x/8] >> (7 - (x & 7))) & 1) | (((s[x/8 + plane] >> (7 - (x & 7))) & 1) << 1);
+
+	case CANVAS_PLANE4:
+		return ((s[x/8] >> (7 - (x & 7))) & 1) | (((s[x/8 + plane] >> (7 - (x & 7))) & 1) << 1) |
+			(((s[x/8 + 2*plane] >> (7 - (x & 7))) & 1) << 2) | (((s[x/8 + 3*plane] >> (7 - (x & 7))) & 1) << 3);
+
+	// CANVAS_1, CANVAS_ATTRIB8
+	default:
+		return (s[x/8] >> (7 - (x & 7))) & 1;
+	}
+}
+
+// get outside pixels of group of 8 pixels (x = multiple of 8; bit 7 = 1st pixel, bit 1 = not in region)
+static u8 DrawFillOut(const sDrawFill* f, int x, int y)
+{
+	const sCanvas* canvas = f->canvas;
+	int n = f->bx2 - x; // number of valid pixels
+	const u8* s = canvas->img + y*canvas->wb;
+	u8 tp = f->tpat[0];
+	u8 out;
+	u32 v;
+	int i;
+
+	switch (canvas->format)
+	{
+	// 8 pixels in 8 bytes
+	case CANVAS_8:
+		s += x;
+		if ((n >= 8) && (((u32)(uintptr_t)s & 3) == 0) && (*(const u32*)s == f->tw) && (((const u32*)s)[1] == f->tw))
+			out = 0;
+		else
+		{
+			out = 0;
+			for (i = 0; i < 8; i++) out = (out << 1) | (((i >= n) || (s[i] != tp)) ? 1 : 0);
+		}
+		break;
+
+	// 8 pixels in 4 bytes
+	case CANVAS_4:
+		s += x/2;
+		if ((n >= 8) && (((u32)(uintptr_t)s & 3) == 0))
+		{
+			v = *(const u32*)s ^ f->tw;
+			if (v == 0)
+			{
+				out = 0;
+				break;
+			}
+			v = __builtin_bswap32(v);
+		}
+		else
+		{
+			v = 0;
+			for (i = 0; i < 4; i++) v = (v << 8) | ((i*2 < n) ? s[i] : tp);
+			v ^= f->tw;
+		}
+		v |= v >> 2;
+		v |= v >> 1;
+		out = DrawConvGather(v);
+		break;
+
+	// 8 pixels in 2 bytes
+	case CANVAS_2:
+		s += x/4;
+		v = ((u32)s[0] << 8) | ((n > 4) ? s[1] : tp);
+		v ^= f->tw & 0xffff;
+		v = (v | (v >> 1)) & 0x5555;
+		v = (v | (v >> 1)) & 0x3333;
+		v = (v | (v >> 2)) & 0x0f0f;
+		out = (u8)(v | (v >> 4));
+		break;
+
+	// 8 pixels in bytes of planes
+	case CANVAS_PLANE2:
+	case CANVAS_PLANE4:
+		s += x/8;
+		out = (s[0] ^ tp) | (s[f->plane] ^ f->tpat[1]);
+		if (canvas->format == CANVAS_PLANE4)
+			out |= (s[2*f->plane] ^ f->tpat[2]) | (s[3*f->plane] ^ f->tpat[3]);
+		break;
+
+	// CANVAS_1, CANVAS_ATTRIB8, 8 pixels in 1 byte
+	default:
+		out = s[x/8] ^ tp;
+		break;
+	}
+
+	// pixels out of clipping box
+	if (n < 8) out |= 0xff >> n;
+	n = f->bx1 - x;
+	if (n > 0) out |= ~(0xff >> n);
+
+	// already filled pixels
+	if (f->mask != NULL) out |= f->mask[y*f->maskwb + x/8];
+	return out;
+}
+
+// find first pixel out of region, going right from x (returns right edge of box if not found)
+static int DrawFillRight(const sDrawFill* f, int x, int y)
+{
+	int w = f->bx2;
+	u8 out;
+	for (;;)
+	{
+		out = DrawFillOut(f, x & ~7, y) & (0xff >> (x & 7));
+		if (out != 0) break;
+		x = (x & ~7) + 8;
+		if (x >= w) return w;
+	}
+	while ((out & (0x80 >> (x & 7))) == 0) x++;
+	return x;
+}
+
+// find first pixel of region, going right from x up to xr (returns xr+1 if not found)
+static int DrawFillNext(const sDrawFill* f, int x, int y, int xr)
+{
+	u8 in;
+	for (;;)
+	{
+		if (x > xr) return x;
+		in = ~DrawFillOut(f, x & ~7, y) & (0xff >> (x & 7));
+		if (in != 0) break;
+		x = (x & ~7) + 8;
+	}
+	while ((in & (0x80 >> (x & 7))) == 0) x++;
+	return x;
+}
+
+// find leftmost pixel of region, going left from pixel x of region
+static int DrawFillLeft(const sDrawFill* f, int x, int y)
+{
+	u8 out;
+	for (;;)
+	{
+		out = DrawFillOut(f, x & ~7, y) & (u8)(0xff << (7 - (x & 7)));
+		if (out != 0) break;
+		x = (x & ~7) - 1;
+		if (x < f->bx1) return f->bx1;
+	}
+	while ((out & (0x80 >> (x & 7))) == 0) x--;
+	return x + 1;
+}
+
+// fill bits with pattern of bytes (pixels are stored from highest bits of the byte)
+//  d ... destination row
+//  bit ... bit offset of first pixel in the row
+//  n ... number of bits
+//  pat ... pattern of bytes, repeated from start of the row
+//  num ... length of pattern in bytes (1, 2, 4 or 8)
+static void DrawFillPatBits(u8* d, int bit, int n, const u8* pat, int num)
+{
+	int k = bit >> 3;
+	d += k;
+	bit &= 7;
+	num--;
+	u8 m;
+
+	// store start unaligned bits
+	if (bit != 0)
+	{
+		m = 0xff >> bit; // mask of bits to end of byte
+		bit += n;
+		if (bit < 8) m &= ~(0xff >> bit); // mask of end of span
+		*d = (*d & ~m) | (pat[k & num] & m);
+		d++;
+		k++;
+		n = bit - 8; // remaining bits
+		if (n <= 0) return;
+	}
+
+	// store aligned bytes
+	for (bit = n >> 3; bit > 0; bit--) *d++ = pat[k++ & num];
+
+	// store end unaligned bits
+	n &= 7;
+	if (n > 0)
+	{
+		m = ~(0xff >> n); // mask of start of byte
+		*d = (*d & ~m) | (pat[k & num] & m);
+	}
+}
+
+// fill span of flood fill (from x1 to x2 inclusive, image coordinates)
+static void DrawFillSpan(sDrawFill* f, int x1, int x2, int y)
+{
+	sCanvas* canvas = f->canvas;
+	int n = x2 - x1 + 1;
+
+	// update filled rectangle
+	if (x1 < f->x1) f->x1 = x1;
+	if (x2 > f->x2) f->x2 = x2;
+	if (y < f->y1) f->y1 = y;
+	if (y > f->y2) f->y2 = y;
+
+	// mark filled pixels
+	if (f->mask != NULL) DrawFillBits((u8*)f->mask + y*f->maskwb, x1, n, 0xff);
+
+	// solid fill
+	if (f->pat == NULL)
+	{
+		DrawRect(canvas, x1 - canvas->ox, y - canvas->oy, n, 1, f->col);
+		return;
+	}
+
+	// pattern fill
+	u8* d = canvas->img + y*canvas->wb;
+	u8 p = f->pat[y & 7];
+	u8 col = f->col;
+	u8 bgcol = f->bgcol;
+	u8 e[8] = { 0 };
+	int i, k, bits;
+	switch (canvas->format)
+	{
+	// planes
+	case CANVAS_PLANE2:
+	case CANVAS_PLANE4:
+		k = (canvas->format == CANVAS_PLANE2) ? 2 : 4;
+		for (i = 0; i < k; i++)
+		{
+			e[0] = (p & (((col & 1) != 0) ? 0xff : 0)) | (~p & (((bgcol & 1) != 0) ? 0xff : 0));
+			DrawFillBits(d, x1, n, e[0]);
+			col >>= 1;
+			bgcol >>= 1;
+			d += f->plane;
 		}
 		break;
 
-	// 4 colors on 2 planes
-	case CANVAS_PLANE2:
+	// pixels are pattern bits, attributes are pattern colors
+	case CANVAS_ATTRIB8:
+		DrawFillBits(d, x1, n, p);
+		d = canvas->img2 + (y/8)*canvas->wb;
+		for (i = x1/8; i <= x2/8; i++) d[i] = (bgcol << 4) | (col & 0x0f);
+		break;
+
+	// packed pixels, pattern of 8 pixels takes 'bits' bytes
+	default:
+		bits = 8 >> canvas->format;
+		for (i = 0; i < 8; i++)
 		{
-			int wbd = canvas->wb;
-			int wbs = src->wb;
-			u8* d = canvas->img + xd/8 + yd*wbd;
-			u8* d2 = canvas->img2 + xd/8 + yd*wbd;
-			u8* s = src->img + xs/8 + ys*wbs;
-			u8* s2 = src->img2 + xs/8 + ys*wbs;
-			u8* d0;
-			u8* d02;
-			u8* s0;
-			u8* s02;
-			u8 b, b1, b12, b2, bb, bb2, ms, md;
-			int i, rs, rd, xs2, xd2;
-			
-			for (; h > 0; h--)
-			{
-				d0 = d;
-				d02 = d2;
-				s0 = s;
-				s02 = s2;
-				i = w;
-				b = *s; // source sample
-				bb = *s2;
-				s++;
-				s2++;
-				b2 = *d; // destination sample
-				bb2 = *d2;
+			k = (((p << i) & 0x80) != 0) ? col : bgcol;
+			e[i*bits/8] = (e[i*bits/8] << bits) | (k & ((1 << bits) - 1));
+		}
+		DrawFillPatBits(d, x1*bits, n*bits, e, bits);
+		break;
+	}
+}
 
-				rs = 7 - (xs & 0x07); // source shift 0..7 -> 7..0
-				rd = (xd & 0x07); // destination shift 0..7
+// push pending span of flood fill
+static void DrawFillPush(sDrawFill* f, int y, int xl, int xr, int dy)
+{
+	if ((y < f->by1) || (y >= f->by2)) return;
+	if (f->sp >= DRAWFILL_STACK)
+	{
+		f->over = True;
+		return;
+	}
+	sDrawFillSpan* s = &f->stack[f->sp++];
+	s->y = (s16)y;
+	s->xl = (s16)xl;
+	s->xr = (s16)xr;
+	s->dy = (s16)dy;
+}
 
-				for (; i > 0; i--)
-				{
-					// move source pixel to destination
-					b1 = (b >> rs) & 0x01;
-					b12 = (bb >> rs) & 0x01;
-					if ((b1 | (b12<<1)) != col)
-					{
-						b2 = (b2 & ~(0x80 >> rd)) | (b1 << (7 - rd));
-						bb2 = (bb2 & ~(0x80 >> rd)) | (b12 << (7 - rd));
-					}
+// flood fill from seed pixel (seed must be in region, returns False on stack overflow)
+static Bool DrawFillRun(sDrawFill* f, int x, int y)
+{
+	int xl, xr, dy, l, r;
+	sDrawFillSpan* s;
+
+	// fill seed span, continue up and down
+	f->sp = 0;
+	f->over = False;
+	l = DrawFillLeft(f, x, y);
+	r = DrawFillRight(f, x, y) - 1;
+	DrawFillSpan(f, l, r, y);
+	DrawFillPush(f, y + 1, l, r, 1);
+	DrawFillPush(f, y - 1, l, r, -1);
+
+	while (f->sp > 0)
+	{
+		// pop span
+		s = &f->stack[--f->sp];
+		y = s->y;
+		xl = s->xl;
+		xr = s->xr;
+		dy = s->dy;
+
+		// spans of region adjacent to parent span
+		x = DrawFillNext(f, xl, y, xr);
+		if (x > xr) continue;
+		l = (x == xl) ? DrawFillLeft(f, x, y) : x;
+		for (;;)
+		{
+			r = DrawFillRight(f, x, y) - 1;
+			DrawFillSpan(f, l, r, y);
+
+			// continue in the same direction, check parent row where span overhangs parent span
+			DrawFillPush(f, y + dy, l, r, dy);
+			if (l < xl) DrawFillPush(f, y - dy, l, xl - 1, -dy);
+			if (r > xr) DrawFillPush(f, y - dy, xr + 1, r, -dy);
+
+			// next span
+			x = DrawFillNext(f, r + 2, y, xr);
+			if (x > xr) break;
+			l = x;
+		}
+	}
+	return !f->over;
+}
 
-					rs--;
-					if (rs < 0)
-					{
-						rs = 7;
-						b = *s++;
-						bb = *s2++;
-					}
+// prepare flood fill (seed in image coordinates, returns False if seed is out of clipping box)
+static Bool DrawFillInit(sDrawFill* f, sCanvas* canvas, int x, int y, const u8* pat, u8 col, u8 bgcol)
+{
+	CanvasBox(canvas, &f->bx1, &f->by1, &f->bx2, &f->by2);
+	if ((x < f->bx1) || (x >= f->bx2) || (y < f->by1) || (y >= f->by2)) return False;
+
+	f->canvas = canvas;
+	f->pat = pat;
+	f->mask = NULL;
+	f->maskwb = 0;
+	f->plane = canvas->img2 - canvas->img;
+	f->col = col;
+	f->bgcol = bgcol;
+	f->x1 = f->y1 = 0x7fff;
+	f->x2 = f->y2 = -1;
+
+	// color of region
+	u8 t = DrawFillGet(canvas, x, y);
+	u8 b;
+	int i;
+	switch (canvas->format)
+	{
+	case CANVAS_8:
+		b = t;
+		break;
 
-					rd++;
-					if (rd >= 8)
-					{
-						rd = 0;
-						*d++ = b2;
-						b2 = *d;
-						*d2++ = bb2;
-						bb2 = *d2;
-					}
-				}
+	case CANVAS_4:
+		b = t*0x11;
+		break;
 
-				if (rd != 0)
-				{
-					*d = b2;
-					*d2 = bb2;
-				}
+	case CANVAS_2:
+		b = t*0x55;
+		break;
 
-				d = d0 + wbd;
-				s = s0 + wbs;
-				d2 = d02 + wbd;
-				s2 = s02 + wbs;
-			}
-		}
+	case CANVAS_PLANE2:
+	case CANVAS_PLANE4:
+		for (i = 0; i < 4; i++) f->tpat[i] = (((t >> i) & 1) != 0) ? 0xff : 0;
+		b = f->tpat[0];
+		break;
+
+	// CANVAS_1, CANVAS_ATTRIB8
+	default:
+		b = (t != 0) ? 0xff : 0;
 		break;
 	}
+	f->tpat[0] = b;
+	f->tw = (u32)b*0x01010101;
+	return True;
+}
+
+// color masked to pixel of the canvas
+static u8 DrawFillCol(const sCanvas* canvas, u8 col)
+{
+	switch (canvas->format)
+	{
+	case CANVAS_8: return col;
+	case CANVAS_2:
+	case CANVAS_PLANE2: return col & 3;
+	case CANVAS_1: return col & 1;
+	default: return col & 0x0f;
+	}
+}
+
+// flood fill (fill 4-connected region of pixels with the same color as seed pixel)
+Bool DrawFill(sCanvas* canvas, int x, int y, u8 col)
+{
+	sDrawFill f;
+	x += canvas->ox;
+	y += canvas->oy;
+	if (!DrawFillInit(&f, canvas, x, y, NULL, col, 0)) return True;
+	u8 t = DrawFillGet(canvas, x, y);
+
+	// attributes: invert pixels of region, new side gets the color
+	if (canvas->format == CANVAS_ATTRIB8)
+		f.col = (col & 0x0f) | ((t != 0) ? B4 : 0);
+
+	// region has already this color
+	else if (DrawFillCol(canvas, col) == t)
+		return True;
+
+	// fill region (dirty region is marked once at the end)
+	sDirty* dirty = canvas->dirty;
+	canvas->dirty = NULL;
+	Bool ok = DrawFillRun(&f, x, y);
+	canvas->dirty = dirty;
+	CanvasDirty(canvas, f.x1 - canvas->ox, f.y1 - canvas->oy, f.x2 - f.x1 + 1, f.y2 - f.y1 + 1);
+	return ok;
+}
+
+// flood fill with 8x8 pattern
+Bool DrawFillPat(sCanvas* canvas, int x, int y, const u8* pat, u8 col, u8 bgcol, sCanvas* mask /* = NULL */)
+{
+	sDrawFill f;
+	x += canvas->ox;
+	y += canvas->oy;
+	if (!DrawFillInit(&f, canvas, x, y, pat, col, bgcol)) return True;
+	u8 t = DrawFillGet(canvas, x, y);
+
+	// check if pattern uses color of region
+	int i;
+	Bool fg = False;
+	Bool bg = False;
+	for (i = 0; i < 8; i++)
+	{
+		if (pat[i] != 0) fg = True;
+		if (pat[i] != 0xff) bg = True;
+	}
+	if ((canvas->format == CANVAS_ATTRIB8) ||
+		(fg && (DrawFillCol(canvas, col) == t)) ||
+		(bg && (DrawFillCol(canvas, bgcol) == t)))
+	{
+		// filled pixels must be marked in the mask
+		if (mask == NULL) return False;
+		memset(mask->img + f.by1*mask->wb, 0, (f.by2 - f.by1)*mask->wb);
+		f.mask = mask->img;
+		f.maskwb = mask->wb;
+	}
+
+	// fill region (dirty region is marked once at the end)
+	sDirty* dirty = canvas->dirty;
+	canvas->dirty = NULL;
+	Bool ok = DrawFillRun(&f, x, y);
+	canvas->dirty = dirty;
+	CanvasDirty(canvas, f.x1 - canvas->ox, f.y1 - canvas->oy, f.x2 - f.x1 + 1, f.y2 - f.y1 + 1);
+	return ok;
+}
+
+// get 1-bit canvas of one plane of CANVAS_PLANE2 or CANVAS_PLANE4 format
+void CanvasPlane(sCanvas* dst, const sCanvas* canvas, int plane)
+{
+	*dst = *canvas; // size, origin, clipping and dirty region are shared
+	dst->img = canvas->img + plane*(canvas->img2 - canvas->img);
+	dst->img2 = NULL;
+	dst->format = CANVAS_1;
 }
 
 // draw 8-bit image with 2D transformation matrix
@@ -1800,51 +3528,56 @@ void DrawBlit(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int
 //  mode ... draw mode DRAWIMG_*
 //  color ... key or border color (DRAWIMG_PERSP mode: horizon offset)
 // Note to wrap and perspective mode: Width and height of source image must be power of 2!
-void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
-	const cMat2Df* m, u8 mode, u8 color)
+static void DrawImgMatInt(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
+	const int* m, u8 mode, u8 color)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x, y, w, h);
+
 	// check 8-bit image format
 	if ((canvas->format != CANVAS_8) || (src->format != CANVAS_8)) return;
 
-	// limit x
+	// limit x (clipping box in canvas coordinates)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
 	int x0 = -w/2; // start X coordinate
-	if (x < 0)
+	if (x < bx1)
 	{
-		w += x;
-		x0 -= x;
-		x = 0;
+		w -= bx1 - x;
+		x0 += bx1 - x;
+		x = bx1;
 	}
-	if (x + w > canvas->w) w = canvas->w - x;
+	if (x + w > bx2) w = bx2 - x;
 	if (w <= 0) return;
 
 	// limit y
 	int h0 = h;
 	int y0 = (mode == DRAWIMG_PERSP) ? (-h) : (-h/2); // start Y coordinate
-	if (y < 0)
+	if (y < by1)
 	{
-		h += y;
-		y0 -= y;
-		y = 0;
+		h -= by1 - y;
+		y0 += by1 - y;
+		y = by1;
 	}
-	if (y + h > canvas->h) h = canvas->h - y;
+	if (y + h > by2) h = by2 - y;
 	if (h <= 0) return;
 
-	// load transformation matrix and convert to integer fractional number
-	int m11 = (int)(m->m11*FRACTMUL+0.5f);
-	int m12 = (int)(m->m12*FRACTMUL+0.5f);
-	int m13 = (int)(m->m13*FRACTMUL+0.5f);
-	int m21 = (int)(m->m21*FRACTMUL+0.5f);
-	int m22 = (int)(m->m22*FRACTMUL+0.5f);
-	int m23 = (int)(m->m23*FRACTMUL+0.5f);
+	// load integer transformation matrix
+	int m11 = m[0];
+	int m12 = m[1];
+	int m13 = m[2];
+	int m21 = m[3];
+	int m22 = m[4];
+	int m23 = m[5];
 
 	// zero size image
 	if ((m11 == 0) || (m22 == 0)) return;
 
 	// prepare variables
 	int wbs = src->wb; // source width bytes
-	const u8* s = src->img; // source image
+	const u8* s = src->img + src->ox + src->oy*wbs; // source image
 	int xy0m, yy0m; // temporary Y members
-	u8* d = canvas->img + canvas->wb*y + x; // destination image
+	u8* d = canvas->img + canvas->wb*(y + canvas->oy) + x + canvas->ox; // destination image
 	int wbd = canvas->wb - w; // destination width bytes
 	int i, x2, y2;
 
@@ -1870,7 +3603,7 @@ void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
 		interp_config_set_mask(&cfg, xbits, xbits+ybits-1); // set y mask, multiply * width
 		interp_set_config(interp0, 1, &cfg); // configure lane 1
 
-		interp0->base[2] = (u32)s; // image base
+		interp0->base[2] = (u32)(uintptr_t)s; // image base
 
 		for (; h > 0; h--)
 		{
@@ -1949,8 +3682,8 @@ void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
 	else if (mode == DRAWIMG_CLAMP)
 	{
 		// source image dimension
-		u32 ww = src->w - 1;
-		u32 hh = src->h - 1;
+		int ww = src->w - 1;
+		int hh = src->h - 1;
 
 		for (; h > 0; h--)
 		{
@@ -2055,7 +3788,7 @@ void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
 		interp_config_set_mask(&cfg, xbits, xbits+ybits-1); // set y mask, multiply * width
 		interp_set_config(interp0, 1, &cfg); // configure lane 1
 
-		interp0->base[2] = (u32)s; // image base
+		interp0->base[2] = (u32)(uintptr_t)s; // image base
 
 		for (; h > 0; h--)
 		{
@@ -2117,6 +3850,235 @@ void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
 	}
 }
 
+// draw 8-bit image with 2D transformation matrix
+void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
+	const cMat2Df* m, u8 mode, u8 color)
+{
+	// convert to integer fractional number
+	int mat[6];
+	mat[0] = (int)(m->m11*FRACTMUL+0.5f);
+	mat[1] = (int)(m->m12*FRACTMUL+0.5f);
+	mat[2] = (int)(m->m13*FRACTMUL+0.5f);
+	mat[3] = (int)(m->m21*FRACTMUL+0.5f);
+	mat[4] = (int)(m->m22*FRACTMUL+0.5f);
+	mat[5] = (int)(m->m23*FRACTMUL+0.5f);
+	DrawImgMatInt(canvas, src, x, y, w, h, mat, mode, color);
+}
+
+// draw 8-bit image with fixed-point 2D transformation matrix
+void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
+	const cMat2Di* m, u8 mode, u8 color)
+{
+	DrawImgMatInt(canvas, src, x, y, w, h, m->Int(), mode, color);
+}
+
+// floor of integer division (b > 0)
+static inline int DrawFloorDiv(int a, int b)
+{
+	return (a >= 0) ? (a/b) : -((b - 1 - a)/b);
+}
+
+// limit range of pixels i0..i1-1 to source coordinates 0 <= v + i*dv < max
+static void DrawImgRange(int v, int dv, int max, int* i0, int* i1)
+{
+	int a, b;
+	if (dv > 0)
+	{
+		a = -DrawFloorDiv(v, dv); // first i with v + i*dv >= 0
+		b = -DrawFloorDiv(v - max, dv); // first i with v + i*dv >= max
+	}
+	else if (dv < 0)
+	{
+		a = DrawFloorDiv(v - max, -dv) + 1; // first i with v + i*dv < max
+		b = DrawFloorDiv(v, -dv) + 1; // first i with v + i*dv < 0
+	}
+	else
+	{
+		if ((v >= 0) && (v < max)) return;
+		a = b = 0;
+	}
+	if (a > *i0) *i0 = a;
+	if (b < *i1) *i1 = b;
+}
+
+// draw transformed image in DRAWIMG_NOBORDER or DRAWIMG_TRANSP mode, rows clipped to source image
+//  hw ... interpolator is prepared for this source image
+static void DrawImgMatClip(sCanvas* canvas, const sDrawImgItem* item, Bool hw)
+{
+	// limit x (clipping box in canvas coordinates)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+	int x = item->x;
+	int w = item->w;
+	int x0 = -w/2; // start X coordinate
+	if (x < bx1)
+	{
+		w -= bx1 - x;
+		x0 += bx1 - x;
+		x = bx1;
+	}
+	if (x + w > bx2) w = bx2 - x;
+	if (w <= 0) return;
+
+	// limit y
+	int y = item->y;
+	int h = item->h;
+	int y0 = -h/2; // start Y coordinate
+	if (y < by1)
+	{
+		h -= by1 - y;
+		y0 += by1 - y;
+		y = by1;
+	}
+	if (y + h > by2) h = by2 - y;
+	if (h <= 0) return;
+
+	// load integer transformation matrix
+	const int* m = item->mat;
+	int m11 = m[0];
+	int m12 = m[1];
+	int m13 = m[2];
+	int m21 = m[3];
+	int m22 = m[4];
+	int m23 = m[5];
+
+	// zero size image
+	if ((m11 == 0) || (m22 == 0)) return;
+
+	// prepare variables
+	const sCanvas* src = item->src;
+	int ww = src->w << FRACT; // source width in fractional units
+	int hh = src->h << FRACT; // source height in fractional units
+	int wbs = src->wb; // source width bytes
+	const u8* s = src->img + src->ox + src->oy*wbs; // source image
+	u8* d0 = canvas->img + canvas->wb*(y + canvas->oy) + x + canvas->ox; // destination image
+	int wbd = canvas->wb; // destination pitch
+	Bool transp = (item->mode == DRAWIMG_TRANSP);
+	u8 key = item->color;
+	int i0, i1, xy0m, yy0m;
+	u8* d;
+	u8 c;
+
+	for (; h > 0; h--)
+	{
+		// range of pixels inside source image
+		xy0m = x0*m11 + y0*m12 + m13;
+		yy0m = x0*m21 + y0*m22 + m23;
+		i0 = 0;
+		i1 = w;
+		DrawImgRange(xy0m, m11, ww, &i0, &i1);
+		DrawImgRange(yy0m, m21, hh, &i0, &i1);
+
+		if (i0 < i1)
+		{
+			d = d0 + i0;
+			xy0m += i0*m11;
+			yy0m += i0*m21;
+			i1 -= i0;
+
+#if DRAW_HWINTER // 1=use hardware interpolator to draw images
+			if (hw)
+			{
+				interp0->accum[0] = xy0m;
+				interp0->base[0] = m11;
+				interp0->accum[1] = yy0m;
+				interp0->base[1] = m21;
+
+				if (transp)
+				{
+					for (; i1 > 0; i1--)
+					{
+						c = *(u8*)interp0->pop[2];
+						if (c != key) *d = c;
+						d++;
+					}
+				}
+				else
+				{
+					for (; i1 > 0; i1--) *d++ = *(u8*)interp0->pop[2];
+				}
+			}
+			else
+#endif
+			{
+				for (; i1 > 0; i1--)
+				{
+					c = s[(xy0m>>FRACT) + (yy0m>>FRACT)*wbs];
+					if (!transp || (c != key)) *d = c;
+					d++;
+					xy0m += m11; // x0*m11
+					yy0m += m21; // x0*m21
+				}
+			}
+		}
+
+		y0++;
+		d0 += wbd;
+	}
+}
+
+// draw batch of 8-bit images with 2D transformation matrix
+void DrawImgMatBatch(sCanvas* canvas, const sDrawImgItem* item, int num)
+{
+	int i;
+
+	// mark dirty region
+	const sDrawImgItem* it;
+	for (i = 0, it = item; i < num; i++, it++) CanvasDirty(canvas, it->x, it->y, it->w, it->h);
+
+	// check 8-bit image format
+	if (canvas->format != CANVAS_8) return;
+
+	const sCanvas* cur = NULL; // source image prepared in interpolator
+	Bool hw = False;
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
+	for (i = 0, it = item; i < num; i++, it++)
+	{
+		const sCanvas* src = it->src;
+		if (src->format != CANVAS_8) continue;
+
+		// other modes
+		if ((it->mode != DRAWIMG_NOBORDER) && (it->mode != DRAWIMG_TRANSP))
+		{
+			DrawImgMatInt(canvas, src, it->x, it->y, it->w, it->h, it->mat, it->mode, it->color);
+			cur = NULL; // interpolator may be reconfigured
+			continue;
+		}
+
+		// skip image out of clipping box
+		if ((it->x >= bx2) || (it->y >= by2) ||
+			(it->x + it->w <= bx1) || (it->y + it->h <= by1)) continue;
+
+#if DRAW_HWINTER // 1=use hardware interpolator to draw images
+		// prepare hardware interpolator on change of source image
+		if (src != cur)
+		{
+			cur = src;
+			int wbbits = 0;
+			while ((1<<wbbits) < src->wb) wbbits++; // get number of bits of image pitch
+			hw = ((1<<wbbits) == src->wb) && (wbbits <= FRACT);
+			if (hw)
+			{
+				interp_config cfg = interp_default_config();
+				interp_config_set_add_raw(&cfg, true); // add raw lane base back to accumulator
+				interp_config_set_shift(&cfg, FRACT); // shift fraction bits out
+				interp_config_set_mask(&cfg, 0, (wbbits > 0) ? (wbbits-1) : 0); // x mask (coordinates are clipped)
+				interp_set_config(interp0, 0, &cfg); // configure lane 0
+
+				interp_config_set_shift(&cfg, FRACT - wbbits); // shift fraction bits out, to multiply * pitch
+				interp_config_set_mask(&cfg, wbbits, 31); // y mask, multiply * pitch
+				interp_set_config(interp0, 1, &cfg); // configure lane 1
+
+				interp0->base[2] = (u32)(uintptr_t)(src->img + src->ox + src->oy*src->wb); // image base
+			}
+		}
+#endif
+
+		DrawImgMatClip(canvas, it, hw);
+	}
+}
+
 // draw tile map using perspective projection
 //  canvas ... destination canvas
 //  src ... source canvas with column of 8-bit square tiles (width = tile size, must be power of 2)
@@ -2130,44 +4092,45 @@ void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
 //  h ... destination height
 //  mat ... transformation matrix (should be prepared using PrepDrawPersp function)
 //  horizon ... horizon offset (0=do not use perspective projection)
-void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbits, int maphbits,
-	int tilebits, int x, int y, int w, int h, const cMat2Df* mat, u8 horizon)
+static void DrawTileMapInt(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbits, int maphbits,
+	int tilebits, int x, int y, int w, int h, const int* m, u8 horizon)
 {
+	// mark dirty region
+	CanvasDirty(canvas, x, y, w, h);
+
 	// check 8-bit image format
 	if ((canvas->format != CANVAS_8) || (src->format != CANVAS_8)) return;
 
-	// limit x
+	// limit x (clipping box in canvas coordinates)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
 	int x0 = -w/2; // start X coordinate
-	if (x < 0)
+	if (x < bx1)
 	{
-		w += x;
-		x0 -= x;
-		x = 0;
+		w -= bx1 - x;
+		x0 += bx1 - x;
+		x = bx1;
 	}
-	if (x + w > canvas->w) w = canvas->w - x;
+	if (x + w > bx2) w = bx2 - x;
 	if (w <= 0) return;
 
 	// limit y
 	int h0 = h;
 	int y0 = (horizon == 0) ? (-h/2) : (-h); // start Y coordinate
-	if (y < 0)
+	if (y < by1)
 	{
-		h += y;
-		y0 -= y;
-		y = 0;
+		h -= by1 - y;
+		y0 += by1 - y;
+		y = by1;
 	}
-	if (y + h > canvas->h) h = canvas->h - y;
+	if (y + h > by2) h = by2 - y;
 	if (h <= 0) return;
 
-	// load transformation matrix and convert to integer fractional number
-	int m[6];
-	mat->ExportInt(m);
-
 	// prepare variables
 	int wbs = src->wb; // source width bytes
-	const u8* s = src->img; // source image
+	const u8* s = src->img + src->ox + src->oy*wbs; // source image
 	int xy0m, yy0m; // temporary Y members
-	u8* d = canvas->img + canvas->wb*y + x; // destination image
+	u8* d = canvas->img + canvas->wb*(y + canvas->oy) + x + canvas->ox; // destination image
 	int wbd = canvas->wb - w; // destination width bytes
 	int i, x2, y2;
 	int tilesize = 1 << tilebits; // tile size
@@ -2194,7 +4157,7 @@ void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbit
 	interp_config_set_mask(&cfg, mapwbits, mapwbits+maphbits-1);
 	interp_set_config(interp0, 1, &cfg);
 
-	interp0->base[2] = (u32)map; // map base
+	interp0->base[2] = (u32)(uintptr_t)map; // map base
 
 	// prepare hardware interpolator 1 to get pixel index
 	interp_config_set_shift(&cfg, FRACT); // shift to get pixel index X
@@ -2205,7 +4168,7 @@ void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbit
 	interp_config_set_mask(&cfg, tilebits, tilebits2-1);
 	interp_set_config(interp1, 1, &cfg);
 
-	interp1->base[2] = (u32)s; // tile image
+	interp1->base[2] = (u32)(uintptr_t)s; // tile image
 
 #endif // DRAW_HWINTER
 
@@ -2279,6 +4242,23 @@ void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbit
 	}
 }
 
+// draw tile map using perspective projection
+void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbits, int maphbits,
+	int tilebits, int x, int y, int w, int h, const cMat2Df* mat, u8 horizon)
+{
+	// convert to integer fractional number
+	int m[6];
+	mat->ExportInt(m);
+	DrawTileMapInt(canvas, src, map, mapwbits, maphbits, tilebits, x, y, w, h, m, horizon);
+}
+
+// draw tile map using perspective projection, with fixed-point matrix
+void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbits, int maphbits,
+	int tilebits, int x, int y, int w, int h, const cMat2Di* mat, u8 horizon)
+{
+	DrawTileMapInt(canvas, src, map, mapwbits, maphbits, tilebits, x, y, w, h, mat->Int(), horizon);
+}
+
 // draw image line interpolated
 //  canvas = destination canvas (8-bit pixel format)
 //  src = source canvas (source image in 8-bit pixel format)
@@ -2289,10 +4269,15 @@ void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbit
 // Overflow in X direction is not checked!
 void DrawImgLine(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int wd, int ws)
 {
+	// mark dirty region
+	CanvasDirty(canvas, xd, yd, wd, 1);
+
 	// some base checks (but not all, X is not checked!)
+	int bx1, by1, bx2, by2;
+	CanvasClipBox(canvas, &bx1, &by1, &bx2, &by2);
 	if ((wd <= 0) || (ws <= 0) ||
 		(canvas->format != CANVAS_8) || (src->format != CANVAS_8) ||
-		(yd < 0) || (yd >= canvas->h) ||
+		(yd < by1) || (yd >= by2) ||
 		(ys < 0) || (ys >= src->h)) return;
 
 	// pixel increment
@@ -2301,8 +4286,8 @@ void DrawImgLine(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys,
 	// prepare buffers
 	int wbd = canvas->wb; // destination width bytes
 	int wbs = src->wb; // source width bytes
-	u8* d = canvas->img + xd + yd*wbd; // destination address
-	u8* s = src->img + xs + ys*wbs; // source address
+	u8* d = canvas->img + xd + canvas->ox + (yd + canvas->oy)*wbd; // destination address
+	u8* s = src->img + xs + src->ox + (ys + src->oy)*wbs; // source address
 	int i, j;
 
 #if DRAW_HWINTER // 1=use hardware interpolator to draw images
@@ -2316,7 +4301,7 @@ void DrawImgLine(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys,
 	interp0->accum[0] = 0; // base source
 	cfg = interp_default_config(); // get default configuration
 	interp_set_config(interp0, 1, &cfg); // configure lane 1
-	interp0->base[2] = (u32)s; // image base
+	interp0->base[2] = (u32)(uintptr_t)s; // image base
 
 	for (i = 0; i < wd; i++)
 	{
@@ -20,17 +20,109 @@
 #define CANVAS_ATTRIB8	5	// 2x4 bit color attributes per 8x8 pixel sample
 				//  draw functions:	bit 0..3 = draw color
 				//			bit 4 = draw color is background color
+#define CANVAS_PLANE4	6	// 16 colors on 4 planes (planes follow at distance img2-img)
+
+// dirty region tracking
+#define DIRTY_MAX	16	// max. number of dirty rectangles
+#define DIRTY_WASTE	512	// max. number of clean pixels added by merging two rectangles
+
+// DMA channels (after VGA driver and oscilloscope capture OSCCAP_DMA*)
+#ifndef CANVAS_DMA
+#define CANVAS_DMA	(VGA_DMA_LAST+3) // DMA channel - copy rows of dirty regions
+#endif
+#ifndef CANVAS_DMA_CB
+#define CANVAS_DMA_CB	(CANVAS_DMA+1) // DMA channel - control block, load next row to CANVAS_DMA
+#endif
+#define CANVAS_DMAMIN	64	// min. length of row in bytes to be copied by DMA
+#define CANVAS_DMAROWS	32	// max. number of rows in one list of chained DMA transfers
+
+#define CANVAS_CLIPMAX	4	// max. number of clipping rectangles in stack
+
+#define DRAWPOLY_MAX	32	// max. number of vertices of filled polygon
+
+#ifndef DRAWFILL_STACK
+#define DRAWFILL_STACK	64	// max. number of pending spans of flood fill
+#endif
+
+// dirty rectangle
+typedef struct {
+	s16	x1;	// left coordinate
+	s16	y1;	// top coordinate
+	s16	x2;	// right coordinate (exclusive)
+	s16	y2;	// bottom coordinate (exclusive)
+} sDirtyRect;
+
+// dirty region (last changed rectangle is at the end of the list, image coordinates)
+typedef struct {
+	int	num;	// number of dirty rectangles
+	sDirtyRect rect[DIRTY_MAX]; // list of dirty rectangles
+} sDirty;
 
 // canvas descriptor
 typedef struct {
 	u8*	img;	// image data
-	u8*	img2;	// image data 2 (2nd plane of CANVAS_PLANE2, attributes of CANVAS_ATTRIB8)
+	u8*	img2;	// image data 2 (2nd plane of CANVAS_PLANE2 or CANVAS_PLANE4, attributes of CANVAS_ATTRIB8)
 	int	w;	// width
 	int	h;	// height
 	int	wb;	// pitch (bytes between lines)
 	u8	format;	// canvas format CANVAS_*
+	sDirty*	dirty;	// dirty region updated by draw functions (NULL = not tracked)
+	int	ox;	// X origin of canvas in image (sub-canvas view, 0 = whole image)
+	int	oy;	// Y origin of canvas in image (sub-canvas view, 0 = whole image)
+	int	clipnum; // number of clipping rectangles in stack (0 = clipped by canvas size only)
+	sDirtyRect clip[CANVAS_CLIPMAX]; // stack of clipping rectangles, in image coordinates
 } sCanvas;
 
+// Sub-canvas views and clipping: Canvas coordinates are relative to canvas origin
+// (ox, oy) in the image. Draw functions clip the spans by canvas size and by the
+// clipping rectangle on top of the stack. Canvases with zeroed origin and clipping
+// fields are whole images, as before - initialize new canvas with CanvasInit.
+
+// initialize canvas of whole image (no origin, no clipping, dirty region is not tracked)
+//  canvas ... canvas descriptor
+//  format ... canvas format CANVAS_*
+//  w, h ... size of image
+//  wb ... pitch (bytes between lines)
+//  img ... image data
+//  img2 ... image data 2 (NULL = 2nd plane or attributes follow image data, at img + wb*h)
+void CanvasInit(sCanvas* canvas, u8 format, int w, int h, int wb, u8* img, u8* img2 = NULL);
+
+// create sub-canvas view of rectangle of canvas (view uses image of canvas, nothing is copied)
+//  view ... destination descriptor of view
+//  canvas ... parent canvas (or other view)
+//  x, y ... origin of view in parent canvas (any pixel, also in middle of byte of 4/2/1-bit formats)
+//  w, h ... size of view
+// View is clipped by current clipping of parent canvas, and it shares its dirty region.
+// If view is not inside clipping of parent, parent clipping takes 1st entry of the stack.
+void CanvasView(sCanvas* view, const sCanvas* canvas, int x, int y, int w, int h);
+
+// push clipping rectangle (intersection with current clipping; returns False if stack is full)
+Bool CanvasClipPush(sCanvas* canvas, int x, int y, int w, int h);
+
+// pop clipping rectangle
+void CanvasClipPop(sCanvas* canvas);
+
+// start tracking of dirty region (NULL = stop tracking), whole canvas is marked as dirty
+void CanvasDirtyOn(sCanvas* canvas, sDirty* dirty);
+
+// clear dirty region
+void CanvasDirtyClear(sCanvas* canvas);
+
+// add rectangle to dirty region (negative w or h = rectangle lies to the left or up)
+void CanvasDirtyAdd(sCanvas* canvas, int x, int y, int w, int h);
+
+// mark rectangle as dirty, if dirty region is tracked
+inline void CanvasDirty(sCanvas* canvas, int x, int y, int w, int h)
+	{ if (canvas->dirty != NULL) CanvasDirtyAdd(canvas, x, y, w, h); }
+
+// copy dirty region of back canvas to displayed canvas and clear it (returns number of copied bytes)
+//  dst ... displayed canvas (same format and size as back canvas, can have different pitch)
+//  src ... back canvas with tracked dirty region
+// Both canvases must be identical out of dirty region - rows are rounded to 32-bit
+// words. Rows from CANVAS_DMAMIN bytes are copied by DMA channel CANVAS_DMA, chained
+// by control channel CANVAS_DMA_CB, up to CANVAS_DMAROWS rows without CPU service.
+int CanvasPresent(sCanvas* dst, sCanvas* src);
+
 // Draw rectangle
 void DrawRect(sCanvas* canvas, int x, int y, int w, int h, u8 col);
 
@@ -72,6 +164,22 @@ void DrawFillCircle(sCanvas* canvas, int x0, int y0, int r, u8 col, u8 mask=0xff
 //         . B5|B6 .
 void DrawCircle(sCanvas* canvas, int x0, int y0, int r, u8 col, u8 mask=0xff);
 
+// Draw filled polygon (even-odd rule, polygon can be concave or self-intersecting)
+//  xy ... list of vertices X0,Y0,X1,Y1,... (coordinates must be in range -8191..+8191)
+//  n ... number of vertices 3..DRAWPOLY_MAX (polygon with more vertices is not drawn)
+//  col ... color
+//     col with CANVAS_ATTRIB8 format: bit 0..3 = draw color, bit 4 = draw color is background color
+// Pixels with center inside the polygon are filled, so polygons with common edge do not overlap.
+void DrawFillPoly(sCanvas* canvas, const s16* xy, int n, u8 col);
+
+// Draw filled triangle (coordinates must be in range -8191..+8191)
+void DrawFillTriangle(sCanvas* canvas, int x1, int y1, int x2, int y2, int x3, int y3, u8 col);
+
+// Draw Gouraud shaded triangle (color index is interpolated between vertex colors c1..c3)
+//  Use with palette of color gradient. Fast with CANVAS_8 format, slow with other formats.
+void DrawGouraudTriangle(sCanvas* canvas, int x1, int y1, u8 c1, int x2, int y2, u8 c2,
+	int x3, int y3, u8 c3);
+
 // Draw text (transparent background)
 //   font = pointer to 1-bit font
 void DrawText(sCanvas* canvas, const char* text, int x, int y, u8 col,
@@ -89,6 +197,64 @@ void DrawImg(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int
 //  CANVAS_ATTRIB8 format replaced by DrawImg function
 void DrawBlit(sCanvas* canvas, sCanvas* src, int xd, int yd, int xs, int ys, int w, int h, u8 col);
 
+// color map of cross-format blit
+typedef struct {
+	u8	map[256];	// destination pixel value of source pixel value
+	const u8* pal;		// destination palette (RGB332 colors of destination pixel values, NULL = colors are pixel values)
+} sDrawConv;
+
+// prepare color map of cross-format blit (nearest colors are selected by ColDist)
+//  conv ... color map
+//  srcpal ... source palette, RGB332 colors of source pixel values (NULL = pixel values are colors, CANVAS_8)
+//  srcnum ... number of source colors (ignored if srcpal is NULL)
+//  dstpal ... destination palette, RGB332 colors of destination pixel values (NULL = pixel values are colors, CANVAS_8)
+//  dstnum ... number of destination colors (ignored if dstpal is NULL)
+// CANVAS_ATTRIB8 uses 16-color palette on both sides. Map can be edited after preparing.
+void DrawConvInit(sDrawConv* conv, const u8* srcpal, int srcnum, const u8* dstpal, int dstnum);
+
+// Draw image of different format, pixels are converted by color map
+//  canvas ... destination canvas
+//  src ... source canvas (any format)
+//  conv ... color map prepared by DrawConvInit
+// Conversion is done in one pass, destination pixels are packed into 32-bit words. With
+// CANVAS_ATTRIB8 destination, 2 most frequent colors of each 8x8 cell are selected; colors
+// of pixels outside clipping box are kept in partially covered cells.
+void DrawImgConv(sCanvas* canvas, const sCanvas* src, int xd, int yd, int xs, int ys, int w, int h,
+	const sDrawConv* conv);
+
+// Draw image of different format with transparency (col = transparency key, source pixel value)
+void DrawBlitConv(sCanvas* canvas, const sCanvas* src, int xd, int yd, int xs, int ys, int w, int h,
+	const sDrawConv* conv, u8 col);
+
+// Flood fill (fill 4-connected region of pixels with the same color as the seed pixel)
+//  x, y ... seed pixel
+//  col ... fill color
+// Region is filled by spans of rows, using bounded stack of pending spans (DRAWFILL_STACK
+// entries, 8 bytes each) instead of recursion. Returns False if stack overflowed and part
+// of region may stay unfilled (it can be filled by next call from unfilled pixel).
+// CANVAS_ATTRIB8: region are pixels with the same bit as the seed, the bits are inverted and
+// attributes of touched cells get 'col' as color of new bit.
+Bool DrawFill(sCanvas* canvas, int x, int y, u8 col);
+
+// Flood fill with 8x8 pattern
+//  x, y ... seed pixel
+//  pat ... pattern, 8 bytes of rows, bit 7 is left pixel (aligned to image coordinates)
+//  col ... color of pattern bits 1
+//  bgcol ... color of pattern bits 0
+//  mask ... work canvas CANVAS_1 of canvas size, to mark filled pixels (NULL = not used;
+//           with view it must have size of the parent image, it is indexed by image coordinates)
+// If pattern uses color of the region (and with CANVAS_ATTRIB8 format, where pixels are
+// pattern bits and attributes of touched cells are set to col and bgcol), filled pixels
+// cannot be recognized and mask is required - without mask, function returns False.
+Bool DrawFillPat(sCanvas* canvas, int x, int y, const u8* pat, u8 col, u8 bgcol, sCanvas* mask = NULL);
+
+// get 1-bit canvas of one plane of CANVAS_PLANE2 or CANVAS_PLANE4 format
+//  dst ... destination descriptor of 1-bit canvas CANVAS_1
+//  canvas ... source canvas
+//  plane ... plane index (0..1 or 0..3)
+// Draw functions on this canvas change only one bit of colors of the pixels.
+void CanvasPlane(sCanvas* dst, const sCanvas* canvas, int plane);
+
 // DrawImgMat mode
 enum {
 	DRAWIMG_WRAP,		// wrap image
@@ -106,12 +272,37 @@ enum {
 //  y ... destination coordinate Y
 //  w ... destination width
 //  h ... destination height
-//  m ... transformation matrix (should be prepared using PrepDrawImg or PrepDrawPersp function)
+//  m ... transformation matrix, float or fixed-point (should be prepared using PrepDrawImg or PrepDrawPersp function)
 //  mode ... draw mode DRAWIMG_*
 //  color ... key or border color
 // Note to wrap and perspective mode: Width and height of source image must be power of 2!
 void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
 	const class cMat2Df* m, u8 mode, u8 color);
+void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
+	const class cMat2Di* m, u8 mode, u8 color);
+
+// item of batch of transformed images
+typedef struct {
+	const sCanvas* src;	// source canvas with 8-bit image
+	const int* mat;		// integer transformation matrix m11..m23 (cMat2Di::Int() or ExportInt)
+	s16	x;		// destination coordinate X
+	s16	y;		// destination coordinate Y
+	s16	w;		// destination width
+	s16	h;		// destination height
+	u8	mode;		// draw mode DRAWIMG_*
+	u8	color;		// key or border color
+} sDrawImgItem;
+
+// draw batch of 8-bit images with 2D transformation matrix (e.g. rotated or scaled sprites)
+//  canvas ... destination canvas
+//  item ... list of images
+//  num ... number of images
+// Result is the same as with DrawImgMat called for each item, items are drawn in list order.
+// In DRAWIMG_NOBORDER and DRAWIMG_TRANSP modes, each row is clipped once to pixels inside
+// source image and interpolator setup is reused while consecutive items have the same source
+// image (if source pitch is power of 2), so keep items of one image together where drawing
+// order allows it. Other modes are drawn by DrawImgMat.
+void DrawImgMatBatch(sCanvas* canvas, const sDrawImgItem* item, int num);
 
 // draw tile map using perspective projection
 //  canvas ... destination canvas
@@ -124,10 +315,12 @@ void DrawImgMat(sCanvas* canvas, const sCanvas* src, int x, int y, int w, int h,
 //  y ... destination coordinate Y
 //  w ... destination width
 //  h ... destination height
-//  mat ... transformation matrix (should be prepared using PrepDrawPersp function)
+//  mat ... transformation matrix, float or fixed-point (should be prepared using PrepDrawPersp function)
 //  horizon ... horizon offset (0=do not use perspective projection)
 void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbits, int maphbits,
 	int tilebits, int x, int y, int w, int h, const cMat2Df* mat, u8 horizon);
+void DrawTileMap(sCanvas* canvas, const sCanvas* src, const u8* map, int mapwbits, int maphbits,
+	int tilebits, int x, int y, int w, int h, const class cMat2Di* mat, u8 horizon);
 
 // draw image line interpolated
 //  canvas = destination canvas (8-bit pixel format)
@@ -0,0 +1,357 @@
+
+// ****************************************************************************
+//
+//                             Deferred draw lists
+//
+// ****************************************************************************
+
+#include "include.h"
+
+// pack two coordinates into word
+#define DRAWLIST_XY(x,y) (((u32)(x) & 0xffff) | ((u32)(y) << 16))
+
+// initialize draw list
+void DrawListInit(sDrawList* list, sCanvas* canvas, u32* buf, int size)
+{
+	list->buf = buf;
+	list->size = size;
+	list->len = 0;
+	list->over = False;
+	list->busy = False;
+	list->canvas = canvas;
+	list->seq = 0;
+	list->band = 0;
+}
+
+// clear draw list (waits for list to finish if it is in progress)
+void DrawListReset(sDrawList* list)
+{
+	DrawListWait(list);
+	list->len = 0;
+	list->over = False;
+}
+
+// allocate command in command buffer (returns NULL on overflow)
+static u32* DrawListAdd(sDrawList* list, int cmd, int len, u8 col, u8 par)
+{
+	if ((list->len + len > list->size) || (len > 255))
+	{
+		list->over = True;
+		return NULL;
+	}
+	u32* d = &list->buf[list->len];
+	list->len += len;
+	d[0] = cmd | (len << 8) | ((u32)col << 16) | ((u32)par << 24);
+	return d;
+}
+
+// record command with 2 coordinate words
+static void DrawListAdd2(sDrawList* list, int cmd, int x1, int y1, int x2, int y2, u8 col, u8 par)
+{
+	u32* d = DrawListAdd(list, cmd, 3, col, par);
+	if (d == NULL) return;
+	d[1] = DRAWLIST_XY(x1, y1);
+	d[2] = DRAWLIST_XY(x2, y2);
+}
+
+// record draw commands
+void DrawListRect(sDrawList* list, int x, int y, int w, int h, u8 col)
+	{ DrawListAdd2(list, DRAWLIST_RECT, x, y, w, h, col, 0); }
+
+void DrawListFrame(sDrawList* list, int x, int y, int w, int h, u8 col)
+	{ DrawListAdd2(list, DRAWLIST_FRAME, x, y, w, h, col, 0); }
+
+void DrawListClear(sDrawList* list)
+	{ DrawListAdd(list, DRAWLIST_CLEAR, 1, 0, 0); }
+
+void DrawListPoint(sDrawList* list, int x, int y, u8 col)
+{
+	u32* d = DrawListAdd(list, DRAWLIST_POINT, 2, col, 0);
+	if (d != NULL) d[1] = DRAWLIST_XY(x, y);
+}
+
+void DrawListLine(sDrawList* list, int x1, int y1, int x2, int y2, u8 col)
+	{ DrawListAdd2(list, DRAWLIST_LINE, x1, y1, x2, y2, col, 0); }
+
+void DrawListFillCircle(sDrawList* list, int x0, int y0, int r, u8 col, u8 mask /*=0xff*/)
+	{ DrawListAdd2(list, DRAWLIST_FILLCIRCLE, x0, y0, r, 0, col, mask); }
+
+void DrawListCircle(sDrawList* list, int x0, int y0, int r, u8 col, u8 mask /*=0xff*/)
+	{ DrawListAdd2(list, DRAWLIST_CIRCLE, x0, y0, r, 0, col, mask); }
+
+// record text (text is copied into command buffer)
+static void DrawListAddText(sDrawList* list, int cmd, const char* text, int x, int y, u8 col, u8 bgcol,
+	const void* font, int fontheight, int scalex, int scaley)
+{
+	int n = (int)strlen(text) + 1;
+	u32* d = DrawListAdd(list, cmd, 4 + (n + 3)/4, col, bgcol);
+	if (d == NULL) return;
+	d[1] = DRAWLIST_XY(x, y);
+	d[2] = ((u32)fontheight & 0xffff) | (((u32)scalex & 0xff) << 16) | ((u32)scaley << 24);
+	d[3] = (u32)(uintptr_t)font;
+	memcpy(&d[4], text, n);
+}
+
+void DrawListText(sDrawList* list, const char* text, int x, int y, u8 col,
+	const void* font, int fontheight /*=8*/, int scalex /*=1*/, int scaley /*=1*/)
+	{ DrawListAddText(list, DRAWLIST_TEXT, text, x, y, col, 0, font, fontheight, scalex, scaley); }
+
+void DrawListTextBg(sDrawList* list, const char* text, int x, int y, u8 col, u8 bgcol,
+	const void* font, int fontheight /*=8*/, int scalex /*=1*/, int scaley /*=1*/)
+	{ DrawListAddText(list, DRAWLIST_TEXTBG, text, x, y, col, bgcol, font, fontheight, scalex, scaley); }
+
+// record image
+static void DrawListAddImg(sDrawList* list, int cmd, sCanvas* src, int xd, int yd, int xs, int ys,
+	int w, int h, u8 col)
+{
+	u32* d = DrawListAdd(list, cmd, 5, col, 0);
+	if (d == NULL) return;
+	d[1] = DRAWLIST_XY(xd, yd);
+	d[2] = DRAWLIST_XY(xs, ys);
+	d[3] = DRAWLIST_XY(w, h);
+	d[4] = (u32)(uintptr_t)src;
+}
+
+void DrawListImg(sDrawList* list, sCanvas* src, int xd, int yd, int xs, int ys, int w, int h)
+	{ DrawListAddImg(list, DRAWLIST_IMG, src, xd, yd, xs, ys, w, h, 0); }
+
+void DrawListBlit(sDrawList* list, sCanvas* src, int xd, int yd, int xs, int ys, int w, int h, u8 col)
+	{ DrawListAddImg(list, DRAWLIST_BLIT, src, xd, yd, xs, ys, w, h, col); }
+
+// record polygon (vertices are copied into command buffer, more than DRAWPOLY_MAX is not recorded)
+void DrawListFillPoly(sDrawList* list, const s16* xy, int n, u8 col)
+{
+	if ((n < 3) || (n > DRAWPOLY_MAX)) return;
+	u32* d = DrawListAdd(list, DRAWLIST_FILLPOLY, 1 + n, col, (u8)n);
+	if (d == NULL) return;
+	int i;
+	for (i = 0; i < n; i++) d[1 + i] = DRAWLIST_XY(xy[2*i], xy[2*i+1]);
+}
+
+// record triangles
+void DrawListFillTriangle(sDrawList* list, int x1, int y1, int x2, int y2, int x3, int y3, u8 col)
+{
+	u32* d = DrawListAdd(list, DRAWLIST_TRIANGLE, 4, col, 0);
+	if (d == NULL) return;
+	d[1] = DRAWLIST_XY(x1, y1);
+	d[2] = DRAWLIST_XY(x2, y2);
+	d[3] = DRAWLIST_XY(x3, y3);
+}
+
+void DrawListGouraudTriangle(sDrawList* list, int x1, int y1, u8 c1, int x2, int y2, u8 c2,
+	int x3, int y3, u8 c3)
+{
+	u32* d = DrawListAdd(list, DRAWLIST_GOURAUD, 5, c1, c2);
+	if (d == NULL) return;
+	d[1] = DRAWLIST_XY(x1, y1);
+	d[2] = DRAWLIST_XY(x2, y2);
+	d[3] = DRAWLIST_XY(x3, y3);
+	d[4] = c3;
+}
+
+// record image with fixed-point matrix (matrix is copied into command buffer)
+void DrawListImgMat(sDrawList* list, const sCanvas* src, int x, int y, int w, int h,
+	const cMat2Di* m, u8 mode, u8 color)
+{
+	u32* d = DrawListAdd(list, DRAWLIST_IMGMAT, 10, color, mode);
+	if (d == NULL) return;
+	d[1] = DRAWLIST_XY(x, y);
+	d[2] = DRAWLIST_XY(w, h);
+	d[3] = (u32)(uintptr_t)src;
+	memcpy(&d[4], m->Int(), 6*sizeof(int));
+}
+
+// execute draw list on canvas
+void DrawListExec(const sDrawList* list, sCanvas* canvas, int dy)
+{
+	const u32* s = list->buf;
+	const u32* end = s + list->len;
+	u32 cmd;
+	u8 col, par;
+	int x1, y1, x2, y2, i;
+	s16 xy[DRAWPOLY_MAX*2];
+	sDrawImgItem item;
+
+	while (s < end)
+	{
+		// command header
+		cmd = s[0];
+		col = (u8)(cmd >> 16);
+		par = (u8)(cmd >> 24);
+
+		// first coordinates, relative to the canvas
+		x1 = (s16)s[1];
+		y1 = (s16)(s[1] >> 16) - dy;
+
+		switch ((u8)cmd)
+		{
+		case DRAWLIST_RECT:
+			DrawRect(canvas, x1, y1, (s16)s[2], (s16)(s[2] >> 16), col);
+			break;
+
+		case DRAWLIST_FRAME:
+			DrawFrame(canvas, x1, y1, (s16)s[2], (s16)(s[2] >> 16), col);
+			break;
+
+		case DRAWLIST_CLEAR:
+			DrawClear(canvas);
+			break;
+
+		case DRAWLIST_POINT:
+			DrawPoint(canvas, x1, y1, col);
+			break;
+
+		case DRAWLIST_LINE:
+			x2 = (s16)s[2];
+			y2 = (s16)(s[2] >> 16) - dy;
+			DrawLine(canvas, x1, y1, x2, y2, col);
+			break;
+
+		case DRAWLIST_FILLCIRCLE:
+			DrawFillCircle(canvas, x1, y1, (s16)s[2], col, par);
+			break;
+
+		case DRAWLIST_CIRCLE:
+			DrawCircle(canvas, x1, y1, (s16)s[2], col, par);
+			break;
+
+		case DRAWLIST_TEXT:
+			DrawText(canvas, (const char*)&s[4], x1, y1, col, (const void*)s[3],
+				(s16)s[2], (s8)(s[2] >> 16), (s8)(s[2] >> 24));
+			break;
+
+		case DRAWLIST_TEXTBG:
+			DrawTextBg(canvas, (const char*)&s[4], x1, y1, col, par, (const void*)s[3],
+				(s16)s[2], (s8)(s[2] >> 16), (s8)(s[2] >> 24));
+			break;
+
+		case DRAWLIST_IMG:
+			DrawImg(canvas, (sCanvas*)s[4], x1, y1, (s16)s[2], (s16)(s[2] >> 16),
+				(s16)s[3], (s16)(s[3] >> 16));
+			break;
+
+		case DRAWLIST_BLIT:
+			DrawBlit(canvas, (sCanvas*)s[4], x1, y1, (s16)s[2], (s16)(s[2] >> 16),
+				(s16)s[3], (s16)(s[3] >> 16), col);
+			break;
+
+		case DRAWLIST_FILLPOLY:
+			for (i = 0; i < par; i++)
+			{
+				xy[2*i] = (s16)s[1 + i];
+				xy[2*i+1] = (s16)((s16)(s[1 + i] >> 16) - dy);
+			}
+			DrawFillPoly(canvas, xy, par, col);
+			break;
+
+		case DRAWLIST_TRIANGLE:
+			DrawFillTriangle(canvas, x1, y1, (s16)s[2], (s16)(s[2] >> 16) - dy,
+				(s16)s[3], (s16)(s[3] >> 16) - dy, col);
+			break;
+
+		case DRAWLIST_GOURAUD:
+			DrawGouraudTriangle(canvas, x1, y1, col, (s16)s[2], (s16)(s[2] >> 16) - dy, par,
+				(s16)s[3], (s16)(s[3] >> 16) - dy, (u8)s[4]);
+			break;
+
+		case DRAWLIST_IMGMAT:
+			item.src = (const sCanvas*)s[3];
+			item.mat = (const int*)&s[4];
+			item.x = (s16)x1;
+			item.y = (s16)y1;
+			item.w = (s16)s[2];
+			item.h = (s16)(s[2] >> 16);
+			item.mode = par;
+			item.color = col;
+			DrawImgMatBatch(canvas, &item, 1);
+			break;
+		}
+
+		// next command
+		s += (cmd >> 8) & 0xff;
+	}
+}
+
+// prepare canvas of band of rows (dirty region of the band is tracked separately)
+static void DrawListBand(sDrawList* list, int inx, int y, int h)
+{
+	sCanvas* canvas = list->canvas;
+	sCanvas* d = &list->bandcan[inx];
+	CanvasView(d, canvas, 0, y, canvas->w, h);
+	d->dirty = NULL;
+	if (canvas->dirty != NULL)
+	{
+		d->dirty = &list->dirty[inx];
+		d->dirty->num = 0;
+	}
+}
+
+// add dirty region of the band to dirty region of canvas (band rectangles are in image coordinates)
+static void DrawListDirty(sDrawList* list, int inx)
+{
+	sCanvas* canvas = list->canvas;
+	if (canvas->dirty == NULL) return;
+	sDirty* dirty = &list->dirty[inx];
+	int i;
+	for (i = 0; i < dirty->num; i++)
+	{
+		sDirtyRect* r = &dirty->rect[i];
+		CanvasDirtyAdd(canvas, r->x1 - canvas->ox, r->y1 - canvas->oy, r->x2 - r->x1, r->y2 - r->y1);
+	}
+	dirty->num = 0;
+}
+
+// job of core 1 - execute band
+static void DrawListJob(void* arg)
+{
+	sDrawList* list = (sDrawList*)arg;
+	DrawListExec(list, &list->bandcan[1], list->band);
+}
+
+// submit draw list for execution
+void DrawListSubmit(sDrawList* list, Bool split /* = False */)
+{
+	DrawListWait(list);
+	sCanvas* canvas = list->canvas;
+	int h = canvas->h;
+
+	// VGA core is not running - execute on this core
+	if (!VgaCoreRun)
+	{
+		DrawListExec(list, canvas, 0);
+		return;
+	}
+
+	// split point (align to attribute rows)
+	int band = 0;
+	if (split) band = (h/2) & ~7;
+
+	// execute lower band on core 1
+	DrawListBand(list, 1, band, h - band);
+	list->band = band;
+	list->busy = True;
+	list->seq = Core1Post(DrawListJob, list);
+
+	// execute upper band on core 0
+	if (band > 0)
+	{
+		DrawListBand(list, 0, 0, band);
+		DrawListExec(list, &list->bandcan[0], 0);
+		DrawListDirty(list, 0);
+	}
+}
+
+// check if submitted draw list has finished
+Bool DrawListDone(sDrawList* list)
+{
+	return !list->busy || Core1Done(list->seq);
+}
+
+// wait for submitted draw list to finish (fence) and update dirty region of canvas
+void DrawListWait(sDrawList* list)
+{
+	if (!list->busy) return;
+	Core1WaitJob(list->seq);
+	DrawListDirty(list, 1);
+	list->busy = False;
+}
@@ -0,0 +1,109 @@
+
+// ****************************************************************************
+//
+//                             Deferred draw lists
+//
+// ****************************************************************************
+// Draw commands are recorded into a compact command buffer and executed later,
+// on core 1 in idle time between scanline interrupts (VGA core must be running
+// on core 1), or split by screen bands between both cores. Submitter gets a
+// fence: wait with DrawListWait before presenting or recording the list again.
+// Canvas must not be used by core 0 while the list is in progress.
+// Hazard: images with matrix (DrawListImgMat) use interpolator interp0 of the executing
+// core. On core 1 the scanline interrupt renders perspective and matrix layers with
+// interp0 and interp1 in the middle of a command; it is correct only because VgaLine
+// saves and restores both interpolators. Other code using interpolators in interrupts
+// of core 1 must save them too.
+
+#ifndef _DRAWLIST_H
+#define _DRAWLIST_H
+
+// draw list commands
+#define DRAWLIST_RECT		1	// DrawRect
+#define DRAWLIST_FRAME		2	// DrawFrame
+#define DRAWLIST_CLEAR		3	// DrawClear
+#define DRAWLIST_POINT		4	// DrawPoint
+#define DRAWLIST_LINE		5	// DrawLine
+#define DRAWLIST_FILLCIRCLE	6	// DrawFillCircle
+#define DRAWLIST_CIRCLE		7	// DrawCircle
+#define DRAWLIST_TEXT		8	// DrawText
+#define DRAWLIST_TEXTBG		9	// DrawTextBg
+#define DRAWLIST_IMG		10	// DrawImg
+#define DRAWLIST_BLIT		11	// DrawBlit
+#define DRAWLIST_FILLPOLY	12	// DrawFillPoly
+#define DRAWLIST_TRIANGLE	13	// DrawFillTriangle
+#define DRAWLIST_GOURAUD	14	// DrawGouraudTriangle
+#define DRAWLIST_IMGMAT		15	// DrawImgMat with fixed-point matrix
+
+// draw list
+//  Command: word 0 = command (bit 0..7), length in words (bit 8..15), color (bit 16..23),
+//  parameter (bit 24..31), following words = coordinates (2x s16), pointers and text.
+typedef struct {
+	u32*	buf;		// command buffer
+	int	size;		// size of command buffer in words
+	int	len;		// used length of command buffer in words
+	Bool	over;		// buffer overflow, some commands were not recorded
+	Bool	busy;		// list is submitted and not finished yet
+	sCanvas* canvas;	// destination canvas
+	u32	seq;		// sequence number of core 1 job
+	int	band;		// first row of core 1 band
+	sCanvas	bandcan[2];	// canvas of core 0 and core 1 band
+	sDirty	dirty[2];	// dirty region of core 0 and core 1 band
+} sDrawList;
+
+// initialize draw list
+//  list ... draw list
+//  canvas ... destination canvas
+//  buf ... command buffer
+//  size ... size of command buffer in words (rectangle takes 3 words, text 4 words + text,
+//	polygon 1 word + 1 word per vertex, triangle 4 words, image with matrix 10 words)
+void DrawListInit(sDrawList* list, sCanvas* canvas, u32* buf, int size);
+
+// clear draw list (waits for list to finish if it is in progress)
+void DrawListReset(sDrawList* list);
+
+// record draw commands (same parameters as the draw functions, without canvas)
+//  Text, polygon vertices and matrix are copied into command buffer. Images must stay valid
+//  until the list finishes.
+void DrawListRect(sDrawList* list, int x, int y, int w, int h, u8 col);
+void DrawListFrame(sDrawList* list, int x, int y, int w, int h, u8 col);
+void DrawListClear(sDrawList* list);
+void DrawListPoint(sDrawList* list, int x, int y, u8 col);
+void DrawListLine(sDrawList* list, int x1, int y1, int x2, int y2, u8 col);
+void DrawListFillCircle(sDrawList* list, int x0, int y0, int r, u8 col, u8 mask=0xff);
+void DrawListCircle(sDrawList* list, int x0, int y0, int r, u8 col, u8 mask=0xff);
+void DrawListText(sDrawList* list, const char* text, int x, int y, u8 col,
+	const void* font, int fontheight=8, int scalex=1, int scaley=1);
+void DrawListTextBg(sDrawList* list, const char* text, int x, int y, u8 col, u8 bgcol,
+	const void* font, int fontheight=8, int scalex=1, int scaley=1);
+void DrawListImg(sDrawList* list, sCanvas* src, int xd, int yd, int xs, int ys, int w, int h);
+void DrawListBlit(sDrawList* list, sCanvas* src, int xd, int yd, int xs, int ys, int w, int h, u8 col);
+void DrawListFillPoly(sDrawList* list, const s16* xy, int n, u8 col);
+void DrawListFillTriangle(sDrawList* list, int x1, int y1, int x2, int y2, int x3, int y3, u8 col);
+void DrawListGouraudTriangle(sDrawList* list, int x1, int y1, u8 c1, int x2, int y2, u8 c2,
+	int x3, int y3, u8 c3);
+void DrawListImgMat(sDrawList* list, const sCanvas* src, int x, int y, int w, int h,
+	const class cMat2Di* m, u8 mode, u8 color);
+
+// execute draw list on canvas
+//  list ... draw list
+//  canvas ... destination canvas (can be band of the list canvas)
+//  dy ... Y coordinate of canvas in list coordinates
+void DrawListExec(const sDrawList* list, sCanvas* canvas, int dy);
+
+// submit draw list for execution (list must not be changed until it finishes)
+//  split ... False = execute whole list on core 1 and return immediately,
+//            True = split canvas into 2 bands, execute lower band on core 1 and upper band
+//            on core 0, return after upper band is done (wait for lower band with DrawListWait)
+// If VGA core is not running on core 1, list is executed on core 0.
+// Split mode can at best halve drawing time of core 0. The real gain depends on how much
+// time is left to core 1 by scanline rendering, it was not measured on hardware.
+void DrawListSubmit(sDrawList* list, Bool split = False);
+
+// check if submitted draw list has finished
+Bool DrawListDone(sDrawList* list);
+
+// wait for submitted draw list to finish (fence) and update dirty region of canvas
+void DrawListWait(sDrawList* list);
+
+#endif // _DRAWLIST_H
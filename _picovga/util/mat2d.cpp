@@ -59,3 +59,160 @@ void cMat2Df::ExportInt(int* mat) const
 	mat[4] = TOFRACT(m22);
 	mat[5] = TOFRACT(m23);
 }
+
+// sine table, quarter of circle in 256 steps, 15 fraction bits
+static const u16 SinTab[257] = {
+	0, 201, 402, 603, 804, 1005, 1206, 1407,
+	1608, 1809, 2009, 2210, 2411, 2611, 2811, 3012,
+	3212, 3412, 3612, 3812, 4011, 4211, 4410, 4609,
+	4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195,
+	6393, 6590, 6787, 6983, 7180, 7376, 7571, 7767,
+	7962, 8157, 8351, 8546, 8740, 8933, 9127, 9319,
+	9512, 9704, 9896, 10088, 10279, 10469, 10660, 10850,
+	11039, 11228, 11417, 11605, 11793, 11980, 12167, 12354,
+	12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+	14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+	15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673,
+	16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+	18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358,
+	19520, 19681, 19841, 20001, 20160, 20318, 20475, 20632,
+	20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+	22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028,
+	23170, 23312, 23453, 23593, 23732, 23870, 24008, 24144,
+	24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+	25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199,
+	26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+	27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+	28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803,
+	28899, 28993, 29086, 29178, 29269, 29359, 29448, 29535,
+	29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+	30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784,
+	30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298,
+	31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+	31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099,
+	32138, 32177, 32214, 32251, 32286, 32319, 32352, 32383,
+	32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+	32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718,
+	32729, 32738, 32746, 32753, 32758, 32762, 32766, 32767,
+	32768,
+};
+
+// sine with 15 fraction bits (angle in ANGLE_FULL units)
+static int Sin15(int a)
+{
+	// angle in quadrant
+	int r = a & (ANGLE_FULL/4 - 1);
+	int q = (a >> 14) & 3;
+	if ((q & 1) != 0) r = ANGLE_FULL/4 - r;
+
+	// interpolate table
+	int i = r >> 6;
+	int s = SinTab[i];
+	if (i < 256) s += ((SinTab[i+1] - s)*(r & 0x3f) + 0x20) >> 6;
+
+	return ((q & 2) != 0) ? -s : s;
+}
+
+// fixed-point sine (angle in ANGLE_FULL units, result with FRACT fraction bits)
+int SinFract(int a)
+{
+	return (Sin15(a) + (1 << (15 - FRACT - 1))) >> (15 - FRACT);
+}
+
+// rotate, using sin and cos
+void cMat2Di::RotSC(int sina, int cosa)
+{
+	int t1 = m11;
+	int t2 = m21;
+	m11 = Mul(t1, cosa) - Mul(t2, sina);
+	m21 = Mul(t1, sina) + Mul(t2, cosa);
+
+	t1 = m12;
+	t2 = m22;
+	m12 = Mul(t1, cosa) - Mul(t2, sina);
+	m22 = Mul(t1, sina) + Mul(t2, cosa);
+
+	t1 = m13;
+	t2 = m23;
+	m13 = Mul(t1, cosa) - Mul(t2, sina);
+	m23 = Mul(t1, sina) + Mul(t2, cosa);
+}
+
+// rotate, using angle in ANGLE_FULL units (sin and cos with 15 fraction bits, to keep precision)
+void cMat2Di::Rot(int a)
+{
+	int sina = Sin15(a);
+	int cosa = Sin15(a + ANGLE_FULL/4);
+	int t1, t2;
+
+#define MUL15(a,b) ((int)(((s64)(a)*(b) + 0x4000) >> 15))
+	t1 = m11;
+	t2 = m21;
+	m11 = MUL15(t1, cosa) - MUL15(t2, sina);
+	m21 = MUL15(t1, sina) + MUL15(t2, cosa);
+
+	t1 = m12;
+	t2 = m22;
+	m12 = MUL15(t1, cosa) - MUL15(t2, sina);
+	m22 = MUL15(t1, sina) + MUL15(t2, cosa);
+
+	t1 = m13;
+	t2 = m23;
+	m13 = MUL15(t1, cosa) - MUL15(t2, sina);
+	m23 = MUL15(t1, sina) + MUL15(t2, cosa);
+#undef MUL15
+}
+
+// divide 64-bit integers, rounded (d > 0)
+static s64 DivRound(s64 n, s64 d)
+{
+	return (n < 0) ? -((-n + d/2)/d) : ((n + d/2)/d);
+}
+
+// prepare transformation matrix (for DrawImgMat function)
+//  Result is the same as the sequence Unit, TransX/Y(x0,y0), Rot(r), ShearX/Y, ScaleX/Y(ws/wd,hs/hd)
+//  and TransX/Y(tx,ty), but is calculated with 64-bit intermediate results, so that scaling
+//  does not magnify rounding errors of rotation and shear.
+void cMat2Di::PrepDrawImg(int ws, int hs, int x0, int y0, int wd, int hd,
+	int shearx, int sheary, int r, int tx, int ty)
+{
+	// rotate reference point (15 fraction bits)
+	s64 sina = Sin15(r);
+	s64 cosa = Sin15(r + ANGLE_FULL/4);
+	s64 r1[3] = { cosa, -sina, x0*cosa - y0*sina };
+	s64 r2[3] = { sina, cosa, x0*sina + y0*cosa };
+
+	// shear in X direction (15+FRACT fraction bits)
+	s64 u1[3], u2[3];
+	int i;
+	for (i = 0; i < 3; i++) u1[i] = (r1[i] << FRACT) + shearx*r2[i];
+
+	// shear in Y direction (15+FRACT fraction bits)
+	for (i = 0; i < 3; i++) u2[i] = (r2[i] << FRACT) + DivRound(sheary*u1[i], FRACTMUL);
+
+	// scale to destination size, resize to unit size and shift (FRACT fraction bits)
+	s64 dx = (s64)wd << 15;
+	s64 dy = (s64)hd << 15;
+	if (dx < 0) { dx = -dx; ws = -ws; }
+	if (dy < 0) { dy = -dy; hs = -hs; }
+	int* m1 = &m11;
+	int* m2 = &m21;
+	for (i = 0; i < 3; i++)
+	{
+		m1[i] = (wd == 0) ? 0 : (int)DivRound(u1[i]*ws, dx);
+		m2[i] = (hd == 0) ? 0 : (int)DivRound(u2[i]*hs, dy);
+	}
+	m13 += tx;
+	m23 += ty;
+}
+
+// export matrix to int array[6]
+void cMat2Di::ExportInt(int* mat) const
+{
+	mat[0] = m11;
+	mat[1] = m12;
+	mat[2] = m13;
+	mat[3] = m21;
+	mat[4] = m22;
+	mat[5] = m23;
+}
@@ -223,4 +223,94 @@ public:
 	void ExportInt(int* mat) const;
 };
 
+// angle of fixed-point rotation (full circle = ANGLE_FULL)
+#define ANGLE_FULL	65536
+#define DEG2ANGLE(deg) ((int)((deg)*(ANGLE_FULL/360.0f) + (((deg) < 0) ? -0.5f : 0.5f)))
+
+// fixed-point sine (angle in ANGLE_FULL units, result with FRACT fraction bits)
+int SinFract(int a);
+
+// fixed-point cosine (angle in ANGLE_FULL units, result with FRACT fraction bits)
+inline int CosFract(int a) { return SinFract(a + ANGLE_FULL/4); }
+
+// fixed-point transformation matrix, without floating point operations
+//  Matrix members and parameters of the functions are fixed-point numbers with FRACT
+//  fraction bits (use TOFRACT or <<FRACT to convert), the same format as ExportInt
+//  of float matrix has, so the matrix can be passed directly to the drawing functions.
+class cMat2Di : public cMat2D<int>
+{
+public:
+	// multiply fixed-point numbers
+	static inline int Mul(int a, int b)
+	{
+		return (int)(((s64)a*b + FRACTMUL/2) >> FRACT);
+	}
+
+	// set unit matrix
+	inline void Unit()
+	{
+		m11 = FRACTMUL; m12 = 0; m13 = 0;
+		m21 = 0; m22 = FRACTMUL; m23 = 0;
+	}
+
+	// scale in X direction
+	inline void ScaleX(int sx)
+	{
+		m11 = Mul(m11, sx);
+		m12 = Mul(m12, sx);
+		m13 = Mul(m13, sx);
+	}
+
+	// scale in Y direction
+	inline void ScaleY(int sy)
+	{
+		m21 = Mul(m21, sy);
+		m22 = Mul(m22, sy);
+		m23 = Mul(m23, sy);
+	}
+
+	// rotate, using sin and cos
+	void RotSC(int sina, int cosa);
+
+	// rotate, using angle in ANGLE_FULL units
+	void Rot(int a);
+
+	// Shear in X direction
+	inline void ShearX(int dx)
+	{
+		m11 += Mul(m21, dx);
+		m12 += Mul(m22, dx);
+		m13 += Mul(m23, dx);
+	}
+
+	// Shear in Y direction
+	inline void ShearY(int dy)
+	{
+		m21 += Mul(m11, dy);
+		m22 += Mul(m12, dy);
+		m23 += Mul(m13, dy);
+	}
+
+	// prepare transformation matrix (for DrawImgMat function)
+	//  ws ... source image width
+	//  hs ... source image height
+	//  x0 ... reference point X on source image
+	//  y0 ... reference point Y on source image
+	//  wd ... destination image width (negative = flip image in X direction)
+	//  hd ... destination image height (negative = flip image in Y direction)
+	//  shearx ... shear image in X direction (fixed-point)
+	//  sheary ... shear image in Y direction (fixed-point)
+	//  r ... rotate image (angle in ANGLE_FULL units)
+	//  tx ... shift in X direction (fixed-point, ws = whole image width)
+	//  ty ... shift in Y direction (fixed-point, hs = whole image height)
+	void PrepDrawImg(int ws, int hs, int x0, int y0, int wd, int hd,
+		int shearx, int sheary, int r, int tx, int ty);
+
+	// export matrix to int array[6]
+	void ExportInt(int* mat) const;
+
+	// get matrix as int array[6] m11, m12, m13, m21, m22, m23 (for drawing functions and layers)
+	inline const int* Int() const { return &m11; }
+};
+
 #endif // _MAT2D_H
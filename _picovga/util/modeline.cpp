@@ -0,0 +1,275 @@
+// ****************************************************************************
+//
+//                     Video timings from modeline and CVT
+//
+// ****************************************************************************
+
+#include "include.h"
+
+// CVT constants
+#define CVT_H_GRAN	8	// character cell granularity
+#define CVT_MIN_VSYNC_BP 550.0f	// min. time of V sync + back porch in [us]
+#define CVT_MIN_V_PORCH	3	// min. V front porch in lines
+#define CVT_MIN_V_BPORCH 6	// min. V back porch in lines
+#define CVT_HSYNC_PER	8	// H sync width in % of line
+#define CVT_C_PRIME	30	// blanking formula offset, C' = (C - J)*K/256 + J
+#define CVT_M_PRIME	300	// blanking formula gradient, M' = K/256*M
+#define CVT_CLOCK_STEP	250	// pixel clock step in kHz
+#define CVT_RB_MIN_VBLANK 460.0f // CVT-RB min. V blanking time in [us]
+#define CVT_RB_H_SYNC	32	// CVT-RB H sync in pixels
+#define CVT_RB_H_BLANK	160	// CVT-RB H blanking in pixels
+#define CVT_RB_V_FPORCH	3	// CVT-RB V front porch in lines
+
+// setup video timings from modeline values (returns False on invalid timings)
+static Bool ModelineSetup(sModeline* m, u32 pclk, int hdisp, int hss, int hse, int htot,
+	int vdisp, int vss, int vse, int vtot, Bool psync)
+{
+	// check timings
+	if ((pclk == 0) || (hdisp <= 0) || (hss < hdisp) || (hse <= hss) || (htot <= hse) ||
+		(vdisp <= 0) || (vss < vdisp) || (vse <= vss) || (vtot <= vse) ||
+		(hdisp > 0xffff) || (htot > 0xffff) || (vtot > 0xffff)) return False;
+
+	// horizontal (pixels to [us])
+	sVideo* v = &m->video;
+	float k = 1000.0f/pclk;
+	v->htot = htot*k;
+	v->hfront = (hss - hdisp)*k;
+	v->hsync = (hse - hss)*k;
+	v->hback = (htot - hse)*k;
+	v->hfull = hdisp*k;
+
+	// vertical
+	v->vtot = (u16)vtot;
+	v->vmax = (u16)vdisp;
+
+	// subframe 1
+	v->vsync1 = (u16)(vse - vss);
+	v->vpost1 = 0;
+	v->vback1 = (u16)(vtot - vse);
+	v->vact1 = (u16)vdisp;
+	v->vfront1 = (u16)(vss - vdisp);
+	v->vpre1 = 0;
+
+	// subframe 2
+	v->vsync2 = 0;
+	v->vpost2 = 0;
+	v->vback2 = 0;
+	v->vact2 = 0;
+	v->vfront2 = 0;
+	v->vpre2 = 0;
+
+	// name
+	v->name = m->name;
+
+	// flags
+	v->inter = False;
+	v->psync = psync;
+	v->odd = False;
+
+	m->pclk = pclk;
+	m->width = (u16)hdisp;
+	m->height = (u16)vdisp;
+	m->htot = (u16)htot;
+	return True;
+}
+
+// skip spaces
+static const char* ModelineSpace(const char* s)
+{
+	while ((*s == ' ') || (*s == '\t')) s++;
+	return s;
+}
+
+// compare keyword, case insensitive (returns pointer after keyword or NULL)
+static const char* ModelineKey(const char* s, const char* key)
+{
+	char ch;
+	for (; *key != 0; s++, key++)
+	{
+		ch = *s;
+		if ((ch >= 'a') && (ch <= 'z')) ch -= 'a' - 'A';
+		if (ch != *key) return NULL;
+	}
+	ch = *s;
+	if ((ch != 0) && (ch != ' ') && (ch != '\t') && (ch != '\r') && (ch != '\n')) return NULL;
+	return s;
+}
+
+// parse unsigned number with optional fraction, multiplied by 'mul' (returns NULL on error)
+static const char* ModelineNum(const char* s, u32 mul, u32* num)
+{
+	s = ModelineSpace(s);
+	if ((*s < '0') || (*s > '9')) return NULL;
+	u32 n = 0;
+	while ((*s >= '0') && (*s <= '9'))
+	{
+		n = n*10 + (*s - '0');
+		if (n > 0xffff) return NULL;
+		s++;
+	}
+	n *= mul;
+
+	// fraction
+	if (*s == '.')
+	{
+		s++;
+		while ((*s >= '0') && (*s <= '9'))
+		{
+			mul /= 10;
+			n += (*s - '0')*mul;
+			s++;
+		}
+	}
+	*num = n;
+	return s;
+}
+
+// parse XFree86 modeline (returns False on syntax error or unsupported timing)
+Bool ModelineParse(sModeline* m, const char* str)
+{
+	int i;
+	u32 n[9];
+	const char* s = ModelineSpace(str);
+
+	// skip keyword
+	const char* s2 = ModelineKey(s, "MODELINE");
+	if (s2 != NULL) s = ModelineSpace(s2);
+
+	// name
+	for (i = 0; i < VIDEO_NAME_LEN; i++) m->name[i] = ' ';
+	m->name[VIDEO_NAME_LEN] = 0;
+	if (*s == '"')
+	{
+		s++;
+		for (i = 0; (*s != '"') && (*s != 0); s++)
+		{
+			if (i < VIDEO_NAME_LEN) m->name[i++] = *s;
+		}
+		if (*s != '"') return False;
+		s++;
+	}
+	else
+		memcpy(m->name, "MLINE", VIDEO_NAME_LEN);
+
+	// pixel clock in kHz and 8 timing values
+	s = ModelineNum(s, 1000, &n[0]);
+	for (i = 1; (i < 9) && (s != NULL); i++) s = ModelineNum(s, 1, &n[i]);
+	if (s == NULL) return False;
+
+	// flags
+	Bool psync = False;
+	for (;;)
+	{
+		s = ModelineSpace(s);
+		if ((*s == 0) || (*s == '\r') || (*s == '\n')) break;
+
+		if ((s2 = ModelineKey(s, "+HSYNC")) != NULL)
+			psync = True;
+		else if ((s2 = ModelineKey(s, "-HSYNC")) != NULL)
+			psync = False;
+		else if (((s2 = ModelineKey(s, "+VSYNC")) == NULL) && ((s2 = ModelineKey(s, "-VSYNC")) == NULL))
+			return False; // Interlace, DoubleScan, CSync or unknown flag
+		s = s2;
+	}
+
+	return ModelineSetup(m, n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8], psync);
+}
+
+// generate VESA CVT timings (returns False on invalid parameters)
+Bool ModelineCVT(sModeline* m, int w, int h, float refresh, Bool rb)
+{
+	// check parameters
+	w -= w % CVT_H_GRAN;
+	if ((w <= 0) || (h <= 0) || (refresh < 1.0f)) return False;
+
+	// V sync width by aspect ratio
+	int vsync = 10;
+	if (h*4 == w*3)
+		vsync = 4;
+	else if (h*16 == w*9)
+		vsync = 5;
+	else if (h*16 == w*10)
+		vsync = 6;
+	else if ((h*5 == w*4) || (h*15 == w*9))
+		vsync = 7;
+
+	int htot, hse, hss, vtot;
+	u32 pclk;
+	Bool psync = rb; // CVT-RB uses positive H sync, CVT negative H sync
+	if (rb)
+	{
+		// CVT-RB: estimated H period in [us]
+		float hper = (1000000.0f/refresh - CVT_RB_MIN_VBLANK) / h;
+		if (hper <= 0) return False;
+
+		// V blanking lines
+		int vbi = (int)(CVT_RB_MIN_VBLANK/hper) + 1;
+		if (vbi < CVT_RB_V_FPORCH + vsync + CVT_MIN_V_BPORCH) vbi = CVT_RB_V_FPORCH + vsync + CVT_MIN_V_BPORCH;
+		vtot = h + vbi;
+
+		// fixed H blanking
+		htot = w + CVT_RB_H_BLANK;
+		hse = w + CVT_RB_H_BLANK/2;
+		hss = hse - CVT_RB_H_SYNC;
+
+		// pixel clock
+		pclk = (u32)(refresh*vtot*htot/1000.0f);
+		pclk -= pclk % CVT_CLOCK_STEP;
+	}
+	else
+	{
+		// CVT: estimated H period in [us]
+		float hper = (1000000.0f/refresh - CVT_MIN_VSYNC_BP) / (h + CVT_MIN_V_PORCH);
+		if (hper <= 0) return False;
+
+		// V sync + back porch lines
+		int vsbp = (int)(CVT_MIN_VSYNC_BP/hper) + 1;
+		if (vsbp < vsync + CVT_MIN_V_BPORCH) vsbp = vsync + CVT_MIN_V_BPORCH;
+		vtot = h + vsbp + CVT_MIN_V_PORCH;
+
+		// ideal blanking duty cycle
+		float duty = CVT_C_PRIME - CVT_M_PRIME*hper/1000.0f;
+		if (duty < 20) duty = 20;
+
+		// H blanking, rounded down to 2 character cells
+		int hblank = (int)(w*duty/(100 - duty));
+		hblank -= hblank % (2*CVT_H_GRAN);
+		htot = w + hblank;
+
+		// H sync, end is in center of blanking
+		hse = w + hblank/2;
+		hss = hse - htot*CVT_HSYNC_PER/100;
+		hss += CVT_H_GRAN - hss % CVT_H_GRAN;
+
+		// pixel clock
+		pclk = (u32)(htot*1000.0f/hper);
+		pclk -= pclk % CVT_CLOCK_STEP;
+	}
+
+	// name
+	memcpy(m->name, rb ? "CVTRB" : "CVT  ", VIDEO_NAME_LEN+1);
+
+	// V sync follows minimal front porch (CVT_RB_V_FPORCH is the same)
+	int vss = h + CVT_MIN_V_PORCH;
+	return ModelineSetup(m, pclk, w, hss, hse, htot, h, vss, vss + vsync, vtot, psync);
+}
+
+// check videomode setup against required timings (returns MODELINE_ERR_* flags, 0 = OK)
+int ModelineCheck(const sModeline* m, const sVmode* vmode, float* err)
+{
+	int res = 0;
+	const sVideo* v = &m->video;
+
+	// state machine clocks per [us]
+	float k = vmode->freq/1000.0f/vmode->div;
+
+	// check PIO minimums
+	if ((int)(v->hsync*k + 0.5f) < 4) res |= MODELINE_ERR_HSYNC;
+	if ((int)(v->hback*k + 0.5f) < 13) res |= MODELINE_ERR_HBACK;
+	if ((int)(v->hfront*k + 0.5f) < 2) res |= MODELINE_ERR_HFRONT;
+	if (vmode->wmax < m->width) res |= MODELINE_ERR_WIDTH;
+
+	// relative error of pixel clock
+	if (err != NULL) *err = vmode->freq/(float)(vmode->cpp*vmode->div)/m->pclk - 1.0f;
+	return res;
+}
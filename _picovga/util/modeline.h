@@ -0,0 +1,51 @@
+// ****************************************************************************
+//
+//                     Video timings from modeline and CVT
+//
+// ****************************************************************************
+// Generates video timings sVideo at runtime, from XFree86 modeline string or
+// from VESA CVT formula. Use generated timings with VgaCfg:
+//    Cfg.video = &m.video; Cfg.wfull = m.width; VgaCfg(&Cfg, &Vmode);
+// and then check result with ModelineCheck.
+
+#ifndef _MODELINE_H
+#define _MODELINE_H
+
+// errors of videomode setup (result of ModelineCheck)
+#define MODELINE_ERR_HSYNC	B0	// H sync pulse is shorter than 4 state machine clocks
+#define MODELINE_ERR_HBACK	B1	// H back porch is shorter than 13 state machine clocks
+#define MODELINE_ERR_HFRONT	B2	// H front porch is shorter than 2 state machine clocks
+#define MODELINE_ERR_WIDTH	B3	// active width is not fully displayed
+
+// generated video timings
+typedef struct {
+	sVideo	video;			// video timings (video.name points to 'name')
+	char	name[VIDEO_NAME_LEN+1];	// video timing name
+	u32	pclk;			// pixel clock in kHz
+	u16	width;			// active width in pixels (corresponding to 'hfull' time)
+	u16	height;			// active height in lines
+	u16	htot;			// total pixels per line
+} sModeline;
+
+// parse XFree86 modeline (returns False on syntax error or unsupported timing)
+//   m ... destination video timings
+//   str ... modeline: [Modeline] ["name"] pclk hdisp hsyncstart hsyncend htotal vdisp vsyncstart vsyncend vtotal [flags]
+//	- pclk is in MHz, flags +HSync/-HSync select sync polarity
+//	- Interlace and DoubleScan modelines are not supported
+Bool ModelineParse(sModeline* m, const char* str);
+
+// generate VESA CVT timings (returns False on invalid parameters)
+//   m ... destination video timings
+//   w ... active width in pixels (rounded down to multiple of 8)
+//   h ... active height in lines
+//   refresh ... vertical refresh rate in Hz
+//   rb ... use reduced blanking (CVT-RB, for LCD monitors)
+Bool ModelineCVT(sModeline* m, int w, int h, float refresh, Bool rb);
+
+// check videomode setup against required timings (returns MODELINE_ERR_* flags, 0 = OK)
+//   m ... required video timings
+//   vmode ... videomode setup calculated by VgaCfg
+//   err ... output relative error of achieved pixel clock (NULL = not used)
+int ModelineCheck(const sModeline* m, const sVmode* vmode, float* err);
+
+#endif // _MODELINE_H
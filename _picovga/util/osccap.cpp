@@ -0,0 +1,237 @@
+// ****************************************************************************
+//
+//                 Oscilloscope capture (ADC -> DMA ring -> trigger)
+//
+// ****************************************************************************
+
+#include "include.h"
+
+// ring buffer of samples
+u8 OscCapRing[OSCCAP_RING] __attribute__((aligned(OSCCAP_RING)));
+
+// start address of ring buffer (source of reload DMA channel)
+static u8* OscCapRingAddr = OscCapRing;
+
+// double buffer of sample window
+static u8 OscCapBuf[2][OSCCAP_WINMAX];
+static int OscCapBack;		// index of back buffer
+
+// setup
+static sSegm* OscCapSegm = NULL; // video segment (NULL = capture is not running)
+static int OscCapLen;		// number of samples in window
+static int OscCapScale;		// scale of samples (= segment height)
+static u8 OscCapMode = OSCCAP_FREE; // trigger mode
+static u8 OscCapLevel = 128;	// trigger level
+static Bool OscCapAuto = True;	// auto trigger
+static int OscCapPre = 0;	// number of samples before trigger
+
+// state (sample indices are absolute, not masked)
+static u32 OscCapLast;		// last position of DMA in ring buffer
+static u32 OscCapHead;		// index of next sample to be written by DMA
+static u32 OscCapScan;		// index of first sample not searched for trigger yet
+static u32 OscCapFrame;		// frame of last displayed window
+
+// start capture
+void OscCapStart(sSegm* segm, int input, int rate, int len)
+{
+	// stop old capture
+	OscCapStop();
+
+	// setup
+	if (len > OSCCAP_WINMAX) len = OSCCAP_WINMAX;
+	if (OscCapPre > len) OscCapPre = len;
+	OscCapLen = len;
+	OscCapScale = segm->wrapy;
+	if (OscCapScale > 256) OscCapScale = 256;
+	OscCapBack = 0;
+	OscCapLast = 0;
+	OscCapHead = 0;
+	OscCapScan = len;
+	OscCapFrame = Frame;
+	memset(OscCapRing, 0, OSCCAP_RING);
+
+	// initialize ADC
+	adc_init();
+	adc_gpio_init(26 + input);
+	adc_select_input(input);
+
+	// FIFO with DMA requests, 8-bit samples
+	adc_fifo_setup(true, true, 1, false, true);
+
+	// sample rate (ADC clock is 48 MHz, 96 clock cycles per conversion)
+	int div = 48000000/rate - 1;
+	if (div < 96) div = 0;
+	adc_set_clkdiv((float)div);
+
+// ==== prepare DMA channel storing samples to ring buffer
+
+	dma_channel_config cfg = dma_channel_get_default_config(OSCCAP_DMA);
+
+	// do not increment address on read from ADC FIFO
+	channel_config_set_read_increment(&cfg, false);
+
+	// increment address on write to ring buffer
+	channel_config_set_write_increment(&cfg, true);
+
+	// each DMA transfered entry is 8-bits
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+
+	// write ring - wrap to size of ring buffer
+	channel_config_set_ring(&cfg, true, OSCCAP_RINGBITS);
+
+	// DMA data request from ADC
+	channel_config_set_dreq(&cfg, DREQ_ADC);
+
+	// chain to reload channel
+	channel_config_set_chain_to(&cfg, OSCCAP_DMA_RELOAD);
+
+	// DMA configure
+	dma_channel_configure(
+		OSCCAP_DMA,		// channel
+		&cfg,			// configuration
+		OscCapRing,		// write address
+		&adc_hw->fifo,		// read address
+		OSCCAP_RING,		// number of transfers in u8
+		false			// do not start yet
+		);
+
+// ==== prepare DMA channel restarting ring DMA channel (transfer count is reloaded on trigger)
+
+	cfg = dma_channel_get_default_config(OSCCAP_DMA_RELOAD);
+	channel_config_set_read_increment(&cfg, false);
+	channel_config_set_write_increment(&cfg, false);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+
+	// DMA configure
+	dma_channel_configure(
+		OSCCAP_DMA_RELOAD,	// channel
+		&cfg,			// configuration
+		&dma_hw->ch[OSCCAP_DMA].al2_write_addr_trig, // write address
+		&OscCapRingAddr,	// read address
+		1,			// number of transfers in u32
+		false			// do not start yet
+		);
+
+	// start capture
+	OscCapSegm = segm;
+	dma_channel_start(OSCCAP_DMA);
+	adc_run(true);
+}
+
+// stop capture
+void OscCapStop()
+{
+	if (OscCapSegm == NULL) return;
+	OscCapSegm = NULL;
+
+	adc_run(false);
+	dma_channel_abort(OSCCAP_DMA_RELOAD);
+	dma_channel_abort(OSCCAP_DMA);
+	dma_channel_abort(OSCCAP_DMA_RELOAD);
+	adc_fifo_drain();
+}
+
+// set trigger
+void OscCapTrig(u8 mode, u8 level, int pre, Bool autotrig)
+{
+	if (pre < 0) pre = 0;
+	if ((OscCapSegm != NULL) && (pre > OscCapLen)) pre = OscCapLen;
+	OscCapMode = mode;
+	OscCapLevel = level;
+	OscCapPre = pre;
+	OscCapAuto = autotrig;
+}
+
+// search newest trigger event in samples first..end-1 (returns index, or end if not found)
+static u32 OscCapFind(u32 first, u32 end)
+{
+	const u8* ring = OscCapRing;
+	int level = OscCapLevel;
+	u32 cand = end;
+	u32 i;
+
+	// Search backwards: candidate is start of the run of samples over the level,
+	// it is confirmed by sample before the run outside of the hysteresis.
+	if (OscCapMode == OSCCAP_RISE)
+	{
+		int lo = level - OSCCAP_HYST;
+		for (i = end; i != first; )
+		{
+			i--;
+			int s = ring[i & OSCCAP_MASK];
+			if (s >= level)
+				cand = i;
+			else if ((s < lo) && (cand != end))
+				return cand;
+		}
+	}
+	else
+	{
+		int hi = level + OSCCAP_HYST;
+		for (i = end; i != first; )
+		{
+			i--;
+			int s = ring[i & OSCCAP_MASK];
+			if (s <= level)
+				cand = i;
+			else if ((s > hi) && (cand != end))
+				return cand;
+		}
+	}
+	return end;
+}
+
+// process new samples (returns True if new window has been prepared)
+Bool OscCapPoll()
+{
+	sSegm* segm = OscCapSegm;
+	if (segm == NULL) return False;
+
+	// previous window is not displayed yet
+	if (!VgaSwapDone(&segm->data)) return False;
+
+	// update head index
+	u32 pos = (u32)((u8*)dma_hw->ch[OSCCAP_DMA].write_addr - OscCapRing) & OSCCAP_MASK;
+	u32 head = OscCapHead + ((pos - OscCapLast) & OSCCAP_MASK);
+	OscCapLast = pos;
+	OscCapHead = head;
+
+	// last sample which can be trigger (enough samples after trigger must be captured)
+	int len = OscCapLen;
+	int pre = OscCapPre;
+	u32 end = head - (len - pre);
+
+	// overrun, older samples are lost
+	if ((int)(end - OscCapScan) > OSCCAP_RING - len) OscCapScan = end - (OSCCAP_RING - len);
+
+	// no new samples
+	if ((int)(end - OscCapScan) <= 0) return False;
+
+	// search trigger
+	u32 trig = end;
+	if (OscCapMode != OSCCAP_FREE)
+	{
+		trig = OscCapFind(OscCapScan, end);
+		OscCapScan = end;
+		if (trig == end)
+		{
+			// no trigger event, use auto trigger after timeout
+			if (!OscCapAuto || ((u32)(Frame - OscCapFrame) < OSCCAP_AUTO)) return False;
+		}
+	}
+	else
+		OscCapScan = end;
+
+	// copy window to back buffer, scale to segment height
+	u8* d = OscCapBuf[OscCapBack];
+	const u8* ring = OscCapRing;
+	u32 i = trig - pre;
+	int scale = OscCapScale;
+	for (; len > 0; len--) *d++ = (u8)((ring[i++ & OSCCAP_MASK]*scale) >> 8);
+
+	// swap buffers at start of next frame
+	VgaSwapData(segm, OscCapBuf[OscCapBack]);
+	OscCapBack ^= 1;
+	OscCapFrame = Frame;
+	return True;
+}
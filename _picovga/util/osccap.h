@@ -0,0 +1,65 @@
+// ****************************************************************************
+//
+//                 Oscilloscope capture (ADC -> DMA ring -> trigger)
+//
+// ****************************************************************************
+// ADC runs free at required sample rate (max. 500 kS/s) and DMA stores 8-bit
+// samples into ring buffer, without any CPU load. OscCapPoll() searches new
+// samples for trigger event, copies window of samples, scaled to segment height,
+// into back buffer and requests swap of segment data at start of next frame
+// (see VgaSwapData). Samples can be displayed using GF_OSCIL, GF_OSCLINE or
+// GF_LEVEL segment, one sample per pixel.
+//
+// OscCapPoll() must be called at least once per frame to get latency under
+// 1 frame, and at least once per ring period (OSCCAP_RING samples, 32 ms at
+// 500 kS/s) to not lose samples.
+
+// GP26..GP29 ... ADC inputs 0..3
+
+#ifndef _OSCCAP_H
+#define _OSCCAP_H
+
+// DMA channels (first free channels after VGA driver, canvas uses next ones CANVAS_DMA*)
+#ifndef OSCCAP_DMA
+#define OSCCAP_DMA	(VGA_DMA_LAST+1) // DMA channel - store ADC samples to ring buffer
+#endif
+#define OSCCAP_DMA_RELOAD (OSCCAP_DMA+1) // DMA channel - restart of ring DMA channel
+
+#define OSCCAP_RINGBITS	14		// number of bits of ring buffer size
+#define OSCCAP_RING	(1<<OSCCAP_RINGBITS) // size of ring buffer in samples (= 16384)
+#define OSCCAP_MASK	(OSCCAP_RING-1)	// mask of index in ring buffer
+#define OSCCAP_WINMAX	1024		// max. size of sample window (= segment width)
+
+#define OSCCAP_HYST	4		// trigger hysteresis (in ADC samples 0..255)
+#define OSCCAP_AUTO	4		// auto trigger timeout (in frames)
+
+// trigger mode
+#define OSCCAP_FREE	0	// free run, display newest samples
+#define OSCCAP_RISE	1	// trigger on rising edge
+#define OSCCAP_FALL	2	// trigger on falling edge
+
+// ring buffer of samples (aligned to its size)
+extern u8 OscCapRing[OSCCAP_RING];
+
+// start capture
+//   segm = video segment GF_OSCIL, GF_OSCLINE or GF_LEVEL (must be set up before, its data buffer will be swapped)
+//   input = ADC input 0..3 (GP26..GP29)
+//   rate = sample rate in samples per second (max. 500000)
+//   len = number of samples in window (= width of segment, max. OSCCAP_WINMAX)
+// Samples are scaled to wrapy of the segment.
+void OscCapStart(sSegm* segm, int input, int rate, int len);
+
+// stop capture
+void OscCapStop();
+
+// set trigger
+//   mode = trigger mode OSCCAP_*
+//   level = trigger level (in ADC samples 0..255)
+//   pre = number of samples before trigger event (pre-trigger depth, 0..len)
+//   autotrig = display newest samples if trigger event does not come in OSCCAP_AUTO frames
+void OscCapTrig(u8 mode, u8 level, int pre, Bool autotrig);
+
+// process new samples (returns True if new window has been prepared)
+Bool OscCapPoll();
+
+#endif // _OSCCAP_H
@@ -0,0 +1,272 @@
+// ****************************************************************************
+//
+//                    Palette animation (cycling and fading)
+//
+// ****************************************************************************
+
+#include "include.h"
+
+// blend 2 colors RGB332 (level 0..256)
+static u8 PalAnimBlend(u8 col1, u8 col2, int level)
+{
+	int r = col1 >> 5;
+	int g = (col1 >> 2) & 7;
+	int b = col1 & 3;
+	r += (((col2 >> 5) - r)*level + 128) >> 8;
+	g += ((((col2 >> 2) & 7) - g)*level + 128) >> 8;
+	b += (((col2 & 3) - b)*level + 128) >> 8;
+	return (u8)((r << 5) | (g << 2) | b);
+}
+
+// write changed colors into palette table
+//   trans = palette table
+//   pal = new palette
+//   mask = mask of changed colors
+static void PalAnimWrite(sPalAnim* anim, void* trans, const u8* pal, u16 mask)
+{
+	int i, j;
+	u8* t = (u8*)trans;
+
+	switch (anim->type)
+	{
+	// u8 pal[16]
+	case PALANIM_PAL16:
+		for (i = 0; i < 16; i++) if ((mask & (1 << i)) != 0) t[i] = pal[i];
+		break;
+
+	// u16 trans[256] on offset PLANE4_PALOFF
+	case PALANIM_PLANE16:
+		t += PLANE4_PALOFF;
+		// fall through
+
+	// u16 trans[256], LOW = high nibble, HIGH = low nibble
+	case PALANIM_TRANS16:
+		for (j = 0; j < 16; j++)
+		{
+			if ((mask & (1 << j)) != 0)
+			{
+				u8 c = pal[j];
+				for (i = 0; i < 16; i++)
+				{
+					t[(j*16 + i)*2] = c;
+					t[(i*16 + j)*2 + 1] = c;
+				}
+			}
+		}
+		break;
+
+	// u32 trans[256], bytes = pixels B7B6, B5B4, B3B2, B1B0
+	case PALANIM_TRANS4:
+		for (i = 0; i < 256; i++)
+		{
+			j = (i >> 6) & 3;
+			if ((mask & (1 << j)) != 0) t[0] = pal[j];
+			j = (i >> 4) & 3;
+			if ((mask & (1 << j)) != 0) t[1] = pal[j];
+			j = (i >> 2) & 3;
+			if ((mask & (1 << j)) != 0) t[2] = pal[j];
+			j = i & 3;
+			if ((mask & (1 << j)) != 0) t[3] = pal[j];
+			t += 4;
+		}
+		break;
+
+	// u32 trans[256], bytes = pixels B7B3, B6B2, B5B1, B4B0
+	default:
+		for (i = 0; i < 256; i++)
+		{
+			j = ((i >> 6) & 2) | ((i >> 3) & 1);
+			if ((mask & (1 << j)) != 0) t[0] = pal[j];
+			j = ((i >> 5) & 2) | ((i >> 2) & 1);
+			if ((mask & (1 << j)) != 0) t[1] = pal[j];
+			j = ((i >> 4) & 2) | ((i >> 1) & 1);
+			if ((mask & (1 << j)) != 0) t[2] = pal[j];
+			j = ((i >> 3) & 2) | (i & 1);
+			if ((mask & (1 << j)) != 0) t[3] = pal[j];
+			t += 4;
+		}
+		break;
+	}
+}
+
+// initialize palette animation and set palette table to video segment
+void PalAnimInit(sPalAnim* anim, sSegm* segm, u8 type, const u8* pal, void* trans1, void* trans2)
+{
+	int i;
+	anim->type = type;
+	anim->colors = ((type == PALANIM_TRANS4) || (type == PALANIM_PLANE4)) ? 4 : 16;
+	anim->addr = ((type == PALANIM_PLANE4) || (type == PALANIM_PAL16) || (type == PALANIM_PLANE16)) ? &segm->par2 : &segm->par;
+	anim->trans[0] = trans1;
+	anim->trans[1] = trans2;
+	anim->back = 1;
+	anim->frame = Frame;
+	anim->fade = 0;
+	anim->fadestep = 0;
+	for (i = 0; i < PALANIM_CYCMAX; i++) anim->cyc[i].num = 0;
+
+	// prepare palettes
+	memcpy(anim->base, pal, anim->colors);
+	memcpy(anim->target, pal, anim->colors);
+	memcpy(anim->pal[0], pal, anim->colors);
+	memcpy(anim->pal[1], pal, anim->colors);
+
+	// generate both tables
+	if (type == PALANIM_PLANE16)
+	{
+		GenPal16Plane((u8*)trans1, pal);
+		GenPal16Plane((u8*)trans2, pal);
+	}
+	else
+	{
+		PalAnimWrite(anim, trans1, pal, 0xffff);
+		PalAnimWrite(anim, trans2, pal, 0xffff);
+	}
+
+	// set front table to video segment
+	__dmb();
+	*anim->addr = (u32)trans1;
+	__dmb();
+}
+
+// set color of base palette
+void PalAnimSet(sPalAnim* anim, int inx, u8 col)
+{
+	anim->base[inx] = col;
+}
+
+// start cycling of palette range (returns index of cycling range, or -1 on error)
+int PalAnimCycle(sPalAnim* anim, int first, int num, int step, int speed)
+{
+	int i;
+	if ((num <= 1) || (first < 0) || (first + num > anim->colors)) return -1;
+	if (speed < 1) speed = 1;
+
+	for (i = 0; i < PALANIM_CYCMAX; i++)
+	{
+		sPalCycle* cyc = &anim->cyc[i];
+		if (cyc->num == 0)
+		{
+			cyc->first = (u8)first;
+			cyc->step = (s8)step;
+			cyc->speed = (u8)speed;
+			cyc->cnt = 0;
+			cyc->pos = 0;
+			__dmb();
+			cyc->num = (u8)num;
+			return i;
+		}
+	}
+	return -1;
+}
+
+// stop cycling of palette range (palette entries return to base palette)
+void PalAnimCycleOff(sPalAnim* anim, int inx)
+{
+	if ((inx >= 0) && (inx < PALANIM_CYCMAX)) anim->cyc[inx].num = 0;
+}
+
+// start fade
+void PalAnimFade(sPalAnim* anim, const u8* target, int speed)
+{
+	if (target != NULL) memcpy(anim->target, target, anim->colors);
+	anim->fadestep = (s16)speed;
+}
+
+// update palette animation (call once per frame, returns True if new palette has been prepared)
+Bool PalAnimUpdate(sPalAnim* anim)
+{
+	int i, k;
+
+	// previous palette table is not displayed yet
+	if (!VgaSwapDone(anim->addr)) return False;
+
+	// number of elapsed frames
+	u32 frame = Frame;
+	int n = (int)(frame - anim->frame);
+	if (n <= 0) return False;
+	anim->frame = frame;
+	if (n > 255) n = 255;
+
+	// shift cycling ranges
+	for (i = 0; i < PALANIM_CYCMAX; i++)
+	{
+		sPalCycle* cyc = &anim->cyc[i];
+		int num = cyc->num;
+		if (num == 0) continue;
+		k = cyc->cnt + n;
+		int steps = k / cyc->speed;
+		cyc->cnt = (u8)(k - steps*cyc->speed);
+		k = (cyc->pos + steps*cyc->step) % num;
+		if (k < 0) k += num;
+		cyc->pos = (u8)k;
+	}
+
+	// shift fade level
+	if (anim->fadestep != 0)
+	{
+		k = anim->fade + anim->fadestep*n;
+		if (k <= 0)
+		{
+			k = 0;
+			anim->fadestep = 0;
+		}
+		if (k >= 256)
+		{
+			k = 256;
+			anim->fadestep = 0;
+		}
+		anim->fade = (s16)k;
+	}
+
+	// base palette
+	u8 pal[16];
+	int colors = anim->colors;
+	memcpy(pal, anim->base, colors);
+
+	// cycling ranges
+	for (i = 0; i < PALANIM_CYCMAX; i++)
+	{
+		sPalCycle* cyc = &anim->cyc[i];
+		int num = cyc->num;
+		if (num == 0) continue;
+		const u8* src = &anim->base[cyc->first];
+		u8* dst = &pal[cyc->first];
+		int pos = cyc->pos;
+		for (k = 0; k < num; k++)
+		{
+			dst[k] = src[pos];
+			pos++;
+			if (pos >= num) pos = 0;
+		}
+	}
+
+	// fade
+	int fade = anim->fade;
+	if (fade > 0)
+	{
+		for (i = 0; i < colors; i++) pal[i] = PalAnimBlend(pal[i], anim->target[i], fade);
+	}
+
+	// no change against displayed palette
+	int back = anim->back;
+	if (memcmp(pal, anim->pal[back^1], colors) == 0) return False;
+
+	// update changed entries of back table
+	u8* bpal = anim->pal[back];
+	u16 mask = 0;
+	for (i = 0; i < colors; i++)
+	{
+		if (pal[i] != bpal[i])
+		{
+			mask |= 1 << i;
+			bpal[i] = pal[i];
+		}
+	}
+	PalAnimWrite(anim, anim->trans[back], pal, mask);
+
+	// swap tables at start of next frame
+	__dmb();
+	VgaSwap(anim->addr, (u32)anim->trans[back]);
+	anim->back = back ^ 1;
+	return True;
+}
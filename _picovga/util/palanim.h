@@ -0,0 +1,80 @@
+// ****************************************************************************
+//
+//                    Palette animation (cycling and fading)
+//
+// ****************************************************************************
+// Palette of 4 or 16 colors is recomputed once per frame from base palette,
+// cycling ranges and fade level. Translation table of the segment is double
+// buffered: only entries of changed colors are rewritten in the back table,
+// which is then swapped into the segment at start of next frame (see VgaSwap).
+// Cycling and fading cost nothing per pixel.
+
+#ifndef _PALANIM_H
+#define _PALANIM_H
+
+#define PALANIM_CYCMAX	4	// max. number of cycling ranges
+
+// type of palette table
+#define PALANIM_TRANS16	0	// GF_GRAPH4, 16 colors, u16 trans[256] in par (see GenPal16Trans)
+#define PALANIM_TRANS4	1	// GF_GRAPH2, 4 colors, u32 trans[256] in par (see GenPal4Trans)
+#define PALANIM_PLANE4	2	// GF_PLANE2, 4 colors, u32 trans[256] in par2 (see GenPal4Plane)
+#define PALANIM_PAL16	3	// GF_ATTRIB8 or GF_ATEXT, 16 colors, u8 pal[16] in par2
+#define PALANIM_PLANE16	4	// GF_PLANE4, 16 colors, u8 trans[PLANE4_TRANSSIZE] in par2 (see GenPal16Plane)
+
+// cycling range
+typedef struct {
+	u8	first;		// first palette entry
+	u8	num;		// number of palette entries (0 = range is off)
+	s8	step;		// shift per step (> 0 forward, < 0 backward)
+	u8	speed;		// number of frames per step
+	u8	cnt;		// frame counter
+	u8	pos;		// current rotation (0..num-1)
+} sPalCycle;
+
+// palette animation
+typedef struct {
+	u32*	addr;		// address of table pointer in video segment (par or par2)
+	void*	trans[2];	// 2 palette tables (size: 512, 1024, 1024, 16 or PLANE4_TRANSSIZE bytes by type)
+	u8	type;		// type of palette table PALANIM_*
+	u8	colors;		// number of colors (16 or 4)
+	u8	back;		// index of back table
+	u8	res;		// ...reserved, structure align
+	u32	frame;		// last processed frame
+	s16	fade;		// fade level 0..256 (0 = base palette, 256 = target palette)
+	s16	fadestep;	// change of fade level per frame
+	u8	base[16];	// base palette
+	u8	target[16];	// fade target palette
+	u8	pal[2][16];	// palettes currently stored in tables
+	sPalCycle cyc[PALANIM_CYCMAX]; // cycling ranges
+} sPalAnim;
+
+// initialize palette animation and set palette table to video segment
+//   anim = palette animation descriptor
+//   segm = video segment (must be set up before, its palette table will be replaced)
+//   type = type of palette table PALANIM_*
+//   pal = base palette of 4 or 16 colors
+//   trans1, trans2 = buffers of 2 palette tables
+void PalAnimInit(sPalAnim* anim, sSegm* segm, u8 type, const u8* pal, void* trans1, void* trans2);
+
+// set color of base palette
+void PalAnimSet(sPalAnim* anim, int inx, u8 col);
+
+// start cycling of palette range (returns index of cycling range, or -1 on error)
+//   first = first palette entry
+//   num = number of palette entries
+//   step = shift per step (> 0 forward, < 0 backward)
+//   speed = number of frames per step
+int PalAnimCycle(sPalAnim* anim, int first, int num, int step, int speed);
+
+// stop cycling of palette range (palette entries return to base palette)
+void PalAnimCycleOff(sPalAnim* anim, int inx);
+
+// start fade
+//   target = target palette (NULL = use last target palette)
+//   speed = change of fade level per frame (> 0 fade to target, < 0 fade back to base palette, 256 = 1 frame)
+void PalAnimFade(sPalAnim* anim, const u8* target, int speed);
+
+// update palette animation (call once per frame, returns True if new palette has been prepared)
+Bool PalAnimUpdate(sPalAnim* anim);
+
+#endif // _PALANIM_H
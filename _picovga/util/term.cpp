@@ -0,0 +1,547 @@
+// ****************************************************************************
+//
+//          VT100/ANSI terminal on text segment (GF_ATEXT, GF_FTEXT, GF_CTEXT)
+//
+// ****************************************************************************
+
+#include "include.h"
+
+// default palette of 16 ANSI colors (use as palette of GF_ATEXT segment)
+const u8 TermPal[16] = {
+	CGACOL_0,	// black
+	CGACOL_4,	// red
+	CGACOL_2,	// green
+	CGACOL_6,	// yellow (brown)
+	CGACOL_1,	// blue
+	CGACOL_5,	// magenta
+	CGACOL_3,	// cyan
+	CGACOL_7,	// white (light gray)
+	CGACOL_8,	// bright black (dark gray)
+	CGACOL_12,	// bright red
+	CGACOL_10,	// bright green
+	CGACOL_14,	// bright yellow
+	CGACOL_9,	// bright blue
+	CGACOL_13,	// bright magenta
+	CGACOL_11,	// bright cyan
+	CGACOL_15,	// bright white
+};
+
+// prepare bytes of text cell after character from current attributes
+static void TermAttr(sTerm* t)
+{
+	u8 fg = t->fg;
+	u8 bg = t->bg;
+	if (t->bold) fg |= ANSI_BRIGHT;
+	if (t->reverse) { u8 k = fg; fg = bg; bg = k; }
+
+	switch (t->form)
+	{
+	// character + 2x4 bit attributes (blink uses bit 7, see ScreenSegmBlink,
+	// so bright background is mapped to normal range)
+	case GF_ATEXT:
+		t->attr1 = fg | ((bg & ~ANSI_BRIGHT) << 4) | (t->blink ? B7 : 0);
+		break;
+
+	// character + foreground color
+	case GF_FTEXT:
+		t->attr1 = t->pal[fg];
+		break;
+
+	// character + background color + foreground color
+	default:
+		t->attr1 = t->pal[bg];
+		t->attr2 = t->pal[fg];
+		break;
+	}
+}
+
+// get pointer to logical text row
+static inline u8* TermRow(sTerm* t, int y)
+{
+	y += t->top;
+	if (y >= t->rows) y -= t->rows;
+	return &t->buf[y*t->wb];
+}
+
+// update cursor position
+static void TermCursor(sTerm* t)
+{
+	if (t->cursor)
+	{
+		int y = t->y + t->top;
+		if (y >= t->rows) y -= t->rows;
+		int x = t->x;
+		if (x >= t->cols) x = t->cols - 1;
+		if (TextCursor.segm != t->segm)
+			ScreenCursor(t->segm, x, y, t->fonth - 2, t->fonth - 1, 0xff, 4);
+		else
+			ScreenCursorPos(x, y);
+	}
+	else if (TextCursor.segm == t->segm)
+		ScreenCursorOff();
+}
+
+// update display offset after rotation of the screen
+static void TermOffY(sTerm* t)
+{
+	int offy = t->top * t->fonth;
+	if (t->segm->dbly) offy *= 2;
+	t->segm->offy = offy;
+	__dmb();
+}
+
+// erase characters in logical row (x1 = last position + 1)
+static void TermErase(sTerm* t, int y, int x0, int x1)
+{
+	if (x0 < 0) x0 = 0;
+	if (x1 > t->cols) x1 = t->cols;
+	if (x0 >= x1) return;
+	u8* d = &TermRow(t, y)[x0*t->cell];
+	u8 a1 = t->attr1;
+	u8 a2 = t->attr2;
+	int n = x1 - x0;
+
+	if (t->cell == 2)
+	{
+		// use attributes without blinking
+		if (t->form == GF_ATEXT) a1 &= ~B7;
+		for (; n > 0; n--)
+		{
+			d[0] = ' ';
+			d[1] = a1;
+			d += 2;
+		}
+	}
+	else
+	{
+		for (; n > 0; n--)
+		{
+			d[0] = ' ';
+			d[1] = a1;
+			d[2] = a2;
+			d += 3;
+		}
+	}
+}
+
+// erase whole logical rows (y1 = last row + 1)
+static void TermEraseRows(sTerm* t, int y0, int y1)
+{
+	for (; y0 < y1; y0++) TermErase(t, y0, 0, t->cols);
+}
+
+// scroll region up by n rows
+static void TermScrollUp(sTerm* t, int n)
+{
+	int top = t->scrtop;
+	int bot = t->scrbot;
+	int h = bot - top + 1;
+	if (n > h) n = h;
+	if (n <= 0) return;
+
+	// whole screen - rotate display offset, no copy
+	if ((top == 0) && (bot == t->rows-1))
+	{
+		t->top += n;
+		if (t->top >= t->rows) t->top -= t->rows;
+		TermEraseRows(t, t->rows - n, t->rows);
+		TermOffY(t);
+		return;
+	}
+
+	// part of screen - move rows
+	int y;
+	int len = t->cols*t->cell;
+	for (y = top; y <= bot - n; y++) memcpy(TermRow(t, y), TermRow(t, y + n), len);
+	TermEraseRows(t, bot - n + 1, bot + 1);
+}
+
+// scroll region down by n rows
+static void TermScrollDown(sTerm* t, int n)
+{
+	int top = t->scrtop;
+	int bot = t->scrbot;
+	int h = bot - top + 1;
+	if (n > h) n = h;
+	if (n <= 0) return;
+
+	// whole screen - rotate display offset, no copy
+	if ((top == 0) && (bot == t->rows-1))
+	{
+		t->top -= n;
+		if (t->top < 0) t->top += t->rows;
+		TermEraseRows(t, 0, n);
+		TermOffY(t);
+		return;
+	}
+
+	// part of screen - move rows
+	int y;
+	int len = t->cols*t->cell;
+	for (y = bot; y >= top + n; y--) memcpy(TermRow(t, y), TermRow(t, y - n), len);
+	TermEraseRows(t, top, top + n);
+}
+
+// line feed
+static void TermLF(sTerm* t)
+{
+	if (t->y == t->scrbot)
+		TermScrollUp(t, 1);
+	else if (t->y < t->rows-1)
+		t->y++;
+}
+
+// reverse line feed
+static void TermRevLF(sTerm* t)
+{
+	if (t->y == t->scrtop)
+		TermScrollDown(t, 1);
+	else if (t->y > 0)
+		t->y--;
+}
+
+// limit cursor position
+static void TermLimit(sTerm* t)
+{
+	if (t->x < 0) t->x = 0;
+	if (t->x >= t->cols) t->x = t->cols-1;
+	if (t->y < 0) t->y = 0;
+	if (t->y >= t->rows) t->y = t->rows-1;
+	t->wrapnext = False;
+}
+
+// write printable character
+static void TermPut(sTerm* t, char ch)
+{
+	// pending wrap
+	if (t->wrapnext)
+	{
+		t->wrapnext = False;
+		t->x = 0;
+		TermLF(t);
+	}
+
+	// store character
+	u8* d = &TermRow(t, t->y)[t->x*t->cell];
+	d[0] = ch;
+	d[1] = t->attr1;
+	if (t->cell == 3) d[2] = t->attr2;
+
+	// shift cursor
+	if (t->x < t->cols-1)
+		t->x++;
+	else if (t->wrap)
+		t->wrapnext = True;
+}
+
+// insert (n > 0) or delete (n < 0) characters at cursor position
+static void TermInsDel(sTerm* t, int n)
+{
+	u8* d = TermRow(t, t->y);
+	int cell = t->cell;
+	int x = t->x;
+	int cols = t->cols;
+	if (n > 0)
+	{
+		if (n > cols - x) n = cols - x;
+		memmove(&d[(x + n)*cell], &d[x*cell], (cols - x - n)*cell);
+		TermErase(t, t->y, x, x + n);
+	}
+	else
+	{
+		n = -n;
+		if (n > cols - x) n = cols - x;
+		memmove(&d[x*cell], &d[(x + n)*cell], (cols - x - n)*cell);
+		TermErase(t, t->y, cols - n, cols);
+	}
+}
+
+// select graphic rendition
+static void TermSGR(sTerm* t)
+{
+	int i, p;
+	for (i = 0; i <= t->parnum; i++)
+	{
+		p = t->par[i];
+		if (p == 0)
+		{
+			t->fg = t->deffg;
+			t->bg = t->defbg;
+			t->bold = False;
+			t->blink = False;
+			t->reverse = False;
+		}
+		else if (p == 1) t->bold = True;
+		else if (p == 5) t->blink = True;
+		else if (p == 7) t->reverse = True;
+		else if (p == 22) t->bold = False;
+		else if (p == 25) t->blink = False;
+		else if (p == 27) t->reverse = False;
+		else if ((p >= 30) && (p <= 37)) t->fg = p - 30;
+		else if (p == 39) t->fg = t->deffg;
+		else if ((p >= 40) && (p <= 47)) t->bg = p - 40;
+		else if (p == 49) t->bg = t->defbg;
+		else if ((p >= 90) && (p <= 97)) t->fg = p - 90 + ANSI_BRIGHT;
+		else if ((p >= 100) && (p <= 107)) t->bg = p - 100 + ANSI_BRIGHT;
+	}
+	TermAttr(t);
+}
+
+// execute CSI sequence
+static void TermCSI(sTerm* t, char ch)
+{
+	int p0 = t->par[0];
+	int n = (p0 == 0) ? 1 : p0; // count parameter with default 1
+
+	// private sequences
+	if (t->priv)
+	{
+		if ((ch == 'h') || (ch == 'l'))
+		{
+			Bool on = (ch == 'h');
+			if (p0 == 25) t->cursor = on;
+			if (p0 == 7) t->wrap = on;
+		}
+		return;
+	}
+
+	switch (ch)
+	{
+	case 'A': t->y -= n; if (t->y < t->scrtop) t->y = t->scrtop; TermLimit(t); break; // cursor up
+	case 'B': t->y += n; if (t->y > t->scrbot) t->y = t->scrbot; TermLimit(t); break; // cursor down
+	case 'C': t->x += n; TermLimit(t); break; // cursor right
+	case 'D': t->x -= n; TermLimit(t); break; // cursor left
+	case 'E': t->x = 0; t->y += n; TermLimit(t); break; // cursor next line
+	case 'F': t->x = 0; t->y -= n; TermLimit(t); break; // cursor previous line
+	case 'G': t->x = n - 1; TermLimit(t); break; // cursor column
+
+	// cursor position
+	case 'H':
+	case 'f':
+		t->y = n - 1;
+		t->x = ((t->parnum > 0) && (t->par[1] > 0)) ? (t->par[1] - 1) : 0;
+		TermLimit(t);
+		break;
+
+	case 'd': t->y = n - 1; TermLimit(t); break; // cursor row
+
+	// erase display
+	case 'J':
+		if (p0 == 0)
+		{
+			TermErase(t, t->y, t->x, t->cols);
+			TermEraseRows(t, t->y + 1, t->rows);
+		}
+		else if (p0 == 1)
+		{
+			TermEraseRows(t, 0, t->y);
+			TermErase(t, t->y, 0, t->x + 1);
+		}
+		else
+			TermEraseRows(t, 0, t->rows);
+		break;
+
+	// erase line
+	case 'K':
+		if (p0 == 0)
+			TermErase(t, t->y, t->x, t->cols);
+		else if (p0 == 1)
+			TermErase(t, t->y, 0, t->x + 1);
+		else
+			TermErase(t, t->y, 0, t->cols);
+		break;
+
+	// insert or delete lines (only inside scroll region)
+	case 'L':
+	case 'M':
+		if ((t->y >= t->scrtop) && (t->y <= t->scrbot))
+		{
+			int k = t->scrtop;
+			t->scrtop = t->y;
+			if (ch == 'L')
+				TermScrollDown(t, n);
+			else
+				TermScrollUp(t, n);
+			t->scrtop = k;
+			t->x = 0;
+		}
+		break;
+
+	case '@': TermInsDel(t, n); break; // insert characters
+	case 'P': TermInsDel(t, -n); break; // delete characters
+	case 'X': TermErase(t, t->y, t->x, t->x + n); break; // erase characters
+	case 'S': TermScrollUp(t, n); break; // scroll up
+	case 'T': TermScrollDown(t, n); break; // scroll down
+
+	// set scroll region
+	case 'r':
+		{
+			int top = (p0 > 0) ? (p0 - 1) : 0;
+			int bot = ((t->parnum > 0) && (t->par[1] > 0)) ? (t->par[1] - 1) : (t->rows - 1);
+			if (bot >= t->rows) bot = t->rows - 1;
+			if (top < bot)
+			{
+				t->scrtop = top;
+				t->scrbot = bot;
+				t->x = 0;
+				t->y = 0;
+				t->wrapnext = False;
+			}
+		}
+		break;
+
+	case 's': t->savex = t->x; t->savey = t->y; break; // save cursor
+	case 'u': t->x = t->savex; t->y = t->savey; TermLimit(t); break; // restore cursor
+	case 'm': TermSGR(t); break; // select graphic rendition
+	}
+}
+
+// write character to terminal, without updating cursor
+static void TermChar0(sTerm* t, char ch)
+{
+	u8 c = (u8)ch;
+	switch (t->state)
+	{
+	// normal character
+	case TERM_NORMAL:
+		if (c >= 0x20)
+		{
+			TermPut(t, ch);
+			return;
+		}
+
+		switch (c)
+		{
+		case 0x1b: t->state = TERM_ESC; break; // ESC
+		case '\r': t->x = 0; t->wrapnext = False; break; // CR
+		case '\n': // LF
+		case 0x0b: // VT
+		case 0x0c: // FF
+			TermLF(t);
+			t->wrapnext = False;
+			break;
+		case '\b': if (t->x > 0) t->x--; t->wrapnext = False; break; // BS
+		case '\t': t->x = (t->x + 8) & ~7; TermLimit(t); break; // TAB
+		}
+		break;
+
+	// ESC received
+	case TERM_ESC:
+		t->state = TERM_NORMAL;
+		switch (ch)
+		{
+		case '[':
+			t->state = TERM_CSI;
+			t->parnum = 0;
+			t->par[0] = 0;
+			t->priv = False;
+			break;
+
+		case '7': t->savex = t->x; t->savey = t->y; break; // save cursor
+		case '8': t->x = t->savex; t->y = t->savey; TermLimit(t); break; // restore cursor
+		case 'D': TermLF(t); break; // index
+		case 'E': t->x = 0; TermLF(t); t->wrapnext = False; break; // next line
+		case 'M': TermRevLF(t); t->wrapnext = False; break; // reverse index
+		case 'c': TermReset(t); break; // reset
+		}
+		break;
+
+	// ESC [ received
+	default:
+		if ((c >= '0') && (c <= '9'))
+		{
+			int* p = &t->par[t->parnum];
+			if (*p < 10000) *p = *p*10 + (c - '0');
+		}
+		else if (c == ';')
+		{
+			if (t->parnum < TERM_PARMAX-1)
+			{
+				t->parnum++;
+				t->par[t->parnum] = 0;
+			}
+		}
+		else if (c == '?')
+			t->priv = True;
+		else if ((c >= 0x40) && (c <= 0x7e))
+		{
+			t->state = TERM_NORMAL;
+			TermCSI(t, ch);
+		}
+		else if (c < 0x20)
+		{
+			// control character inside sequence is executed, ESC starts new sequence
+			t->state = TERM_NORMAL;
+			TermChar0(t, ch);
+			if (c != 0x1b) t->state = TERM_CSI;
+		}
+		break;
+	}
+}
+
+// initialize terminal
+void TermInit(sTerm* term, sSegm* segm, int cols, int rows)
+{
+	term->segm = segm;
+	term->buf = (u8*)segm->data;
+	term->pal = TermPal;
+	term->wb = segm->wb;
+	term->cols = cols;
+	term->rows = rows;
+	term->form = segm->form;
+	term->cell = (segm->form == GF_CTEXT) ? 3 : 2;
+	term->fonth = (u8)segm->par3;
+	term->deffg = ANSI_WHITE;
+	term->defbg = ANSI_BLACK;
+	segm->wrapy = rows*term->fonth;
+	TermReset(term);
+}
+
+// reset terminal (clears screen and resets attributes)
+void TermReset(sTerm* term)
+{
+	term->x = 0;
+	term->y = 0;
+	term->savex = 0;
+	term->savey = 0;
+	term->top = 0;
+	term->scrtop = 0;
+	term->scrbot = term->rows - 1;
+	term->parnum = 0;
+	term->state = TERM_NORMAL;
+	term->priv = False;
+	term->fg = term->deffg;
+	term->bg = term->defbg;
+	term->bold = False;
+	term->blink = False;
+	term->reverse = False;
+	term->wrap = True;
+	term->wrapnext = False;
+	term->cursor = True;
+	TermAttr(term);
+	TermEraseRows(term, 0, term->rows);
+	TermOffY(term);
+	TermCursor(term);
+}
+
+// write character to terminal
+void TermChar(sTerm* term, char ch)
+{
+	TermChar0(term, ch);
+	TermCursor(term);
+}
+
+// write text to terminal
+void TermText(sTerm* term, const char* text)
+{
+	char ch;
+	while ((ch = *text++) != 0) TermChar0(term, ch);
+	TermCursor(term);
+}
+
+// write buffer to terminal
+void TermWrite(sTerm* term, const char* buf, int len)
+{
+	for (; len > 0; len--) TermChar0(term, *buf++);
+	TermCursor(term);
+}
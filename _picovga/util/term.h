@@ -0,0 +1,109 @@
+// ****************************************************************************
+//
+//          VT100/ANSI terminal on text segment (GF_ATEXT, GF_FTEXT, GF_CTEXT)
+//
+// ****************************************************************************
+// Text screen is scrolled by rotating offy of the video segment within wrapy,
+// so scrolling of whole screen does not move text buffer. Scroll region smaller
+// than whole screen is scrolled by moving its rows.
+//
+// Supported control characters: BEL, BS, HT, LF, VT, FF, CR, ESC.
+// Supported escape sequences:
+//   ESC 7, ESC 8 ... save/restore cursor
+//   ESC D, ESC E, ESC M ... index, next line, reverse index
+//   ESC c ... reset terminal
+//   ESC [ n A/B/C/D/E/F/G ... cursor up/down/right/left/next line/previous line/column
+//   ESC [ r;c H/f ... cursor position
+//   ESC [ n d ... cursor row
+//   ESC [ n J ... erase display (0=to end, 1=to cursor, 2=all)
+//   ESC [ n K ... erase line (0=to end, 1=to cursor, 2=all)
+//   ESC [ n L/M ... insert/delete lines
+//   ESC [ n @/P/X ... insert/delete/erase characters
+//   ESC [ n S/T ... scroll up/down
+//   ESC [ t;b r ... set scroll region
+//   ESC [ s, ESC [ u ... save/restore cursor
+//   ESC [ ?25 h/l ... show/hide cursor
+//   ESC [ ?7 h/l ... auto wrap on/off
+//   ESC [ ... m ... SGR: 0 reset, 1 bold, 5 blink, 7 reverse, 22, 25, 27,
+//			30..37, 39, 40..47, 49, 90..97, 100..107
+
+#ifndef _TERM_H
+#define _TERM_H
+
+#define TERM_PARMAX	8	// max. number of parameters of escape sequence
+
+// parser state
+#define TERM_NORMAL	0	// normal character
+#define TERM_ESC	1	// ESC received
+#define TERM_CSI	2	// ESC [ received
+
+// ANSI colors (index into palette)
+#define ANSI_BLACK	0
+#define ANSI_RED	1
+#define ANSI_GREEN	2
+#define ANSI_YELLOW	3
+#define ANSI_BLUE	4
+#define ANSI_MAGENTA	5
+#define ANSI_CYAN	6
+#define ANSI_WHITE	7
+#define ANSI_BRIGHT	8	// flag of bright color
+
+// default palette of 16 ANSI colors (use as palette of GF_ATEXT segment)
+extern const u8 TermPal[16];
+
+// terminal
+typedef struct {
+	sSegm*	segm;		// video segment with text
+	u8*	buf;		// text buffer
+	const u8* pal;		// palette of 16 ANSI colors (used with GF_FTEXT and GF_CTEXT)
+	int	wb;		// pitch of text rows in bytes
+	int	cols;		// number of columns
+	int	rows;		// number of rows
+	int	x, y;		// cursor position (y = logical row)
+	int	savex, savey;	// saved cursor position
+	int	top;		// physical row of first logical row (rotation of the screen)
+	int	scrtop;		// first row of scroll region
+	int	scrbot;		// last row of scroll region
+	int	par[TERM_PARMAX]; // parameters of escape sequence
+	u8	parnum;		// number of parameters
+	u8	state;		// parser state TERM_*
+	u8	priv;		// private sequence ESC [ ?
+	u8	form;		// text format GF_ATEXT, GF_FTEXT or GF_CTEXT
+	u8	cell;		// size of text cell in bytes (2 or 3)
+	u8	fonth;		// font height
+	u8	fg, bg;		// current foreground and background color (ANSI index 0..15)
+	u8	attr1, attr2;	// prepared bytes of text cell after character
+	u8	deffg, defbg;	// default foreground and background color
+	u8	bold;		// bold attribute
+	u8	blink;		// blink attribute
+	u8	reverse;	// reverse attribute
+	u8	wrap;		// auto wrap mode
+	u8	wrapnext;	// wrap pending (cursor stays at last column)
+	u8	cursor;		// cursor is visible
+} sTerm;
+
+// initialize terminal
+//   term = terminal descriptor
+//   segm = video segment with text GF_ATEXT, GF_FTEXT or GF_CTEXT (must be set up before, its
+//          height should be rows*fontheight; it will be used as whole screen, wrapy and offy are changed)
+//   cols = number of columns
+//   rows = number of rows
+// With GF_ATEXT, palette of the segment should be in ANSI order (e.g. TermPal); bit 7
+// of the attribute is blink flag, so bright background colors (SGR 100..107, or bold
+// with reverse) are shown in normal intensity,
+// with GF_FTEXT and GF_CTEXT, colors are translated using TermPal (change term->pal to use another palette).
+void TermInit(sTerm* term, sSegm* segm, int cols, int rows);
+
+// reset terminal (clears screen and resets attributes)
+void TermReset(sTerm* term);
+
+// write character to terminal
+void TermChar(sTerm* term, char ch);
+
+// write text to terminal
+void TermText(sTerm* term, const char* text);
+
+// write buffer to terminal
+void TermWrite(sTerm* term, const char* buf, int len);
+
+#endif // _TERM_H
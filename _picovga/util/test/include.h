@@ -0,0 +1,154 @@
+// ****************************************************************************
+//
+//                  Host test build - common definitions
+//
+// ****************************************************************************
+// Replaces the project include.h when util modules are compiled on the host
+// (see Makefile). Integer types follow the RP2040 sizes (u32 is 32 bits also
+// on 64-bit hosts), SDK hardware functions used by util modules are stubbed.
+
+#ifndef _TEST_INCLUDE_H
+#define _TEST_INCLUDE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// base types
+typedef signed char s8;
+typedef unsigned char u8;
+typedef signed short s16;
+typedef unsigned short u16;
+typedef signed int s32;
+typedef unsigned int u32;
+typedef signed long long int s64;
+typedef unsigned long long int u64;
+typedef unsigned int uint;
+
+typedef unsigned char Bool;
+#define True 1
+#define False 0
+
+#define INLINE __attribute__((always_inline)) inline
+#define NOINLINE __attribute__((noinline))
+#define ALIGNED __attribute__((aligned(4)))
+
+#define	B0 (1<<0)
+#define	B1 (1<<1)
+#define	B2 (1<<2)
+#define	B3 (1<<3)
+#define	B4 (1<<4)
+#define	B5 (1<<5)
+#define	B6 (1<<6)
+#define	B7 (1<<7)
+#define	B8 (1U<<8)
+#define	B15 (1U<<15)
+#define	B16 (1U<<16)
+#define	B31 (1U<<31)
+#define BIT(pos) (1U<<(pos))
+
+#define count_of(a) (sizeof(a)/sizeof((a)[0]))
+
+#define PI 3.14159265358979324
+#define PI2 (3.14159265358979324*2)
+
+// fonts
+extern const ALIGNED u8 FontBoldB8x16[4096];
+
+// SDK stubs
+#define __dmb() __sync_synchronize()
+#define __not_in_flash_func(f) f
+
+// memory functions of the library (C versions of assembler functions)
+inline u32* MemSet4(u32* d, u32 val, int num) { for (; num > 0; num--) *d++ = val; return d; }
+inline void BlitKey(u8* d, u8* s, int w, u8 key) { for (; w > 0; w--, d++, s++) if (*s != key) *d = *s; }
+
+// DMA emulation: control block chains (list of alias 1 register writes) are executed
+// synchronously when the control channel is triggered, other transfers are copied at once
+#define NUM_DMA_CHANNELS 12
+#define DMA_SIZE_8	0
+#define DMA_SIZE_16	1
+#define DMA_SIZE_32	2
+typedef struct { u32 ctrl; } dma_channel_config;
+typedef struct { u32 read_addr, write_addr, transfer_count, ctrl_trig,
+	al1_ctrl, al1_read_addr, al1_write_addr, al1_transfer_count_trig; } dma_channel_hw_t;
+struct sHostDmaInts { void operator=(u32 mask); }; // write clears raw interrupt flags
+typedef struct {
+	dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+	u32 intr;	// raw interrupt flags
+	sHostDmaInts ints0;
+	u32 rows;	// number of transfers done by control block chains (statistics)
+	u32 lists;	// number of started control block chains (statistics)
+} sHostDma;
+extern sHostDma HostDma;
+#define dma_hw (&HostDma)
+inline void sHostDmaInts::operator=(u32 mask) { HostDma.intr &= ~mask; }
+inline dma_channel_config dma_channel_get_default_config(int ch) { dma_channel_config c = { (u32)ch << 11 }; return c; }
+inline void channel_config_set_read_increment(dma_channel_config* c, bool on) {}
+inline void channel_config_set_write_increment(dma_channel_config* c, bool on) {}
+inline void channel_config_set_transfer_data_size(dma_channel_config* c, int size) {}
+inline void channel_config_set_ring(dma_channel_config* c, bool write, int bits) {}
+inline void channel_config_set_chain_to(dma_channel_config* c, int ch) { c->ctrl = (c->ctrl & ~(15 << 11)) | (ch << 11); }
+inline void channel_config_set_irq_quiet(dma_channel_config* c, bool on) { c->ctrl |= B31; }
+inline u32 channel_config_get_ctrl_value(const dma_channel_config* c) { return c->ctrl; }
+inline void dma_channel_configure(int ch, const dma_channel_config* c, volatile void* d, const volatile void* s,
+	u32 n, bool trig) { dma_hw->ch[ch].write_addr = (u32)(size_t)d; dma_hw->ch[ch].read_addr = (u32)(size_t)s;
+	dma_hw->ch[ch].transfer_count = n; if (trig) memcpy((void*)d, (const void*)s, n*4); }
+inline void dma_channel_set_read_addr(int ch, const volatile void* s, bool trig)
+{
+	const u32* e = (const u32*)s;
+	int data = (int)((dma_hw->ch[ch].write_addr - (u32)(size_t)&dma_hw->ch[0].al1_ctrl)/sizeof(dma_channel_hw_t));
+	for (; e[3] != 0; e += 4, dma_hw->rows++) memcpy((void*)(size_t)e[2], (const void*)(size_t)e[1], e[3]*4);
+	dma_hw->intr |= 1u << data;
+	dma_hw->lists++;
+}
+
+// interpolator emulation (lanes with add_raw, shift and mask)
+typedef struct { int shift, lsb, msb; } interp_config;
+inline interp_config interp_default_config() { interp_config c = { 0, 0, 31 }; return c; }
+inline void interp_config_set_add_raw(interp_config* c, bool on) {}
+inline void interp_config_set_shift(interp_config* c, int shift) { c->shift = shift; }
+inline void interp_config_set_mask(interp_config* c, int lsb, int msb) { c->lsb = lsb; c->msb = msb; }
+inline void interp_config_set_signed(interp_config* c, bool on) {}
+inline void interp_config_set_cross_input(interp_config* c, bool on) {}
+inline void interp_config_set_cross_result(interp_config* c, bool on) {}
+inline void (*HostIrq)() = NULL; // emulated interrupt, called on every pop (NULL = none)
+struct sHostInterp
+{
+	interp_config cfg[2];
+	u32 accum[2];
+	u32 base[3];
+	u32 Lane(int i) { u32 m = ((cfg[i].msb == 31) ? 0xffffffffu : ((1u << (cfg[i].msb+1)) - 1)) &
+		~((1u << cfg[i].lsb) - 1); return (accum[i] >> cfg[i].shift) & m; }
+	struct { sHostInterp* p; u32 operator[](int k) { u32 r0 = p->Lane(0), r1 = p->Lane(1);
+		u32 r = (k == 2) ? p->base[2] + r0 + r1 : ((k == 0) ? p->base[0] + r0 : p->base[1] + r1);
+		p->accum[0] += p->base[0]; p->accum[1] += p->base[1]; if (HostIrq != NULL) HostIrq();
+		return r; } } pop;
+	sHostInterp() { pop.p = this; }
+};
+extern sHostInterp HostInterp0, HostInterp1;
+#define interp0 (&HostInterp0)
+#define interp1 (&HostInterp1)
+inline void interp_set_config(sHostInterp* i, int lane, interp_config* c) { i->cfg[lane] = *c; }
+
+// VGA core stubs (provided by the test)
+extern volatile Bool VgaCoreRun;
+u32 Core1Post(void (*fnc)(void*), void* arg, volatile Bool* done = NULL);
+Bool Core1Done(u32 seq);
+void Core1WaitJob(u32 seq);
+
+#include "../../define.h"	// common definitions of C and ASM
+#include "../canvas.h"		// canvas
+#include "../overclock.h"	// overclock
+#include "../mat2d.h"		// 2D transformation matrix
+#include "../../vga_pal.h"	// VGA colors and palettes
+#include "../../vga_vmode.h"	// VGA videomodes
+#include "../vgasolve.h"	// videomode timing solver
+#include "../../vga_screen.h"	// VGA screen layout
+#include "../term.h"		// VT100/ANSI terminal
+#include "../modeline.h"	// video timings from modeline and CVT
+#include "../drawlist.h"	// deferred draw lists
+
+#endif // _TEST_INCLUDE_H
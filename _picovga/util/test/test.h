@@ -0,0 +1,38 @@
+// ****************************************************************************
+//
+//                         Host test helpers
+//
+// ****************************************************************************
+
+#ifndef _TEST_H
+#define _TEST_H
+
+#include "include.h"
+#include <time.h>
+
+// number of failed checks
+static int Fails = 0;
+
+// print benchmarks (set with BENCH=1 environment variable)
+static const Bool Verbose = (getenv("BENCH") != NULL);
+
+// check condition
+#define CHECK(cond) do { if (!(cond)) { Fails++; \
+	printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+// current time in seconds
+static inline double Now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// print result of the test
+static inline int Result(const char* name)
+{
+	printf("%s: %s\n", name, (Fails == 0) ? "OK" : "FAILED");
+	return (Fails == 0) ? 0 : 1;
+}
+
+#endif // _TEST_H
@@ -0,0 +1,630 @@
+// ****************************************************************************
+//
+//                          Host test of canvas
+//
+// ****************************************************************************
+// Canvas code casts pointers to u32, as on the target, so the test is linked
+// without PIE and all image buffers are static (see Makefile).
+
+#include "test.h"
+
+sHostDma HostDma;
+sHostInterp HostInterp0, HostInterp1;
+
+#define W	640	// width of test image
+#define H	480	// height of test image
+#define WBMAX	(W+64)	// max. pitch
+#define BUFSIZE	(WBMAX*H*5/4) // size of image buffer (with attributes)
+
+static u8 Back[BUFSIZE];
+static u8 Front[BUFSIZE];
+static u8 Font[256*16];
+static u8 Spr[3][64*48];
+static sCanvas SprCan[3];
+
+// random number
+static int Rnd(int n) { return rand() % n; }
+
+// compare visible part of canvases (returns True if equal)
+static Bool Same(const sCanvas* a, const sCanvas* b)
+{
+	int wb = (a->format == CANVAS_8) ? a->w : (a->format == CANVAS_4) ? a->w/2 :
+		(a->format == CANVAS_2) ? a->w/4 : a->w/8;
+	int rows = a->h;
+	if (a->format == CANVAS_PLANE4) rows *= 4;
+	if (a->format == CANVAS_ATTRIB8) rows += a->h/8;
+	for (int y = 0; y < rows; y++)
+		if (memcmp(a->img + y*a->wb, b->img + y*b->wb, wb) != 0) return False;
+	return True;
+}
+
+// random drawing
+static void DrawRandom(sCanvas* c, int cm)
+{
+	int x = Rnd(c->w + 40) - 20;
+	int y = Rnd(c->h + 40) - 20;
+	int w = Rnd(200);
+	int h = Rnd(100);
+	u8 col = (u8)(rand() & cm);
+	switch (Rnd(5))
+	{
+	case 0: DrawRect(c, x, y, w, h, col); break;
+	case 1: DrawFrame(c, x, y, w, h, col); break;
+	case 2: DrawLine(c, x, y, x + w - 100, y + h - 50, col); break;
+	case 3: DrawText(c, "Canvas", x, y, col, Font, 16); break;
+	case 4: DrawFillCircle(c, x, y, w/4, col); break;
+	}
+}
+
+// Gouraud triangle matches color plane through vertices (also with falling colors)
+static void TestGouraud()
+{
+	sCanvas c;
+	CanvasInit(&c, CANVAS_8, 160, 120, 160, Back);
+	int pix = 0;
+	for (int it = 0; it < 3000; it++)
+	{
+		memset(Back, 0, 160*120);
+		int x1 = Rnd(200) - 20, y1 = Rnd(160) - 20;
+		int x2 = Rnd(200) - 20, y2 = Rnd(160) - 20;
+		int x3 = Rnd(200) - 20, y3 = Rnd(160) - 20;
+		int c1 = 16 + Rnd(224), c2 = 16 + Rnd(224), c3 = 16 + Rnd(224);
+		int d = (x2 - x1)*(y3 - y1) - (x3 - x1)*(y2 - y1);
+		if (d == 0) continue;
+		DrawGouraudTriangle(&c, x1, y1, (u8)c1, x2, y2, (u8)c2, x3, y3, (u8)c3);
+
+		double gx = ((c2 - c1)*(y3 - y1) - (c3 - c1)*(y2 - y1))/(double)d;
+		double gy = ((c3 - c1)*(x2 - x1) - (c2 - c1)*(x3 - x1))/(double)d;
+		int cmin = c1, cmax = c1;
+		if (c2 < cmin) cmin = c2;
+		if (c3 < cmin) cmin = c3;
+		if (c2 > cmax) cmax = c2;
+		if (c3 > cmax) cmax = c3;
+		for (int y = 0; y < 120; y++)
+			for (int x = 0; x < 160; x++)
+			{
+				int k = Back[x + y*160];
+				if (k == 0) continue;
+				pix++;
+				int e = (int)floor(c1 + gx*(x + 0.5 - x1) + gy*(y + 0.5 - y1) + 0.5);
+				if (e < cmin) e = cmin;
+				if (e > cmax) e = cmax;
+				if (abs(k - e) > 1)
+				{
+					Fails++;
+					printf("gouraud fail: %d,%d is %d, expected %d\n", x, y, k, e);
+					return;
+				}
+			}
+	}
+	CHECK(pix > 0);
+}
+
+// polygon with more than DRAWPOLY_MAX vertices is not drawn (not truncated)
+static void TestPolyMax()
+{
+	sCanvas c;
+	s16 xy[2*(DRAWPOLY_MAX+1)];
+	CanvasInit(&c, CANVAS_8, 160, 120, 160, Back);
+	for (int i = 0; i <= DRAWPOLY_MAX; i++)
+	{
+		double a = i*2*M_PI/(DRAWPOLY_MAX+1);
+		xy[2*i] = (s16)(80 + 50*cos(a));
+		xy[2*i+1] = (s16)(60 + 50*sin(a));
+	}
+	memset(Back, 0, 160*120);
+	DrawFillPoly(&c, xy, DRAWPOLY_MAX+1, 1);
+	int pix = 0;
+	for (int i = 0; i < 160*120; i++) pix += Back[i];
+	CHECK(pix == 0);
+	DrawFillPoly(&c, xy, DRAWPOLY_MAX, 1);
+	for (int i = 0; i < 160*120; i++) pix += Back[i];
+	CHECK(pix > 0);
+}
+
+// prepare sprite images (pitch power of 2 and other)
+static void InitSprites()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		CanvasInit(&SprCan[i], CANVAS_8, (i == 1) ? 40 : 32, 32 + 8*i, (i == 1) ? 40 : 64, Spr[i]);
+		for (unsigned j = 0; j < sizeof(Spr[i]); j++) Spr[i][j] = (u8)rand();
+	}
+}
+
+// random transformed sprite
+static void RandomSprite(sDrawImgItem* it, cMat2Di* m, int n)
+{
+	const sCanvas* src = &SprCan[(n < 0) ? Rnd(3) : n];
+	it->src = src;
+	it->x = (s16)(Rnd(200) - 20);
+	it->y = (s16)(Rnd(140) - 20);
+	it->w = (s16)(8 + Rnd(60));
+	it->h = (s16)(8 + Rnd(60));
+	it->mode = (Rnd(2) == 0) ? DRAWIMG_TRANSP : DRAWIMG_NOBORDER;
+	if (Rnd(8) == 0) it->mode = DRAWIMG_CLAMP;
+	it->color = (u8)rand();
+	m->PrepDrawImg(src->w, src->h, src->w/2, src->h/2, it->w, it->h, 0, 0, Rnd(ANGLE_FULL),
+		src->w/2*FRACTMUL, src->h/2*FRACTMUL);
+	it->mat = m->Int();
+}
+
+// batch of overlapping sprites gives the same image as single sprites, in list order
+static void TestBatch()
+{
+	sCanvas a, b;
+	sDrawImgItem item[50];
+	cMat2Di mat[50];
+	CanvasInit(&a, CANVAS_8, 160, 120, 160, Back);
+	CanvasInit(&b, CANVAS_8, 160, 120, 160, Front);
+	for (int it = 0; it < 400; it++)
+	{
+		int n = 1 + Rnd(50);
+		for (int i = 0; i < n; i++) RandomSprite(&item[i], &mat[i], (it & 1) ? -1 : i/8 % 3);
+		memset(Back, 0, 160*120);
+		memset(Front, 0, 160*120);
+		DrawImgMatBatch(&a, item, n);
+		for (int i = 0; i < n; i++)
+			DrawImgMat(&b, item[i].src, item[i].x, item[i].y, item[i].w, item[i].h,
+				&mat[i], item[i].mode, item[i].color);
+		if (!Same(&a, &b))
+		{
+			Fails++;
+			printf("batch fail: %d sprites\n", n);
+			return;
+		}
+	}
+}
+
+// color of pixel of CANVAS_ATTRIB8 canvas
+static int Attr8Get(const sCanvas* c, int x, int y)
+{
+	u8 a = c->img2[(y/8)*c->wb + x/8];
+	return (((c->img[y*c->wb + x/8] >> (7 - (x & 7))) & 1) != 0) ? (a & 0x0f) : (a >> 4);
+}
+
+// converted image into CANVAS_ATTRIB8 does not change pixels outside clipping box
+static void TestConvAttr8()
+{
+	static u8 Old[160*120];
+	sCanvas c, src;
+	sDrawConv conv;
+	CanvasInit(&c, CANVAS_ATTRIB8, 160, 120, 20, Back);
+	CanvasInit(&src, CANVAS_8, 64, 64, 64, Front);
+	conv.pal = NULL;
+	for (int it = 0; it < 2000; it++)
+	{
+		for (int i = 0; i < 20*120*9/8; i++) Back[i] = (u8)rand();
+		for (int i = 0; i < 64*64; i++) Front[i] = (u8)rand();
+		for (int i = 0; i < 256; i++) conv.map[i] = (u8)(rand() & 15);
+		for (int y = 0; y < 120; y++)
+			for (int x = 0; x < 160; x++) Old[x + y*160] = (u8)Attr8Get(&c, x, y);
+
+		int bx = Rnd(160), by = Rnd(120), bw = Rnd(160), bh = Rnd(120);
+		CanvasClipPush(&c, bx, by, bw, bh);
+		if (bx + bw > 160) bw = 160 - bx;
+		if (by + bh > 120) bh = 120 - by;
+		int xd = Rnd(180) - 10, yd = Rnd(140) - 10, w = Rnd(64), h = Rnd(64);
+		int xs = Rnd(64), ys = Rnd(64);
+		DrawImgConv(&c, &src, xd, yd, xs, ys, w, h, &conv);
+		CanvasClipPop(&c);
+
+		for (int y = 0; y < 120; y++)
+			for (int x = 0; x < 160; x++)
+			{
+				int k = Attr8Get(&c, x, y);
+				if ((x >= bx) && (x < bx + bw) && (y >= by) && (y < by + bh))
+				{
+					// new pixel with one of cell colors is drawn exactly
+					u8 a = c.img2[(y/8)*20 + x/8];
+					int xx = x - xd + xs, yy = y - yd + ys;
+					if ((x < xd) || (x >= xd + w) || (y < yd) || (y >= yd + h) ||
+						(xx >= 64) || (yy >= 64)) continue;
+					int e = conv.map[Front[xx + yy*64]];
+					if (((e == (a & 15)) || (e == (a >> 4))) && (k != e))
+					{
+						Fails++;
+						printf("attr8 fail: new pixel %d,%d is %d, expected %d\n", x, y, k, e);
+						return;
+					}
+				}
+				else if (k != Old[x + y*160])
+				{
+					Fails++;
+					printf("attr8 fail: pixel %d,%d outside clipping box changed\n", x, y);
+					return;
+				}
+			}
+	}
+}
+
+// get pixel value (CANVAS_ATTRIB8: pixel bit)
+static int GetPix(const sCanvas* c, int x, int y)
+{
+	const u8* s = c->img + y*c->wb;
+	int v = 0;
+	switch (c->format)
+	{
+	case CANVAS_8: return s[x];
+	case CANVAS_4: return (s[x/2] >> (4 - (x & 1)*4)) & 15;
+	case CANVAS_2: return (s[x/4] >> (6 - (x & 3)*2)) & 3;
+	case CANVAS_PLANE4:
+		v = (((s[x/8 + 3*(c->img2 - c->img)] >> (7 - (x & 7))) & 1) << 3) |
+			(((s[x/8 + 2*(c->img2 - c->img)] >> (7 - (x & 7))) & 1) << 2);
+		// continue to CANVAS_PLANE2
+	case CANVAS_PLANE2:
+		v |= ((s[x/8 + (c->img2 - c->img)] >> (7 - (x & 7))) & 1) << 1;
+		// continue to CANVAS_1
+	default: return v | ((s[x/8] >> (7 - (x & 7))) & 1);
+	}
+}
+
+// flood fill gives the same image as reference fill pixel by pixel
+static void TestFill()
+{
+	static const u8 Formats[] = { CANVAS_8, CANVAS_4, CANVAS_2, CANVAS_1, CANVAS_PLANE2,
+		CANVAS_PLANE4, CANVAS_ATTRIB8 };
+	static u8 Reg[90*72];
+	static int Stack[90*72];
+	static u8 Mask[12*72];
+	int tests = 0;
+	for (int it = 0; it < 6000; it++)
+	{
+		// image with big regions of few colors
+		u8 f = Formats[it % count_of(Formats)];
+		int w = 1 + Rnd(90);
+		int h = 1 + Rnd(70);
+		if (f == CANVAS_ATTRIB8) h = (h + 7) & ~7;
+		int bits = (f == CANVAS_8) ? 8 : (f == CANVAS_4) ? 4 : (f == CANVAS_2) ? 2 : 1;
+		int wb = (w*bits + 7)/8 + Rnd(3);
+		int cm = (f == CANVAS_8) ? 255 : ((f == CANVAS_4) || (f == CANVAS_PLANE4)) ? 15 :
+			((f == CANVAS_2) || (f == CANVAS_PLANE2)) ? 3 : (f == CANVAS_ATTRIB8) ? 31 : 1;
+		int ncol = (f == CANVAS_8) ? 3 : 2;
+		sCanvas c, r;
+		CanvasInit(&c, f, w, h, wb, Back);
+		CanvasInit(&r, f, w, h, wb, Front);
+		for (int i = 0; i < wb*h*4; i++) Back[i] = (u8)rand();
+		DrawRect(&c, 0, 0, w, h, 0);
+		int n = Rnd(40);
+		for (int i = 0; i < n; i++)
+			DrawRect(&c, Rnd(w) - 5, Rnd(h) - 5, Rnd(30), Rnd(30), (u8)((Rnd(ncol)*((f == CANVAS_8) ? 37 : 1)) & cm));
+		if (Rnd(3) == 0)
+			for (int i = 0; i < w*h/4; i++) DrawPoint(&c, Rnd(w), Rnd(h), (u8)Rnd(ncol));
+		memcpy(Front, Back, wb*h*4);
+
+		// reference region
+		int sx = Rnd(w), sy = Rnd(h);
+		int t = GetPix(&c, sx, sy);
+		memset(Reg, 0, w*h);
+		int sp = 0;
+		Stack[sp++] = sx + sy*w;
+		Reg[sx + sy*w] = 1;
+		while (sp > 0)
+		{
+			int p = Stack[--sp];
+			int x = p % w, y = p / w;
+			for (int k = 0; k < 4; k++)
+			{
+				int x2 = x + ((k == 0) ? -1 : (k == 1) ? 1 : 0);
+				int y2 = y + ((k == 2) ? -1 : (k == 3) ? 1 : 0);
+				if ((x2 < 0) || (y2 < 0) || (x2 >= w) || (y2 >= h) || (Reg[x2 + y2*w] != 0) ||
+					(GetPix(&c, x2, y2) != t)) continue;
+				Reg[x2 + y2*w] = 1;
+				Stack[sp++] = x2 + y2*w;
+			}
+		}
+
+		u8 col = (u8)(rand() & cm);
+		u8 bg = (u8)(rand() & cm);
+		u8 pat[8];
+		for (int i = 0; i < 8; i++) pat[i] = (u8)rand();
+		Bool ok;
+		if ((it & 1) == 0)
+		{
+			// solid fill
+			ok = DrawFill(&c, sx, sy, col);
+			for (int y = 0; y < h; y++)
+				for (int x = 0; x < w; x++)
+				{
+					if (Reg[x + y*w] == 0) continue;
+					if (f == CANVAS_ATTRIB8)
+						DrawRect(&r, x, y, 1, 1, (col & 15) | ((t != 0) ? B4 : 0));
+					else
+						DrawPoint(&r, x, y, col);
+				}
+		}
+		else
+		{
+			// pattern fill, mask is required if pattern uses color of the region
+			sCanvas m;
+			CanvasInit(&m, CANVAS_1, w, h, (w + 7)/8, Mask);
+			Bool usemask = (Rnd(2) == 0);
+			ok = DrawFillPat(&c, sx, sy, pat, col, bg, usemask ? &m : NULL);
+			int pm = (f == CANVAS_8) ? 255 : ((f == CANVAS_2) || (f == CANVAS_PLANE2)) ? 3 :
+				(f == CANVAS_1) ? 1 : 15;
+			Bool usefg = False, usebg = False;
+			for (int i = 0; i < 8; i++)
+			{
+				if (pat[i] != 0) usefg = True;
+				if (pat[i] != 0xff) usebg = True;
+			}
+			Bool conf = (f == CANVAS_ATTRIB8) || (usefg && ((col & pm) == t)) || (usebg && ((bg & pm) == t));
+			if (!usemask && conf)
+			{
+				CHECK(!ok && (memcmp(Back, Front, wb*h*4) == 0));
+				continue;
+			}
+
+			for (int y = 0; y < h; y++)
+				for (int x = 0; x < w; x++)
+				{
+					if (Reg[x + y*w] == 0) continue;
+					Bool b = ((pat[y & 7] >> (7 - (x & 7))) & 1) != 0;
+					if (f == CANVAS_ATTRIB8)
+					{
+						u8* d = r.img + y*wb + x/8;
+						if (b) *d |= 0x80 >> (x & 7); else *d &= ~(0x80 >> (x & 7));
+						r.img2[(y/8)*wb + x/8] = (bg << 4) | (col & 15);
+					}
+					else
+						DrawPoint(&r, x, y, b ? col : bg);
+				}
+		}
+
+		// stack overflow is allowed on complex regions
+		if (!ok) continue;
+		tests++;
+		if (memcmp(Back, Front, wb*h*4) != 0)
+		{
+			Fails++;
+			printf("fill fail: format %d, %dx%d, pattern %d\n", f, w, h, it & 1);
+			return;
+		}
+	}
+	CHECK(tests > 5000);
+
+	// serpentine overflows stack, refill from unfilled pixels completes it
+	sCanvas c;
+	CanvasInit(&c, CANVAS_4, W, H, W/2, Back);
+	DrawRect(&c, 0, 0, W, H, 0);
+	for (int x = 2; x < W; x += 4) DrawRect(&c, x, ((x/4) & 1) ? 0 : 2, 1, H - 2, 1);
+	Bool ok = DrawFill(&c, 0, 0, 5);
+	CHECK(!ok);
+	for (int pass = 0; (pass < 100) && !ok; pass++)
+	{
+		ok = True;
+		for (int y = 0; y < H; y++)
+			for (int x = 0; x < W; x++)
+				if ((GetPix(&c, x, y) == 0) && !DrawFill(&c, x, y, 5)) ok = False;
+	}
+	CHECK(ok);
+	for (int y = 0; y < H; y++)
+		for (int x = 0; x < W; x++)
+			if (GetPix(&c, x, y) == 0) { CHECK(False); return; }
+}
+
+// present dirty regions in all formats, also with different pitch of displayed canvas
+static void TestPresent()
+{
+	static const u8 Formats[] = { CANVAS_8, CANVAS_4, CANVAS_2, CANVAS_1, CANVAS_PLANE4, CANVAS_ATTRIB8 };
+	for (int it = 0; it < 600; it++)
+	{
+		u8 f = Formats[it % count_of(Formats)];
+		int w = (8 + Rnd(W - 8)) & ~7;
+		int h = (8 + Rnd(H/2)) & ~7;
+		int bits = (f == CANVAS_8) ? 8 : (f == CANVAS_4) ? 4 : (f == CANVAS_2) ? 2 : 1;
+		int wb = w*bits/8;
+		int wbs = (wb + 3 + 4*Rnd(8)) & ~3;
+		int wbd = (it & 1) ? wbs : ((wb + 3 + 4*Rnd(8)) & ~3);
+		int cm = (f == CANVAS_8) ? 255 : ((f == CANVAS_4) || (f == CANVAS_PLANE4)) ? 15 :
+			(f == CANVAS_2) ? 3 : (f == CANVAS_ATTRIB8) ? 31 : 1;
+
+		// both canvases start with equal image
+		sCanvas back, front;
+		sDirty dirty;
+		CanvasInit(&back, f, w, h, wbs, Back);
+		CanvasInit(&front, f, w, h, wbd, Front);
+		for (int i = 0; i < BUFSIZE; i++) Back[i] = (u8)rand();
+		int rows = (f == CANVAS_PLANE4) ? h*4 : (f == CANVAS_ATTRIB8) ? h + h/8 : h;
+		for (int y = 0; y < rows; y++) memcpy(Front + y*wbd, Back + y*wbs, wb);
+		CanvasDirtyOn(&back, &dirty);
+
+		// draw and present
+		int n = 1 + Rnd(20);
+		for (int i = 0; i < n; i++) DrawRandom(&back, cm);
+		int size = CanvasPresent(&front, &back);
+		CHECK(dirty.num == 0);
+		CHECK(size <= rows*((wb + 3) & ~3));
+		if (!Same(&front, &back))
+		{
+			Fails++;
+			printf("present fail: format %d, %dx%d, pitch %d/%d\n", f, w, h, wbs, wbd);
+		}
+	}
+
+	// long rows were copied by chained DMA, flag is cleared after present
+	CHECK(HostDma.rows > 0);
+	CHECK((HostDma.intr & (1u << CANVAS_DMA)) == 0);
+}
+
+// widget updates at 640x480 4-bit
+static void BenchWidgets()
+{
+	static const char* const Names[] = {
+		"button press 120x32 + frame + text",
+		"label 20 chars 8x16",
+		"cursor move 16x16 by (5,3)",
+		"4 status fields in corners",
+		"40 small markers in one row",
+		"dialog 300x200 open",
+	};
+
+	sCanvas back, front;
+	sDirty dirty;
+	CanvasInit(&back, CANVAS_4, W, H, W/2, Back);
+	CanvasInit(&front, CANVAS_4, W, H, W/2, Front);
+	CanvasDirtyOn(&back, &dirty);
+
+	printf("  canvas 640x480 4-bit widget updates (host, DMA emulated by memcpy):\n");
+	for (unsigned k = 0; k < count_of(Names); k++)
+	{
+		int size = 0, loops = 2000;
+		u32 rows = HostDma.rows, lists = HostDma.lists;
+		double t = Now();
+		for (int i = 0; i < loops; i++)
+		{
+			switch (k)
+			{
+			case 0:
+				DrawRect(&back, 200, 200, 120, 32, 7);
+				DrawFrame(&back, 200, 200, 120, 32, 15);
+				DrawText(&back, "Press me", 228, 208, 0, Font, 16);
+				break;
+
+			case 1:
+				DrawTextBg(&back, "Label with 20 chars.", 20, 100, 15, 1, Font, 16);
+				break;
+
+			case 2:
+				DrawRect(&back, 300, 300, 16, 16, 0);
+				DrawRect(&back, 305, 303, 16, 16, 14);
+				break;
+
+			case 3:
+				DrawTextBg(&back, "12:00", 0, 0, 15, 1, Font, 16);
+				DrawTextBg(&back, "100%", W-32, 0, 15, 1, Font, 16);
+				DrawTextBg(&back, "OK", 0, H-16, 15, 1, Font, 16);
+				DrawTextBg(&back, "x=10", W-32, H-16, 15, 1, Font, 16);
+				break;
+
+			case 4:
+				for (int j = 0; j < 40; j++) DrawRect(&back, 20 + j*15, 400, 5, 5, (u8)j);
+				break;
+
+			case 5:
+				DrawRect(&back, 170, 140, 300, 200, 7);
+				DrawFrame(&back, 170, 140, 300, 200, 15);
+				DrawTextBg(&back, "Dialog", 180, 144, 15, 1, Font, 16);
+				break;
+			}
+			size = CanvasPresent(&front, &back);
+		}
+		t = Now() - t;
+		printf("  %-36s %6d B (%4.1f%%), %3u DMA rows, %u DMA lists, %6.2f us (host)\n", Names[k],
+			size, size*100.0/(W*H/2), (HostDma.rows - rows)/loops, (HostDma.lists - lists)/loops,
+			t*1e6/loops);
+	}
+}
+
+// batch of sprites against single sprites (host)
+static void BenchSprites()
+{
+	sCanvas c;
+	sDrawImgItem item[50];
+	cMat2Di mat[50];
+	CanvasInit(&c, CANVAS_8, 320, 240, 320, Back);
+	printf("  50 sprites 32x32 rotated 45 deg at 320x240 8-bit (host, interpolator emulated):\n");
+	for (int i = 0; i < 50; i++)
+	{
+		item[i].x = (s16)(10 + (i % 10)*30);
+		item[i].y = (s16)(10 + (i / 10)*45);
+		item[i].w = 45;
+		item[i].h = 45;
+		item[i].mode = DRAWIMG_TRANSP;
+		item[i].color = 0;
+		mat[i].PrepDrawImg(32, 32, 16, 16, 45, 45, 0, 0, DEG2ANGLE(45), 16*FRACTMUL, 16*FRACTMUL);
+		item[i].mat = mat[i].Int();
+	}
+
+	// source pitch 64 uses interpolator, pitch 40 uses C loop
+	for (int s = 0; s < 2; s++)
+	{
+		for (int i = 0; i < 50; i++) item[i].src = &SprCan[s];
+		int loops = 2000;
+		double t = Now();
+		for (int k = 0; k < loops; k++)
+			for (int i = 0; i < 50; i++)
+				DrawImgMat(&c, item[i].src, item[i].x, item[i].y, 45, 45, &mat[i], DRAWIMG_TRANSP, 0);
+		double t1 = Now() - t;
+
+		t = Now();
+		for (int k = 0; k < loops; k++) DrawImgMatBatch(&c, item, 50);
+		double t2 = Now() - t;
+
+		printf("  source pitch %d: DrawImgMat %6.1f us, DrawImgMatBatch %6.1f us (host)\n",
+			SprCan[s].wb, t1*1e6/loops, t2*1e6/loops);
+	}
+}
+
+// flood fill of 640x480 4-bit canvas (host)
+static void BenchFill()
+{
+	static const u8 Pat[8] = { 0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55 };
+	sCanvas c;
+	CanvasInit(&c, CANVAS_4, W, H, W/2, Back);
+	printf("  canvas 640x480 4-bit flood fill (host):\n");
+	for (int k = 0; k < 3; k++)
+	{
+		int loops = 50;
+		double t = 0;
+		for (int i = 0; i < loops; i++)
+		{
+			DrawRect(&c, 0, 0, W, H, 0);
+			if (k == 1)
+			{
+				srand(1);
+				for (int j = 0; j < 200; j++)
+					DrawCircle(&c, 70 + Rnd(W - 140), 70 + Rnd(H - 140), 5 + Rnd(60), 3);
+			}
+			double t0 = Now();
+			if (k == 2)
+				DrawFillPat(&c, 1, 1, Pat, 3, 4);
+			else
+				DrawFill(&c, 1, 1, 9);
+			t += Now() - t0;
+		}
+		printf("  %-36s %8.0f us (host)\n", (k == 0) ? "empty screen" :
+			(k == 1) ? "200 circles" : "empty screen, pattern", t*1e6/loops);
+	}
+}
+
+// Gouraud triangles per second (host)
+static void BenchTriangles()
+{
+	sCanvas c;
+	CanvasInit(&c, CANVAS_8, 320, 240, 320, Back);
+	printf("  canvas 320x240 8-bit Gouraud triangles (host):\n");
+	for (int size = 8; size <= 32; size += 12)
+	{
+		int loops = 200000;
+		double t = Now();
+		for (int i = 0; i < loops; i++)
+		{
+			int x = (i*7) % (320 - size);
+			int y = (i*13) % (240 - size);
+			DrawGouraudTriangle(&c, x, y, 200, x + size, y, 20, x, y + size, 100);
+		}
+		t = Now() - t;
+		printf("  %2dx%-2d right triangle %9.0f triangles/s (host)\n", size, size, loops/t);
+	}
+}
+
+int main()
+{
+	for (unsigned i = 0; i < sizeof(Font); i++) Font[i] = (u8)rand();
+	TestPresent();
+	TestGouraud();
+	TestPolyMax();
+	TestConvAttr8();
+	TestFill();
+	InitSprites();
+	TestBatch();
+	if (Verbose)
+	{
+		BenchWidgets();
+		BenchTriangles();
+		BenchSprites();
+		BenchFill();
+	}
+	return Result("canvas");
+}
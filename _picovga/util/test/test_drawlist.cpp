@@ -0,0 +1,250 @@
+// ****************************************************************************
+//
+//                        Host test of deferred draw lists
+//
+// ****************************************************************************
+// Core 1 job is executed when core 0 waits for it, after core 0 has drawn its
+// band, so split lists are drawn in the opposite order than with one core.
+
+#include "test.h"
+
+sHostDma HostDma;
+sHostInterp HostInterp0, HostInterp1;
+
+// core 1 stub
+volatile Bool VgaCoreRun = False;
+static void (*JobFnc)(void*) = NULL;
+static void* JobArg;
+static u32 JobSeq = 0;
+
+u32 Core1Post(void (*fnc)(void*), void* arg, volatile Bool* done)
+{
+	JobFnc = fnc;
+	JobArg = arg;
+	return ++JobSeq;
+}
+
+Bool Core1Done(u32 seq) { return JobFnc == NULL; }
+
+void Core1WaitJob(u32 seq)
+{
+	if (JobFnc != NULL) JobFnc(JobArg);
+	JobFnc = NULL;
+}
+
+#define W	160	// max. width of test image
+#define H	120	// max. height of test image
+#define BUFSIZE	(W*H*5/4) // size of image buffer (with attributes)
+
+static u8 ImgA[BUFSIZE];
+static u8 ImgB[BUFSIZE];
+static u8 Src[64*64];
+static u8 Font[256*8];
+static u32 Buf[4096];
+static sCanvas SrcCan;		// pointer is recorded into 32-bit word, must not be on stack
+
+// random number
+static int Rnd(int n) { return rand() % n; }
+
+// record random command
+static void Record(sDrawList* list, const sCanvas* src, int w, int h, int cm)
+{
+	int x = Rnd(w + 40) - 20;
+	int y = Rnd(h + 40) - 20;
+	int x2 = Rnd(w + 40) - 20;
+	int y2 = Rnd(h + 40) - 20;
+	int x3 = Rnd(w + 40) - 20;
+	int y3 = Rnd(h + 40) - 20;
+	u8 col = (u8)(rand() & cm);
+	s16 xy[DRAWPOLY_MAX*2];
+	int n, i;
+	cMat2Di m;
+
+	switch (Rnd(10))
+	{
+	case 0: DrawListRect(list, x, y, Rnd(60), Rnd(60), col); break;
+	case 1: DrawListLine(list, x, y, x2, y2, col); break;
+	case 2: DrawListFillCircle(list, x, y, Rnd(30), col); break;
+	case 3: DrawListText(list, "List", x, y, col, Font); break;
+	case 4:
+		n = 3 + Rnd(10);
+		for (i = 0; i < n; i++)
+		{
+			xy[2*i] = (s16)(Rnd(w + 40) - 20);
+			xy[2*i+1] = (s16)(Rnd(h + 40) - 20);
+		}
+		DrawListFillPoly(list, xy, n, col);
+		break;
+	case 5: case 6: DrawListFillTriangle(list, x, y, x2, y2, x3, y3, col); break;
+	case 7: DrawListGouraudTriangle(list, x, y, (u8)(rand() & cm), x2, y2, (u8)(rand() & cm),
+		x3, y3, (u8)(rand() & cm)); break;
+	case 8: case 9:
+		m.PrepDrawImg(64, 64, Rnd(64), Rnd(64), 10 + Rnd(60), 10 + Rnd(60), 0, 0,
+			DEG2ANGLE(Rnd(360)), Rnd(64), Rnd(64));
+		DrawListImgMat(list, src, x, y, 10 + Rnd(60), 10 + Rnd(60), &m,
+			(Rnd(2) == 0) ? DRAWIMG_TRANSP : DRAWIMG_CLAMP, col);
+		break;
+	}
+}
+
+// split list on 2 cores gives the same image as list on 1 core
+static void TestSplit()
+{
+	static const u8 Formats[] = { CANVAS_8, CANVAS_4, CANVAS_2, CANVAS_1, CANVAS_PLANE2,
+		CANVAS_PLANE4, CANVAS_ATTRIB8 };
+	sCanvas* src = &SrcCan;
+	CanvasInit(src, CANVAS_8, 64, 64, 64, Src);
+	for (int i = 0; i < (int)sizeof(Src); i++) Src[i] = (u8)rand();
+
+	for (int it = 0; it < 700; it++)
+	{
+		u8 f = Formats[it % count_of(Formats)];
+		int w = 8 + Rnd(W - 8);
+		int h = (8 + Rnd(H - 8)) & ~7;
+		int bits = (f == CANVAS_8) ? 8 : (f == CANVAS_4) ? 4 : (f == CANVAS_2) ? 2 : 1;
+		int wb = (w*bits + 7)/8;
+		int cm = (f == CANVAS_8) ? 255 : ((f == CANVAS_4) || (f == CANVAS_PLANE4)) ? 15 :
+			((f == CANVAS_2) || (f == CANVAS_PLANE2)) ? 3 : (f == CANVAS_ATTRIB8) ? 31 : 1;
+
+		sCanvas a, b;
+		sDirty da, db;
+		CanvasInit(&a, f, w, h, wb, ImgA);
+		CanvasInit(&b, f, w, h, wb, ImgB);
+		for (int i = 0; i < BUFSIZE; i++) ImgA[i] = (u8)rand();
+		memcpy(ImgB, ImgA, BUFSIZE);
+		CanvasDirtyOn(&a, &da);
+		CanvasDirtyOn(&b, &db);
+
+		// record list
+		sDrawList list;
+		DrawListInit(&list, &a, Buf, count_of(Buf));
+		int n = 1 + Rnd(30);
+		for (int i = 0; i < n; i++) Record(&list, src, w, h, cm);
+		CHECK(!list.over);
+
+		// execute on 1 core
+		VgaCoreRun = False;
+		DrawListSubmit(&list);
+		CHECK(DrawListDone(&list));
+
+		// execute split on 2 cores
+		VgaCoreRun = True;
+		list.canvas = &b;
+		DrawListSubmit(&list, True);
+		DrawListWait(&list);
+		CHECK(DrawListDone(&list));
+
+		if (memcmp(ImgA, ImgB, BUFSIZE) != 0)
+		{
+			Fails++;
+			printf("split fail: format %d, %dx%d\n", f, w, h);
+		}
+
+		// dirty region of split list covers all changes
+		CHECK((da.num > 0) == (db.num > 0));
+	}
+
+	// overflow of command buffer
+	sCanvas a;
+	sDrawList list;
+	CanvasInit(&a, CANVAS_8, 64, 64, 64, ImgA);
+	DrawListInit(&list, &a, Buf, 12);
+	cMat2Di m;
+	m.Unit();
+	DrawListImgMat(&list, src, 0, 0, 10, 10, &m, DRAWIMG_CLAMP, 0);
+	CHECK(!list.over && (list.len == 10));
+	DrawListFillTriangle(&list, 0, 0, 10, 0, 0, 10, 1);
+	CHECK(list.over && (list.len == 10));
+}
+
+// emulated scanline interrupt of core 1, reprograms interpolators as perspective tiles do
+static int IrqCnt;
+static Bool IrqSave;
+static void Irq()
+{
+	if ((++IrqCnt % 37) != 0) return;
+	sHostInterp s0 = HostInterp0, s1 = HostInterp1;
+	sHostInterp* i[2] = { &HostInterp0, &HostInterp1 };
+	for (int k = 0; k < 2; k++)
+	{
+		for (int lane = 0; lane < 2; lane++)
+		{
+			// keep addresses inside source image, test must not crash without save
+			i[k]->cfg[lane].shift = Rnd(16);
+			i[k]->cfg[lane].lsb = 0;
+			i[k]->cfg[lane].msb = 10;
+		}
+		i[k]->accum[0] = (u32)rand();
+		i[k]->accum[1] = (u32)rand();
+		i[k]->base[0] = (u32)rand();
+		i[k]->base[1] = (u32)rand();
+		i[k]->base[2] = (u32)(size_t)Src;
+	}
+	if (IrqSave)
+	{
+		HostInterp0 = s0;
+		HostInterp1 = s1;
+	}
+}
+
+// images with matrix on core 1 are correct if interrupt saves interpolators
+static void TestInterp()
+{
+	static u8 Img3[160*120];
+	sCanvas a, b, c;
+	CanvasInit(&a, CANVAS_8, 160, 120, 160, ImgA);
+	CanvasInit(&b, CANVAS_8, 160, 120, 160, ImgB);
+	CanvasInit(&c, CANVAS_8, 160, 120, 160, Img3);
+	CanvasInit(&SrcCan, CANVAS_8, 64, 64, 64, Src);
+	for (int i = 0; i < (int)sizeof(Src); i++) Src[i] = (u8)rand();
+
+	int diff = 0;
+	for (int it = 0; it < 100; it++)
+	{
+		sDrawList list;
+		DrawListInit(&list, &a, Buf, count_of(Buf));
+		for (int i = 0; i < 10; i++)
+		{
+			cMat2Di m;
+			int w = 10 + Rnd(60), h = 10 + Rnd(60);
+			m.PrepDrawImg(64, 64, 32, 32, w, h, 0, 0, Rnd(ANGLE_FULL), 32*FRACTMUL, 32*FRACTMUL);
+			static const u8 Modes[] = { DRAWIMG_NOBORDER, DRAWIMG_TRANSP, DRAWIMG_WRAP };
+			DrawListImgMat(&list, &SrcCan, Rnd(160) - 20, Rnd(120) - 20, w, h, &m,
+				Modes[Rnd(3)], (u8)rand());
+		}
+		memset(ImgA, 0, 160*120);
+		memset(ImgB, 0, 160*120);
+		memset(Img3, 0, 160*120);
+
+		// reference, without interrupts
+		VgaCoreRun = False;
+		HostIrq = NULL;
+		DrawListSubmit(&list);
+
+		// core 1 with interrupt saving interpolators
+		VgaCoreRun = True;
+		HostIrq = Irq;
+		IrqSave = True;
+		list.canvas = &b;
+		DrawListSubmit(&list);
+		DrawListWait(&list);
+		CHECK(memcmp(ImgA, ImgB, 160*120) == 0);
+
+		// interrupt not saving interpolators damages image (check that test can see it)
+		IrqSave = False;
+		list.canvas = &c;
+		DrawListSubmit(&list);
+		DrawListWait(&list);
+		if (memcmp(ImgA, Img3, 160*120) != 0) diff++;
+		HostIrq = NULL;
+	}
+	CHECK(diff > 0);
+}
+
+int main()
+{
+	for (unsigned i = 0; i < sizeof(Font); i++) Font[i] = (u8)rand();
+	TestSplit();
+	TestInterp();
+	return Result("drawlist");
+}
@@ -0,0 +1,121 @@
+// ****************************************************************************
+//
+//                   Host test of fixed-point transformation matrix
+//
+// ****************************************************************************
+
+#include "test.h"
+
+// random number
+static int Rnd(int n) { return rand() % n; }
+
+// fixed-point sine and cosine differ from float by max. 1 LSB
+static void TestSin()
+{
+	int err = 0;
+	for (int a = -ANGLE_FULL; a <= 2*ANGLE_FULL; a += 7)
+	{
+		int s = TOFRACT(sinf(a*(2*PI/ANGLE_FULL)));
+		int c = TOFRACT(cosf(a*(2*PI/ANGLE_FULL)));
+		int e = abs(SinFract(a) - s);
+		if (e > err) err = e;
+		e = abs(CosFract(a) - c);
+		if (e > err) err = e;
+	}
+	CHECK(err <= 1);
+}
+
+// map point by integer matrix array to source image
+static void Map(const int* m, int x, int y, float* xs, float* ys)
+{
+	*xs = (float)((s64)m[0]*x + (s64)m[1]*y + m[2])/FRACTMUL;
+	*ys = (float)((s64)m[3]*x + (s64)m[4]*y + m[5])/FRACTMUL;
+}
+
+// PrepDrawImg of fixed-point matrix maps image corners as float matrix does
+static void TestPrep()
+{
+	double sum = 0;
+	float max = 0;
+	int num = 0;
+	for (int it = 0; it < 100000; it++)
+	{
+		int ws = 8 + Rnd(249);
+		int hs = 8 + Rnd(249);
+		int x0 = Rnd(ws);
+		int y0 = Rnd(hs);
+		int wd = 8 + Rnd(313);
+		int hd = 8 + Rnd(233);
+		if (Rnd(4) == 0) wd = -wd;
+		if (Rnd(4) == 0) hd = -hd;
+		int shx = (Rnd(4) == 0) ? Rnd(FRACTMUL) - FRACTMUL/2 : 0;
+		int shy = (Rnd(4) == 0) ? Rnd(FRACTMUL) - FRACTMUL/2 : 0;
+		int r = Rnd(ANGLE_FULL);
+		int tx = Rnd(ws*FRACTMUL);
+		int ty = Rnd(hs*FRACTMUL);
+
+		cMat2Di mi;
+		mi.PrepDrawImg(ws, hs, x0, y0, wd, hd, shx, shy, r, tx, ty);
+
+		cMat2Df mf;
+		mf.PrepDrawImg(ws, hs, x0, y0, wd, hd, (float)shx/FRACTMUL, (float)shy/FRACTMUL,
+			r*(2*PI/ANGLE_FULL), (float)tx/FRACTMUL, (float)ty/FRACTMUL);
+		int m[6];
+		mf.ExportInt(m);
+
+		// corners of destination image
+		for (int k = 0; k < 4; k++)
+		{
+			int x = (k & 1) ? abs(wd) : 0;
+			int y = (k & 2) ? abs(hd) : 0;
+			float xi, yi, xf, yf;
+			Map(mi.Int(), x, y, &xi, &yi);
+			Map(m, x, y, &xf, &yf);
+			float e = fabsf(xi - xf);
+			if (fabsf(yi - yf) > e) e = fabsf(yi - yf);
+			sum += e;
+			num++;
+			if (e > max) max = e;
+		}
+	}
+	CHECK(max < 0.5f);
+	if (Verbose) printf("  cMat2Di corners vs cMat2Df: %.4f px average, %.3f px max\n", sum/num, max);
+}
+
+// setups of matrix per second (host)
+static void BenchPrep()
+{
+	int loops = 1000000;
+	int m[6];
+	volatile int sink = 0;
+
+	double t = Now();
+	for (int i = 0; i < loops; i++)
+	{
+		cMat2Df mf;
+		mf.PrepDrawImg(64, 64, 32, 32, 40 + (i & 63), 50, 0, 0, i*0.001f, 0, 0);
+		mf.ExportInt(m);
+		sink += m[0];
+	}
+	double tf = Now() - t;
+
+	t = Now();
+	for (int i = 0; i < loops; i++)
+	{
+		cMat2Di mi;
+		mi.PrepDrawImg(64, 64, 32, 32, 40 + (i & 63), 50, 0, 0, i*10, 0, 0);
+		sink += mi.Int()[0];
+	}
+	double ti = Now() - t;
+
+	printf("  PrepDrawImg + export: cMat2Df %9.0f /s, cMat2Di %9.0f /s (host, hardware float)\n",
+		loops/tf, loops/ti);
+}
+
+int main()
+{
+	TestSin();
+	TestPrep();
+	if (Verbose) BenchPrep();
+	return Result("mat2d");
+}
@@ -0,0 +1,182 @@
+// ****************************************************************************
+//
+//               Host test of video timings from modeline and CVT
+//
+// ****************************************************************************
+
+#include "test.h"
+
+// reference timings (pixel clock in kHz, horizontal in pixels, vertical in lines)
+typedef struct {
+	const char* name;
+	u32	pclk;
+	int	hdisp, hss, hse, htot;
+	int	vdisp, vss, vse, vtot;
+	Bool	psync;
+} sRefMode;
+
+// VESA DMT and CEA reference modes
+static const sRefMode DmtModes[] = {
+	{ "640x480@60",	  25175,  640,  656,  752,  800,  480,  490,  492,  525, False },
+	{ "800x600@60",	  40000,  800,  840,  968, 1056,  600,  601,  605,  628, True },
+	{ "1024x768@60",  65000, 1024, 1048, 1184, 1344,  768,  771,  777,  806, False },
+	{ "1920x1080@60", 148500, 1920, 2008, 2052, 2200, 1080, 1084, 1089, 1125, True },
+};
+
+// VESA CVT reference modes at 60 Hz (VESA CVT 1.2 spreadsheet)
+static const sRefMode CvtModes[] = {
+	{ "640x480",	  23750,  640,  664,  720,  800,  480,  483,  487,  500, False },
+	{ "800x600",	  38250,  800,  832,  912, 1024,  600,  603,  607,  624, False },
+	{ "1024x768",	  63500, 1024, 1072, 1176, 1328,  768,  771,  775,  798, False },
+	{ "1920x1080",	 173000, 1920, 2048, 2248, 2576, 1080, 1083, 1088, 1120, False },
+};
+
+// VESA CVT reduced blanking reference modes at 60 Hz
+static const sRefMode CvtRbModes[] = {
+	{ "800x600",	  35500,  800,  848,  880,  960,  600,  603,  607,  618, True },
+	{ "1024x768",	  56000, 1024, 1072, 1104, 1184,  768,  771,  775,  790, True },
+	{ "1920x1080",	 138500, 1920, 1968, 2000, 2080, 1080, 1083, 1088, 1111, True },
+};
+
+// convert time in [us] back to pixels
+static int Px(float us, u32 pclk) { return (int)(us*pclk/1000.0f + 0.5f); }
+
+// compare generated timings with reference
+static void CheckMode(const sModeline* m, const sRefMode* r)
+{
+	const sVideo* v = &m->video;
+	Bool ok = (m->pclk == r->pclk) && (m->width == r->hdisp) && (m->htot == r->htot) &&
+		(m->height == r->vdisp) &&
+		(Px(v->hfull, m->pclk) == r->hdisp) &&
+		(Px(v->hfront, m->pclk) == r->hss - r->hdisp) &&
+		(Px(v->hsync, m->pclk) == r->hse - r->hss) &&
+		(Px(v->hback, m->pclk) == r->htot - r->hse) &&
+		(Px(v->htot, m->pclk) == r->htot) &&
+		(v->vtot == r->vtot) && (v->vmax == r->vdisp) && (v->vact1 == r->vdisp) &&
+		(v->vfront1 == r->vss - r->vdisp) && (v->vsync1 == r->vse - r->vss) &&
+		(v->vback1 == r->vtot - r->vse) && (v->psync == r->psync) && !v->inter &&
+		(v->name == m->name);
+	if (!ok)
+	{
+		Fails++;
+		printf("mode %s: got %u %d %d %d %d %d %d %d %d %c\n", r->name, m->pclk, m->width,
+			m->width + Px(v->hfront, m->pclk),
+			m->width + Px(v->hfront, m->pclk) + Px(v->hsync, m->pclk), m->htot,
+			m->height, m->height + v->vfront1, m->height + v->vfront1 + v->vsync1,
+			v->vtot, v->psync ? '+' : '-');
+	}
+}
+
+// parse modelines of reference modes
+static void TestParse()
+{
+	sModeline m;
+	char buf[200];
+	for (unsigned i = 0; i < count_of(DmtModes); i++)
+	{
+		const sRefMode* r = &DmtModes[i];
+		snprintf(buf, sizeof(buf), "Modeline \"%s\" %u.%03u %d %d %d %d %d %d %d %d %cHSync -VSync",
+			r->name, r->pclk/1000, r->pclk%1000, r->hdisp, r->hss, r->hse, r->htot,
+			r->vdisp, r->vss, r->vse, r->vtot, r->psync ? '+' : '-');
+		CHECK(ModelineParse(&m, buf));
+		CheckMode(&m, r);
+	}
+
+	// name is truncated to VIDEO_NAME_LEN, default name without quotes
+	CHECK(ModelineParse(&m, "  modeline \"1024x768@60\" 65 1024 1048 1184 1344 768 771 777 806"));
+	CHECK((strlen(m.name) == VIDEO_NAME_LEN) && (memcmp(m.name, "1024x768@60", VIDEO_NAME_LEN) == 0));
+	CHECK(ModelineParse(&m, "25.175 640 656 752 800 480 490 492 525\r\n"));
+	CHECK(memcmp(m.name, "MLINE", 5) == 0);
+	CheckMode(&m, &DmtModes[0]);
+	CHECK(ModelineParse(&m, "\"x\"\t40 800 840 968 1056 600 601 605 628 +vsync +HSYNC"));
+	CheckMode(&m, &DmtModes[1]);
+
+	// malformed input
+	static const char* const Bad[] = {
+		"",
+		"Modeline",
+		"\"unterminated 25.175 640 656 752 800 480 490 492 525",
+		"25.175 640 656 752 800 480 490 492",		// missing value
+		"25.175 640 656 752 800 480 490 492 x525",	// not a number
+		"-25.175 640 656 752 800 480 490 492 525",	// negative
+		"25.175 640 656 752 800 480 490 492 525 Interlace",
+		"25.175 640 656 752 800 480 490 492 525 DoubleScan",
+		"25.175 640 656 752 800 480 490 492 525 +HSyncX",
+		"25.175 640 656 752 800 480 490 492 525 garbage",
+		"0 640 656 752 800 480 490 492 525",		// zero pixel clock
+		"25.175 640 630 752 800 480 490 492 525",	// H sync start inside image
+		"25.175 640 656 656 800 480 490 492 525",	// zero H sync
+		"25.175 640 656 752 752 480 490 492 525",	// zero H back porch
+		"25.175 640 656 752 800 480 490 492 492",	// zero V back porch
+		"25.175 0 656 752 800 480 490 492 525",		// zero width
+		"25.175 640 656 752 800 480 490 492 99999",	// number overflow
+		"25.175 640 656 752 800 480 490 492 4294967296",
+		"Modelinex 25.175 640 656 752 800 480 490 492 525",
+	};
+	for (unsigned i = 0; i < count_of(Bad); i++)
+	{
+		if (ModelineParse(&m, Bad[i])) { Fails++; printf("accepted malformed: \"%s\"\n", Bad[i]); }
+	}
+}
+
+// generate CVT and CVT-RB reference modes
+static void TestCVT()
+{
+	sModeline m;
+	for (unsigned i = 0; i < count_of(CvtModes); i++)
+	{
+		const sRefMode* r = &CvtModes[i];
+		CHECK(ModelineCVT(&m, r->hdisp, r->vdisp, 60, False));
+		CheckMode(&m, r);
+		CHECK(memcmp(m.name, "CVT  ", VIDEO_NAME_LEN+1) == 0);
+	}
+
+	for (unsigned i = 0; i < count_of(CvtRbModes); i++)
+	{
+		const sRefMode* r = &CvtRbModes[i];
+		CHECK(ModelineCVT(&m, r->hdisp, r->vdisp, 60, True));
+		CheckMode(&m, r);
+		CHECK(memcmp(m.name, "CVTRB", VIDEO_NAME_LEN+1) == 0);
+	}
+
+	// width is rounded down to character cells
+	CHECK(ModelineCVT(&m, 1028, 768, 60, False) && (m.width == 1024));
+
+	// invalid parameters
+	CHECK(!ModelineCVT(&m, 7, 480, 60, False));
+	CHECK(!ModelineCVT(&m, 640, 0, 60, False));
+	CHECK(!ModelineCVT(&m, 640, 480, 0.5f, True));
+	CHECK(!ModelineCVT(&m, 640, 100000, 60, False));
+	CHECK(!ModelineCVT(&m, 640, 100000, 60, True));
+}
+
+// check videomode setup
+static void TestCheck()
+{
+	sModeline m;
+	sVmode vm;
+	float err;
+	CHECK(ModelineParse(&m, "25.175 640 656 752 800 480 490 492 525"));
+
+	// 126 MHz, 5 clocks per pixel: 25.2 MHz pixel clock
+	memset(&vm, 0, sizeof(vm));
+	vm.freq = 126000;
+	vm.div = 1;
+	vm.cpp = 5;
+	vm.wmax = 640;
+	CHECK(ModelineCheck(&m, &vm, &err) == 0);
+	CHECK((err > 0.00099f) && (err < 0.00100f));
+
+	// 2 MHz state machine: too short porches (H sync 7.6 clocks is OK), too short width
+	vm.freq = 2000;
+	vm.wmax = 639;
+	CHECK(ModelineCheck(&m, &vm, NULL) == (MODELINE_ERR_HBACK | MODELINE_ERR_HFRONT | MODELINE_ERR_WIDTH));
+}
+
+int main()
+{
+	TestParse();
+	TestCVT();
+	TestCheck();
+	return Result("modeline");
+}
@@ -0,0 +1,118 @@
+// ****************************************************************************
+//
+//                     Host test of VT100/ANSI terminal
+//
+// ****************************************************************************
+
+#include "test.h"
+
+// screen stubs (cursor is not tested)
+sTextCursor TextCursor;
+void ScreenCursor(sSegm* segm, int x, int y, u8 begin, u8 end, u8 col, u8 speed) { TextCursor.segm = segm; }
+void ScreenCursorPos(int x, int y) {}
+void ScreenCursorOff() { TextCursor.segm = NULL; }
+
+#define MAXCOLS	100
+#define MAXROWS	37
+
+u8 TextBuf[MAXCOLS*MAXROWS*3];
+sSegm TextSegm;
+sTerm Term;
+
+// open terminal
+static void Open(u8 form, int cols, int rows)
+{
+	memset(&TextSegm, 0, sizeof(TextSegm));
+	TextSegm.form = form;
+	TextSegm.data = TextBuf;
+	TextSegm.wb = cols*((form == GF_CTEXT) ? 3 : 2);
+	TextSegm.par3 = 16;
+	TermInit(&Term, &TextSegm, cols, rows);
+}
+
+// cell of physical row
+static u8* Cell(int x, int y) { return &TextBuf[y*TextSegm.wb + x*Term.cell]; }
+
+// attributes
+static void TestAttr()
+{
+	Open(GF_ATEXT, 80, 30);
+	TermText(&Term, "A\x1b[31;44mB\x1b[5mC\x1b[25;101mD\x1b[0;1;7mE\x1b[5;104mF");
+	CHECK(Cell(0,0)[0] == 'A' && Cell(0,0)[1] == ANSI_WHITE);
+	CHECK(Cell(1,0)[1] == (ANSI_RED | (ANSI_BLUE << 4)));
+	CHECK(Cell(2,0)[1] == (ANSI_RED | (ANSI_BLUE << 4) | B7));
+
+	// bright background must not set blink bit
+	CHECK(Cell(3,0)[1] == (ANSI_RED | (ANSI_RED << 4)));
+	CHECK(Cell(4,0)[1] == (ANSI_BLACK | (ANSI_WHITE << 4)));
+	CHECK(Cell(5,0)[1] == ((ANSI_BLUE|ANSI_BRIGHT) | (ANSI_WHITE << 4) | B7));
+
+	// other formats keep bright background
+	Open(GF_CTEXT, 80, 30);
+	TermText(&Term, "\x1b[101mA");
+	CHECK(Cell(0,0)[1] == TermPal[ANSI_RED|ANSI_BRIGHT]);
+}
+
+// cursor movement, erase and scroll
+static void TestMove()
+{
+	Open(GF_ATEXT, 80, 30);
+	TermText(&Term, "\x1b[5;10HX\x1b[2DY\x1b[A\x1b[3CZ");
+	CHECK(Cell(9,4)[0] == 'X' && Term.x == 13 && Term.y == 3);
+	CHECK(Cell(9,4)[0] == 'X' && Cell(9,3)[0] == ' ');
+	CHECK(Cell(12,3)[0] == 'Z');
+
+	TermText(&Term, "\x1b[5;1H\x1b[K");
+	CHECK(Cell(9,4)[0] == ' ');
+
+	// scroll whole screen by rotation
+	Open(GF_ATEXT, 80, 30);
+	TermText(&Term, "first");
+	for (int i = 0; i < 30; i++) TermText(&Term, "\r\n");
+	CHECK(Term.top == 1 && TextSegm.offy == 16);
+	CHECK(Cell(0,0)[0] == ' ');
+
+	// wrap at last column
+	Open(GF_ATEXT, 80, 30);
+	for (int i = 0; i < 81; i++) TermChar(&Term, 'a' + i % 26);
+	CHECK(Term.y == 1 && Term.x == 1 && Cell(0,1)[0] == 'a' + 80 % 26);
+
+	// malformed sequences are ignored
+	Open(GF_ATEXT, 80, 30);
+	TermText(&Term, "\x1b[999;999;999;999;999;999;999;999;999;999H\x1b[?99zQ\x1b[");
+	CHECK(Term.x <= 80 && Term.y < 30);
+}
+
+// throughput
+static void Bench(u8 form, int cols, int rows)
+{
+	Open(form, cols, rows);
+	char line[MAXCOLS+32];
+	int n = 0;
+	for (int i = 0; i < cols - 8; i++) line[n++] = 'A' + i % 26;
+	memcpy(&line[n], "\x1b[1;32mOK\x1b[0m\r\n", 16);
+	n += 16;
+	long chars = 0;
+	double t = Now();
+	for (int i = 0; i < 100000; i++)
+	{
+		TermWrite(&Term, line, n);
+		chars += n;
+	}
+	t = Now() - t;
+	printf("  term %dx%d %s: %.1f Mchars/s (host)\n", cols, rows,
+		(form == GF_ATEXT) ? "ATEXT" : "CTEXT", chars/t/1e6);
+}
+
+int main()
+{
+	TestAttr();
+	TestMove();
+	if (Verbose)
+	{
+		Bench(GF_ATEXT, 80, 30);
+		Bench(GF_ATEXT, 100, 37);
+		Bench(GF_CTEXT, 100, 37);
+	}
+	return Result("term");
+}
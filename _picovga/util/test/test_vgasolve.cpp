@@ -0,0 +1,142 @@
+// ****************************************************************************
+//
+//                    Host test of videomode timing solver
+//
+// ****************************************************************************
+
+#include "test.h"
+
+#define INPUT	12000	// PLL input frequency in kHz
+#define LISTMAX	64	// max. entries of setup list
+
+// solver is usable at compile time
+constexpr u32 XgaFreq = [] {
+	sVgaSolve s = {};
+	VgaSolve(&VideoXGA, 1024, 120000, 270000, 2, 17, 0, INPUT, &s, 1);
+	return s.freq; }();
+static_assert(XgaFreq == 130000, "XGA needs 130 MHz");
+
+// compare setups
+static Bool Same(const sVgaSolve* a, const sVgaSolve* b)
+{
+	return (a->freq == b->freq) && (a->vco == b->vco) && (a->fbdiv == b->fbdiv) && (a->pd1 == b->pd1) &&
+		(a->pd2 == b->pd2) && (a->div == b->div) && (a->cpp == b->cpp) && (a->htot == b->htot) &&
+		(a->cost == b->cost);
+}
+
+// check list of setups, returns number of entries
+static int CheckList(const sVideo* v, int wfull, u32 fmin, u32 fmax, int mincpp, int maxcpp,
+	u32 cpuline, sVgaSolve* list)
+{
+	int n = VgaSolve(v, wfull, fmin, fmax, mincpp, maxcpp, cpuline, INPUT, list, LISTMAX);
+	CHECK((n >= 0) && (n <= LISTMAX));
+
+	float pclk = wfull*1000.0f/v->hfull;
+	for (int i = 0; i < n; i++)
+	{
+		const sVgaSolve* s = &list[i];
+
+		// constraints
+		CHECK((s->freq >= fmin) && (s->freq <= fmax));
+		CHECK((s->cpp >= mincpp) && (s->cpp <= maxcpp));
+		CHECK((s->div >= 1) && (s->div <= VGASOLVE_DIVMAX));
+		CHECK((u32)s->htot*s->div >= cpuline);
+
+		// PLL setup
+		CHECK(s->vco == INPUT*s->fbdiv);
+		CHECK((s->vco >= 400000) && (s->vco <= 1600000));
+		CHECK(s->vco - s->freq*s->pd1*s->pd2 < (u32)s->pd1*s->pd2);
+
+		// timings
+		CHECK(s->htot == (u16)(s->freq*v->htot/1000/s->div + 0.5f));
+		CHECK(fabsf(s->perr - (s->freq/(pclk*s->cpp*s->div) - 1.0f)) < 1e-6f);
+		CHECK(fabsf(s->vfreq*v->vtot - s->hfreq) < 0.01f);
+
+		// sorted from the best
+		if (i > 0) CHECK(list[i-1].cost <= s->cost);
+	}
+	return n;
+}
+
+// standard videomodes with default configuration
+static void TestModes()
+{
+	static const struct { const sVideo* v; int w; } Modes[] = {
+		{ &VideoEGA, 528 }, { &VideoVGA, 640 }, { &VideoSVGA, 800 },
+		{ &VideoXGA, 1024 }, { &VideoHD, 1280 }, { &VideoPAL, 640 }, { &VideoNTSC, 640 },
+	};
+
+	sVgaSolve list[LISTMAX];
+	for (unsigned i = 0; i < count_of(Modes); i++)
+	{
+		int n = CheckList(Modes[i].v, Modes[i].w, 120000, 270000, 2, 17, 0, list);
+		CHECK(n > 0);
+		if (n == 0) continue;
+
+		// best setup is exact to 0.2%
+		CHECK(fabsf(list[0].perr) + fabsf(list[0].herr) < 0.002f);
+
+		// only 1 entry requested
+		sVgaSolve s;
+		CHECK(VgaSolve(Modes[i].v, Modes[i].w, 120000, 270000, 2, 17, 0, INPUT, &s, 1) == 1);
+		CHECK(Same(&s, &list[0]));
+
+		if (Verbose) printf("%s: %u kHz div=%u cpp=%u htot=%u pclk %+.0f ppm, %.3f Hz, %d setups\n",
+			Modes[i].v->name, list[0].freq, list[0].div, list[0].cpp, list[0].htot,
+			list[0].perr*1e6f, list[0].vfreq, n);
+	}
+
+	// XGA pixel clock 65 MHz is exact at 130 MHz
+	CHECK(VgaSolve(&VideoXGA, 1024, 120000, 270000, 2, 17, 0, INPUT, list, 1) == 1);
+	CHECK((list[0].freq == 130000) && (list[0].cpp == 2) && (list[0].div == 1) && (fabsf(list[0].perr) < 1e-6f));
+}
+
+// CPU budget per scanline
+static void TestCpu()
+{
+	sVgaSolve list[LISTMAX];
+	sVgaSolve list2[LISTMAX];
+
+	// VGA unlimited
+	int n = CheckList(&VideoVGA, 640, 120000, 270000, 2, 17, 0, list);
+	CHECK(n > 0);
+	u32 cycles = list[0].htot*list[0].div;
+
+	// budget below best setup does not change result
+	int n2 = CheckList(&VideoVGA, 640, 120000, 270000, 2, 17, cycles, list2);
+	CHECK((n2 > 0) && Same(&list[0], &list2[0]));
+
+	// budget above best setup selects higher system clock
+	n2 = CheckList(&VideoVGA, 640, 120000, 270000, 2, 17, cycles + 1000, list2);
+	CHECK((n2 > 0) && (list2[0].freq > list[0].freq));
+	if (Verbose && (n2 > 0)) printf("VGA with %u clocks per line: %u kHz, cpp=%u\n",
+		cycles + 1000, list2[0].freq, list2[0].cpp);
+
+	// budget above max. frequency
+	CHECK(CheckList(&VideoVGA, 640, 120000, 270000, 2, 17, 270*32 + 1, list2) == 0);
+}
+
+// impossible setups
+static void TestLimits()
+{
+	sVgaSolve list[LISTMAX];
+
+	// VGA needs at least 2 x 25.2 MHz
+	CHECK(CheckList(&VideoVGA, 640, 20000, 50000, 2, 17, 0, list) == 0);
+
+	// range of clocks per pixel limits frequency
+	int n = CheckList(&VideoVGA, 640, 120000, 270000, 6, 6, 0, list);
+	CHECK(n > 0);
+	for (int i = 0; i < n; i++) CHECK(list[i].cpp == 6);
+
+	// empty list
+	CHECK(VgaSolve(&VideoVGA, 640, 120000, 270000, 2, 17, 0, INPUT, list, 0) == 0);
+}
+
+int main()
+{
+	TestModes();
+	TestCpu();
+	TestLimits();
+	return Result("vgasolve");
+}
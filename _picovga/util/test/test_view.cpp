@@ -0,0 +1,293 @@
+// ****************************************************************************
+//
+//                 Host test of sub-canvas views and clipping
+//
+// ****************************************************************************
+// Every primitive is drawn 3 times: into a view (with optional clipping), into the
+// parent canvas with equivalent clipping rectangle and into unclipped reference
+// canvas. View and parent must give identical images and dirty regions, and the
+// image must match the reference inside the clipping box and the original outside.
+
+#include "test.h"
+
+sHostDma HostDma;
+sHostInterp HostInterp0, HostInterp1;
+
+#define SIZE	30000	// size of image buffer (with planes and attributes)
+
+static u8 ImgV[SIZE];	// image drawn through view
+static u8 ImgP[SIZE];	// image drawn into parent with clipping
+static u8 ImgR[SIZE];	// unclipped reference image
+static u8 ImgO[SIZE];	// original image
+static u8 ImgS[SIZE];	// source image
+static u8 ImgS2[SIZE];	// copy of source view for matrix
+static u8 Mask[SIZE];	// mask of flood fill
+static u8 Font[256*8];
+static sCanvas SrcV, SrcP, SrcM; // sources (pointers are recorded into 32-bit words)
+
+// random number
+static int Rnd(int n) { return rand() % n; }
+
+// get pixel value (CANVAS_ATTRIB8: pixel bit)
+static int GetPix(const sCanvas* c, int x, int y)
+{
+	const u8* s = c->img + y*c->wb;
+	int v = 0;
+	switch (c->format)
+	{
+	case CANVAS_8: return s[x];
+	case CANVAS_4: return (s[x/2] >> (4 - (x & 1)*4)) & 15;
+	case CANVAS_2: return (s[x/4] >> (6 - (x & 3)*2)) & 3;
+	case CANVAS_PLANE4:
+		v = (((s[x/8 + 3*(c->img2 - c->img)] >> (7 - (x & 7))) & 1) << 3) |
+			(((s[x/8 + 2*(c->img2 - c->img)] >> (7 - (x & 7))) & 1) << 2);
+		// continue to CANVAS_PLANE2
+	case CANVAS_PLANE2:
+		v |= ((s[x/8 + (c->img2 - c->img)] >> (7 - (x & 7))) & 1) << 1;
+		// continue to CANVAS_1
+	default: return v | ((s[x/8] >> (7 - (x & 7))) & 1);
+	}
+}
+
+// bits per pixel in first plane
+static int Bits(u8 f) { return (f == CANVAS_8) ? 8 : (f == CANVAS_4) ? 4 : (f == CANVAS_2) ? 2 : 1; }
+
+#define OPS	18	// number of tested operations
+
+// draw operation into canvas
+//  ox, oy ... origin of view in parent (0 = drawing into view)
+static void Draw(sCanvas* c, int op, int ox, int oy, const sCanvas* src, int xs, int ys,
+	const sCanvas* msrc, int x, int y, int w, int h, u8 col, u8 bg, const s16* poly, int pn,
+	const u8* pat, const char* txt, int fh, int scx, int scy, const sDrawConv* conv,
+	const cMat2Di* mat, u8 mode)
+{
+	s16 xy[32];
+	int i;
+	sDrawImgItem item[2];
+
+	x += ox;
+	y += oy;
+	switch (op)
+	{
+	case 0: DrawRect(c, x, y, w, h, col); break;
+	case 1: DrawPoint(c, x, y, col); break;
+	case 2: DrawLine(c, x, y, w*3 + ox, h*3 + oy, col); break;
+	case 3: DrawFillCircle(c, x, y, w/2, col, (u8)(h*37)); break;
+	case 4: DrawCircle(c, x, y, w/2, col, (u8)(h*37)); break;
+	case 5: DrawText(c, txt, x, y, col, Font, fh, scx, scy); break;
+	case 6: DrawTextBg(c, txt, x, y, col, bg, Font, fh, scx, scy); break;
+	case 7:
+		for (i = 0; i < pn; i++)
+		{
+			xy[2*i] = (s16)(poly[2*i] + ox);
+			xy[2*i+1] = (s16)(poly[2*i+1] + oy);
+		}
+		DrawFillPoly(c, xy, pn, col);
+		break;
+	case 8: DrawFillTriangle(c, poly[0] + ox, poly[1] + oy, poly[2] + ox, poly[3] + oy,
+		poly[4] + ox, poly[5] + oy, col); break;
+	case 9: DrawImg(c, (sCanvas*)src, x, y, xs, ys, w, h); break;
+	case 10: DrawBlit(c, (sCanvas*)src, x, y, xs, ys, w, h, col); break;
+	case 11: DrawImgConv(c, src, x, y, xs, ys, w, h, conv); break;
+	case 12: DrawBlitConv(c, src, x, y, xs, ys, w, h, conv, col); break;
+	case 13: DrawFill(c, x, y, col); break;
+	case 14: DrawFillPat(c, x, y, pat, col, bg, NULL); break;
+	case 15:
+		if (c->format == CANVAS_8) DrawImgMat(c, msrc, x, y, w, h, mat, mode, col);
+		break;
+	case 16:
+		if (c->format != CANVAS_8) break;
+		for (i = 0; i < 2; i++)
+		{
+			item[i].src = msrc;
+			item[i].mat = mat->Int();
+			item[i].x = (s16)(x + i*7);
+			item[i].y = (s16)(y - i*5);
+			item[i].w = (s16)w;
+			item[i].h = (s16)h;
+			item[i].mode = mode;
+			item[i].color = col;
+		}
+		DrawImgMatBatch(c, item, 2);
+		break;
+	case 17: DrawGouraudTriangle(c, poly[0] + ox, poly[1] + oy, col, poly[2] + ox, poly[3] + oy, bg,
+		poly[4] + ox, poly[5] + oy, (u8)(col ^ bg)); break;
+	}
+}
+
+// view and parent with clipping give the same result
+static void TestView()
+{
+	static const u8 Formats[] = { CANVAS_8, CANVAS_4, CANVAS_2, CANVAS_1, CANVAS_PLANE2,
+		CANVAS_PLANE4, CANVAS_ATTRIB8 };
+	int cnt[OPS];
+	memset(cnt, 0, sizeof(cnt));
+	for (int it = 0; it < 200000; it++)
+	{
+		// destination canvases
+		u8 f = Formats[Rnd(7)];
+		int w0 = 8 + Rnd(80);
+		int h0 = 8 + Rnd(50);
+		if (f == CANVAS_ATTRIB8) h0 = (h0 + 7) & ~7;
+		int wb = (w0*Bits(f) + 7)/8 + Rnd(3);
+		int cm = (f == CANVAS_8) ? 255 : ((f == CANVAS_4) || (f == CANVAS_PLANE4)) ? 15 :
+			((f == CANVAS_2) || (f == CANVAS_PLANE2)) ? 3 : (f == CANVAS_ATTRIB8) ? 31 : 1;
+		int size = wb*h0*5;
+		for (int i = 0; i < size; i++) ImgV[i] = (u8)rand();
+		memcpy(ImgP, ImgV, size);
+		memcpy(ImgR, ImgV, size);
+		memcpy(ImgO, ImgV, size);
+		sCanvas cv, cp, cr, co, view;
+		CanvasInit(&cv, f, w0, h0, wb, ImgV);
+		CanvasInit(&cp, f, w0, h0, wb, ImgP);
+		CanvasInit(&cr, f, w0, h0, wb, ImgR);
+		CanvasInit(&co, f, w0, h0, wb, ImgO);
+		sDirty dv, dp;
+		CanvasDirtyOn(&cv, &dv);
+		CanvasDirtyOn(&cp, &dp);
+		dv.num = 0;
+		dp.num = 0;
+
+		// clipping of parent, view and nested view
+		if (Rnd(4) == 0)
+		{
+			int a = Rnd(w0), b = Rnd(h0), c = Rnd(w0), d = Rnd(h0);
+			CanvasClipPush(&cv, a, b, c, d);
+			CanvasClipPush(&cp, a, b, c, d);
+		}
+		int vx = Rnd(w0 + 10) - 5, vy = Rnd(h0 + 10) - 5, vw = Rnd(w0), vh = Rnd(h0);
+		CanvasView(&view, &cv, vx, vy, vw, vh);
+		CanvasClipPush(&cp, vx, vy, vw, vh);
+		if (Rnd(3) == 0)
+		{
+			int a = Rnd(vw + 4) - 2, b = Rnd(vh + 4) - 2, c = Rnd(vw + 2), d = Rnd(vh + 2);
+			CanvasClipPush(&view, a, b, c, d);
+			CanvasClipPush(&cp, a + vx, b + vy, c, d);
+		}
+		if (Rnd(5) == 0)
+		{
+			sCanvas v2;
+			int a = Rnd(vw + 4) - 2, b = Rnd(vh + 4) - 2, c = Rnd(vw + 2), d = Rnd(vh + 2);
+			CanvasView(&v2, &view, a, b, c, d);
+			view = v2;
+			vx += a;
+			vy += b;
+			CanvasClipPush(&cp, vx, vy, c, d);
+		}
+		const sDirtyRect* box = &cp.clip[cp.clipnum - 1];
+
+		// parameters
+		int op = Rnd(OPS);
+		cnt[op]++;
+		int x = Rnd(vw + 20) - 10, y = Rnd(vh + 20) - 10, w = Rnd(40) - 5, h = Rnd(40) - 5;
+		u8 col = (u8)(rand() & cm), bg = (u8)(rand() & cm);
+		if (op == 17) { col &= 15; bg &= 15; }
+		s16 poly[16];
+		int pn = 3 + Rnd(6);
+		for (int i = 0; i < pn; i++)
+		{
+			poly[2*i] = (s16)(Rnd(vw + 30) - 15);
+			poly[2*i+1] = (s16)(Rnd(vh + 30) - 15);
+		}
+		u8 pat[8];
+		for (int i = 0; i < 8; i++) pat[i] = (u8)rand();
+		char txt[8];
+		int tl = 1 + Rnd(6);
+		for (int i = 0; i < tl; i++) txt[i] = (char)(1 + Rnd(255));
+		txt[tl] = 0;
+		int scx = Rnd(5) - 2, scy = Rnd(5) - 2;
+		if (scx == 0) scx = 1;
+		if (scy == 0) scy = 1;
+		int fh = 1 + Rnd(8);
+		sDrawConv conv;
+		for (int i = 0; i < 256; i++) conv.map[i] = (u8)(rand() & ((f == CANVAS_ATTRIB8) ? 15 : cm));
+		conv.pal = NULL;
+
+		// source canvas, the same format (converting blits: any format), and its view
+		int sw = 8 + Rnd(60), sh = 8 + Rnd(40);
+		u8 sf = (op == 12) ? Formats[Rnd(7)] : f;
+		if (sf == CANVAS_ATTRIB8) sh = (sh + 7) & ~7;
+		int swb = (sw*Bits(sf) + 7)/8;
+		for (int i = 0; i < swb*sh*5; i++) ImgS[i] = (u8)rand();
+		sCanvas sc;
+		CanvasInit(&sc, sf, sw, sh, swb, ImgS);
+		SrcV = sc;
+		SrcP = sc;
+		SrcM = sc;
+		int xs = Rnd(sw) - 3, ys = Rnd(sh) - 3;
+		int sx0 = Rnd(sw), sy0 = Rnd(sh), svw = Rnd(sw), svh = Rnd(sh);
+		if (op >= 15)
+		{
+			if (sx0 + svw > sw) svw = sw - sx0;
+			if (sy0 + svh > sh) svh = sh - sy0;
+		}
+		Bool srcview = (Rnd(2) == 0);
+		if (srcview)
+		{
+			CanvasView(&SrcV, &sc, sx0, sy0, svw, svh);
+			CanvasClipPush(&SrcP, sx0, sy0, svw, svh);
+		}
+		int xsp = srcview ? xs + sx0 : xs, ysp = srcview ? ys + sy0 : ys;
+
+		// standalone copy of source view for matrix
+		cMat2Di mat;
+		mat.PrepDrawImg(sw, sh, Rnd(sw), Rnd(sh), (w > 0) ? w : 10, (h > 0) ? h : 10, 0, 0,
+			Rnd(ANGLE_FULL), 0, 0);
+		u8 mode = (Rnd(2) == 0) ? DRAWIMG_NOBORDER : DRAWIMG_TRANSP;
+		const sCanvas* msrcv = &SrcV;
+		if ((op >= 15) && srcview && (svw > 0) && (svh > 0) && (sf == CANVAS_8))
+		{
+			CanvasInit(&SrcM, CANVAS_8, svw, svh, svw, ImgS2);
+			for (int j = 0; j < svh; j++)
+				for (int i = 0; i < svw; i++) ImgS2[j*svw + i] = ImgS[(sy0 + j)*swb + sx0 + i];
+		}
+		else if (op >= 15)
+			msrcv = &SrcM;
+
+		// ground truth is not available for fill (region depends on clipping) and for
+		// converting blits into CANVAS_ATTRIB8 (cell colors depend on clipping)
+		Bool gt = (op != 13) && (op != 14) && !((f == CANVAS_ATTRIB8) && ((op == 11) || (op == 12)));
+
+		// draw
+		Draw(&view, op, 0, 0, &SrcV, xs, ys, msrcv, x, y, w, h, col, bg, poly, pn, pat,
+			txt, fh, scx, scy, &conv, &mat, mode);
+		Draw(&cp, op, vx, vy, &SrcP, xsp, ysp, &SrcM, x, y, w, h, col, bg, poly, pn, pat,
+			txt, fh, scx, scy, &conv, &mat, mode);
+		if (gt) Draw(&cr, op, vx, vy, &SrcP, xsp, ysp, &SrcM, x, y, w, h, col, bg, poly, pn, pat,
+			txt, fh, scx, scy, &conv, &mat, mode);
+
+		// compare
+		if (memcmp(ImgV, ImgP, size) != 0)
+		{
+			Fails++;
+			printf("view fail: op %d, format %d\n", op, f);
+			return;
+		}
+		if ((dv.num != dp.num) || (memcmp(dv.rect, dp.rect, dv.num*sizeof(sDirtyRect)) != 0))
+		{
+			Fails++;
+			printf("dirty fail: op %d, format %d\n", op, f);
+			return;
+		}
+		if (!gt) continue;
+		for (int yy = 0; yy < h0; yy++)
+			for (int xx = 0; xx < w0; xx++)
+			{
+				Bool in = (xx >= box->x1) && (xx < box->x2) && (yy >= box->y1) && (yy < box->y2);
+				if (GetPix(&cv, xx, yy) != GetPix(in ? &cr : &co, xx, yy))
+				{
+					Fails++;
+					printf("clip fail: op %d, format %d at %d,%d, inside %d\n", op, f, xx, yy, in);
+					return;
+				}
+			}
+	}
+	for (int i = 0; i < OPS; i++) CHECK(cnt[i] > 0);
+}
+
+int main()
+{
+	for (unsigned i = 0; i < sizeof(Font); i++) Font[i] = (u8)rand();
+	TestView();
+	return Result("view");
+}
@@ -0,0 +1,116 @@
+// ****************************************************************************
+//
+//                          Videomode timing solver
+//
+// ****************************************************************************
+// Searches all combinations of state machine clocks per pixel (cpp), clock
+// divider (div) and PLL setups found with vcocalc, and ranks them by weighted
+// cost of timing error and system clock above required frequency (it costs
+// power and heat).
+// CPU time is not part of the cost, it is a separate constraint: 'cpuline'
+// is the minimal number of system clocks per scanline that core 1 needs to
+// render one line (e.g. measured cycles of the slowest used layer format).
+// Setups with less clocks per line (div*htot) are rejected. Because clocks
+// per line depend on the line period, not on the pixel clock, the budget can
+// require higher frequency than 'fmin' with some timings and not with others.
+// Solver does not access hardware, so it can be tested on host, and it can
+// be evaluated at compile time (constexpr).
+
+#ifndef _VGASOLVE_H
+#define _VGASOLVE_H
+
+// weights of solver cost
+#define VGASOLVE_WERR	1.0f	// weight of timing error, per 100 ppm
+#define VGASOLVE_WFREQ	0.2f	// weight of system clock above minimal frequency (power), per 1 MHz
+
+// max. clock divider
+#define VGASOLVE_DIVMAX	64
+
+// solver result
+typedef struct {
+	// setup PLL system clock
+	u32	freq;		// system clock frequency in kHz
+	u32	vco;		// VCO frequency in kHz
+	u16	fbdiv;		// fbdiv PLL divider
+	u8	pd1;		// postdiv1
+	u8	pd2;		// postdiv2
+
+	// setup PIO state machine
+	u16	div;		// divide base state machine clock
+	u16	cpp;		// state machine clocks per pixel
+	u16	htot;		// total state machine clocks per line
+
+	// achieved timings
+	float	hfreq;		// horizontal frequency in [Hz]
+	float	vfreq;		// vertical frequency in [Hz]
+	float	perr;		// relative error of pixel clock
+	float	herr;		// relative error of horizontal frequency
+	float	cost;		// weighted cost (lower is better)
+} sVgaSolve;
+
+// search timing setups (returns number of found setups, 0 = none)
+//   v ... video timings
+//   wfull ... width of full screen in pixels (corresponding to 'hfull' time)
+//   fmin ... minimal system frequency in kHz
+//   fmax ... maximal system frequency in kHz
+//   mincpp, maxcpp ... range of state machine clocks per pixel
+//   cpuline ... required minimal system clocks per scanline (CPU budget of rendering, 0 = no limit)
+//   input ... PLL input frequency in kHz (12000, or use clock_get_hz(clk_ref)/1000)
+//   list ... output list of setups, sorted from the best
+//   num ... max. number of entries in the list
+constexpr int VgaSolve(const sVideo* v, int wfull, u32 fmin, u32 fmax, int mincpp, int maxcpp,
+	u32 cpuline, u32 input, sVgaSolve* list, int num)
+{
+	int cpp = 0, div = 0, i = 0, n = 0;
+	sVgaSolve s = {};
+
+	// required pixel clock in kHz
+	float pclk = wfull*1000.0f/v->hfull;
+
+	// lower divider first, to prefer finer timings on equal cost
+	for (div = 1; (div <= VGASOLVE_DIVMAX) && (pclk*mincpp*div <= fmax + 0.5f); div++)
+	{
+		for (cpp = mincpp; cpp <= maxcpp; cpp++)
+		{
+			// ideal system frequency
+			float f = pclk*cpp*div;
+			if (f > fmax + 0.5f) break;
+			if (f < fmin - 0.5f) continue;
+
+			// nearest PLL setup
+			vcocalc((u32)(f + 0.5f), input, 400000, 1600000, false,
+				&s.freq, &s.vco, &s.fbdiv, &s.pd1, &s.pd2);
+			if ((s.freq < fmin) || (s.freq > fmax)) continue;
+
+			// achieved timings
+			s.div = (u16)div;
+			s.cpp = (u16)cpp;
+			s.htot = (u16)(s.freq*v->htot/1000/div + 0.5f);
+
+			// CPU budget per scanline
+			if ((u32)s.htot*div < cpuline) continue;
+			s.hfreq = s.freq*1000.0f/div/s.htot;
+			s.vfreq = s.hfreq/v->vtot;
+			s.perr = s.freq/(pclk*cpp*div) - 1.0f;
+			s.herr = s.hfreq*v->htot/1000000.0f - 1.0f;
+
+			// weighted cost
+			float e = ((s.perr < 0) ? -s.perr : s.perr) + ((s.herr < 0) ? -s.herr : s.herr);
+			s.cost = e*10000*VGASOLVE_WERR + (s.freq - fmin)/1000.0f*VGASOLVE_WFREQ;
+
+			// insert into sorted list
+			for (i = n; (i > 0) && (list[i-1].cost > s.cost); i--)
+			{
+				if (i < num) list[i] = list[i-1];
+			}
+			if (i < num)
+			{
+				list[i] = s;
+				if (n < num) n++;
+			}
+		}
+	}
+	return n;
+}
+
+#endif // _VGASOLVE_H
@@ -10,6 +10,19 @@
 // scanline type
 u8 ScanlineType[MAXLINE];
 
+// pending switch of videomode geometry (applied at start of next frame)
+u8 ScanlineTypeNext[MAXLINE];	// pre-built scanline type table of new videomode
+sVmode VmodeNext;		// new videomode
+u32 LineBufHsBpNext[4];		// pre-built HSYNC ... image command of new videomode
+u32 LineBufFpNext;		// pre-built front porch of new videomode
+sScreen* volatile ScreenNext = NULL; // new screen layout (NULL = keep current screen)
+volatile Bool VmodeNextReq = False; // request to apply new videomode at start of next frame
+
+// state of VGA driver
+volatile Bool VgaActive = False; // VGA driver is running (DMA and PIO are active)
+volatile Bool VgaCoreRun = False; // VGA core is running on core 1
+u32 VgaSwitchTime = 0;		// duration of last videomode switch in [us]
+
 // current videomode
 int DispDev;			// current display device
 sVmode CurVmode;		// copy of current videomode table
@@ -19,11 +32,26 @@ volatile u32 Frame;		// frame counter
 volatile int BufInx;		// current buffer set (0..1)
 volatile Bool VSync;		// current scan line is vsync or dark
 
+// requests to write words at start of frame (swap of buffers or tables)
+u32*	SwapAddr[SWAP_MAX];	// address of word to write
+volatile u32 SwapVal[SWAP_MAX];	// new value of the word
+volatile u32 SwapReq[SWAP_MAX];	// number of requests of the slot (written only by core 0)
+volatile u32 SwapAck[SWAP_MAX];	// number of done requests of the slot (written only by core 1)
+
+// arena with scanline buffers (layout is set on videomode initialization)
+u32	VgaArena[(ARENA_MAX+3)/4];
+int	VgaArenaUsed = 0;	// used size of arena in bytes
+int	VgaArenaWidth = 0;	// width of videomode the arena is prepared for
+
+// max. size of buffers
+const int LineBufMax[LAYERS_MAX] = { DBUF0_MAX, DBUF1_MAX, DBUF2_MAX, DBUF3_MAX }; // max. size of data buffers
+const int CtrlBufMax[LAYERS_MAX] = { CBUF0_MAX, CBUF1_MAX, CBUF2_MAX, CBUF3_MAX }; // max. size of control buffers
+
 // line buffers
-ALIGNED u8	LineBuf1[DBUF_MAX]; // scanline 1 image data
-ALIGNED u8	LineBuf2[DBUF_MAX]; // scanline 2 image data
+u8*	LineBuf1;		// scanline 1 image data
+u8*	LineBuf2;		// scanline 2 image data
 
-int	LineBufSize[LAYERS_MAX] = { DBUF0_MAX, DBUF1_MAX, DBUF2_MAX, DBUF3_MAX }; // size of data buffers
+int	LineBufSize[LAYERS_MAX]; // size of data buffers
 
 u32	LineBufHsBp[4];		// HSYNC ... back porch-1 ... IRQ command ... image command
 u32	LineBufFp;		// front porch+1
@@ -35,13 +63,14 @@ u32	LineBufSync[10];	// vertical synchronization
 				//	1x half synchronization (HSYNC pulse/2 ... line dark/2)
 				// progressive: 1x scanline with vertical synchronization (invert line dark ... invert HSYNC pulse)
 
-ALIGNED u8	LineBuf0[BLACK_MAX]; // line buffer with black color (used to clear rest of scanline)
+u8*	LineBuf0;		// line buffer with black color (used to clear rest of scanline)
+int	LineBuf0Size;		// size of line buffer with black color
 
 // control buffers (BufInx = 0 running CtrlBuf1 and preparing CtrlBuf2, BufInx = 1 running CtrlBuf2 and preparing CtrlBuf1)
-u32	CtrlBuf1[CBUF_MAX]; // base layer control pairs: u32 count, read address (must be terminated with [0,0])
-u32	CtrlBuf2[CBUF_MAX]; // base layer control pairs: u32 count, read address (must be terminated with [0,0])
+u32*	CtrlBuf1; // base layer control pairs: u32 count, read address (must be terminated with [0,0])
+u32*	CtrlBuf2; // base layer control pairs: u32 count, read address (must be terminated with [0,0])
 
-int	CtrlBufSize[LAYERS_MAX] = { CBUF0_MAX, CBUF1_MAX, CBUF2_MAX, CBUF3_MAX }; // size of control buffers
+int	CtrlBufSize[LAYERS_MAX]; // size of control buffers
 
 // next control buffer
 u32*	CtrlBufNext[LAYERS_MAX];
@@ -52,7 +81,60 @@ u32 RenderTextMask[512];
 // saved integer divider state
 hw_divider_state_t DividerState;
 
-// process scanline buffers (will save integer divider state into DividerState)
+// saved interpolator state (renderers use interpolators, draw functions on core 1 too)
+interp_hw_save_t InterpState[2];
+
+// save interpolator state (SDK interp_save is in flash)
+static inline void VgaInterpSave(interp_hw_t* interp, interp_hw_save_t* s)
+{
+	s->accum[0] = interp->accum[0];
+	s->accum[1] = interp->accum[1];
+	s->base[0] = interp->base[0];
+	s->base[1] = interp->base[1];
+	s->base[2] = interp->base[2];
+	s->ctrl[0] = interp->ctrl[0];
+	s->ctrl[1] = interp->ctrl[1];
+}
+
+// restore interpolator state
+static inline void VgaInterpRestore(interp_hw_t* interp, const interp_hw_save_t* s)
+{
+	interp->ctrl[0] = s->ctrl[0];
+	interp->ctrl[1] = s->ctrl[1];
+	interp->accum[0] = s->accum[0];
+	interp->accum[1] = s->accum[1];
+	interp->base[0] = s->base[0];
+	interp->base[1] = s->base[1];
+	interp->base[2] = s->base[2];
+}
+
+// apply pending switch of videomode geometry (called at start of frame, in vertical sync)
+static void __not_in_flash_func(VgaSwitchApply)()
+{
+	// scanline type table
+	memcpy(ScanlineType, ScanlineTypeNext, VmodeNext.vtot+1);
+
+	// videomode
+	memcpy(&CurVmode, &VmodeNext, sizeof(sVmode));
+
+	// horizontal line buffers (DMA is sending vertical sync now, they are not in use)
+	LineBufHsBp[1] = LineBufHsBpNext[1];
+	LineBufHsBp[3] = LineBufHsBpNext[3];
+	LineBufFp = LineBufFpNext;
+
+	// screen layout
+	sScreen* s = ScreenNext;
+	if (s != NULL)
+	{
+		pScreen = s;
+		ScreenNext = NULL;
+	}
+
+	VmodeNextReq = False;
+}
+
+// process scanline buffers (will save integer divider state into DividerState and
+// interpolator state into InterpState)
 int __not_in_flash_func(VgaBufProcess)()
 {
 	// Clear the interrupt request for DMA control channel
@@ -70,6 +152,10 @@ int __not_in_flash_func(VgaBufProcess)()
 	// save integer divider state
 	hw_divider_save_state(&DividerState);
 
+	// save interpolator state
+	VgaInterpSave(interp0, &InterpState[0]);
+	VgaInterpSave(interp1, &InterpState[1]);
+
 	// increment scanline
 	int line = ScanLine;	// current scanline
 	line++; 		// new current scanline
@@ -77,6 +163,23 @@ int __not_in_flash_func(VgaBufProcess)()
 	{
 		Frame++;	// increment frame counter
 		line = 1; 	// restart scanline
+
+		// swap buffers and tables
+		int i;
+		for (i = 0; i < SWAP_MAX; i++)
+		{
+			u32 req = SwapReq[i];
+			if (req != SwapAck[i])
+			{
+				__dmb();
+				*SwapAddr[i] = SwapVal[i];
+				__dmb();
+				SwapAck[i] = req;
+			}
+		}
+
+		// switch videomode geometry
+		if (VmodeNextReq) VgaSwitchApply();
 	}
 	ScanLine = line;	// store new scanline
 
@@ -173,6 +276,83 @@ int __not_in_flash_func(VgaBufProcess)()
 	return bufinx;
 }
 
+// apply blinking and text cursor to rendered text segment GF_ATEXT, GF_FTEXT or GF_CTEXT
+//  dbuf ... start of rendered data in data buffer
+//  x ... start X coordinate (in pixels, multiple of 4)
+//  y ... start Y coordinate (in graphics lines)
+//  w ... rendered width (multiple of 4)
+//  segm ... video segment
+extern "C" void __not_in_flash_func(RenderTextPost)(u8* dbuf, int x, int y, int w, sSegm* segm)
+{
+	// blink mask (0 = visible phase or blinking is disabled)
+	u8 blink = (u8)(segm->par3 >> 8);
+	if (((Frame >> TextBlink) & 1) == 0) blink = 0;
+
+	// quick check if there is something to do
+	if ((blink == 0) && (TextCursor.segm != segm)) return;
+
+	// text row and line in the row
+	int fonth = segm->par3 & 0xff;
+	int row = y / fonth;
+	int line = y - row*fonth;
+	int wrapx = segm->wrapx & ~7;
+	int cell = (segm->form == GF_CTEXT) ? 3 : 2;
+	const u8* src = (const u8*)segm->data + row*segm->wb;
+
+	// hide blinking characters (fill them with background color)
+	if (blink != 0)
+	{
+		const u8* pal = (const u8*)segm->par2;
+		const u8* s;
+		u8* d = dbuf;
+		int i, n, xx = x;
+		u8 bg;
+		int rem = w;
+		while (rem > 0)
+		{
+			// pixels of this character
+			s = &src[(xx >> 3)*cell];
+			i = xx & 7;
+			n = 8 - i;
+			if (n > rem) n = rem;
+
+			// blinking character
+			if ((s[1] & blink) != 0)
+			{
+				if (segm->form == GF_ATEXT)
+					bg = pal[s[1] >> 4];
+				else if (segm->form == GF_FTEXT)
+					bg = (u8)segm->par2;
+				else
+					bg = s[1];
+				MemSet4((u32*)d, bg*0x01010101, n/4); // d and n are multiples of 4 pixels
+			}
+
+			// shift to next character
+			d += n;
+			rem -= n;
+			xx += n;
+			if (xx >= wrapx) xx = 0;
+		}
+	}
+
+	// draw text cursor
+	sTextCursor* cur = &TextCursor;
+	if ((cur->segm == segm) && (cur->y == row) && (line >= cur->top) && (line <= cur->bottom) &&
+		((cur->blink == 0) || (((Frame >> cur->blink) & 1) == 0)))
+	{
+		// offset of cursor in rendered data (cursor can start before start of rendered data)
+		int off = cur->x*8 - x;
+		if (off <= -8) off += wrapx;
+
+		// clip cursor span to rendered data
+		int i = (off < 0) ? -off : 0;
+		int n = w - off;
+		if (n > 8) n = 8;
+		for (; i < n; i++) dbuf[off + i] ^= cur->col;
+	}
+}
+
 // render scanline buffers
 u32* __not_in_flash_func(VgaBufRender)(u32* cbuf, u32* cbuf0, u8* dbuf, int y0)
 {
@@ -373,7 +553,7 @@ u32* __not_in_flash_func(VgaBufRender)(u32* cbuf, u32* cbuf0, u8* dbuf, int y0)
 // VGA DMA handler - called on end of every scanline
 extern "C" void __not_in_flash_func(VgaLine)()
 {
-	// process scanline buffers (will save integer divider state into DividerState)
+	// process scanline buffers (will save integer divider and interpolator state)
 	int bufinx = VgaBufProcess();
 
 	// prepare buffers to be processed next
@@ -469,6 +649,10 @@ extern "C" void __not_in_flash_func(VgaLine)()
 	*cbuf++ = 0; // end mark
 	*cbuf++ = 0; // end mark
 
+	// restore interpolator state
+	VgaInterpRestore(interp0, &InterpState[0]);
+	VgaInterpRestore(interp1, &InterpState[1]);
+
 	// restore integer divider state
 	hw_divider_restore_state(&DividerState);
 }
@@ -664,20 +848,125 @@ void VgaPioInit()
 	}
 }
 
-// initialize scanline buffers
-void VgaBufInit()
+// prepare horizontal buffers of image scanline
+//  v ... videomode
+//  hsbp ... destination HSYNC..back porch buffer (4 words)
+//  fp ... destination front porch buffer
+void VgaBufHsBp(const sVmode* v, u32* hsbp, u32* fp)
 {
 	// init HSYNC..back porch buffer
 	//  hsync must be min. 3
 	//  hback must be min. 13
-	LineBufHsBp[0] = BYTESWAP(VGACMD(vga_offset_sync+BASE_OFFSET,CurVmode.hsync-3)); // HSYNC
-	LineBufHsBp[1] = BYTESWAP(VGADARK(CurVmode.hback-4-1-9,0)); // back porch - 1 - 9
-	LineBufHsBp[2] = BYTESWAP(VGACMD(vga_offset_irqset+BASE_OFFSET,0)); // IRQ command (takes 9 clock cycles)
-	LineBufHsBp[3] = BYTESWAP(VGACMD(vga_offset_output+BASE_OFFSET, CurVmode.width - 2)); // missing 2 clock cycles after last pixel
+	hsbp[0] = BYTESWAP(VGACMD(vga_offset_sync+BASE_OFFSET,v->hsync-3)); // HSYNC
+	hsbp[1] = BYTESWAP(VGADARK(v->hback-4-1-9,0)); // back porch - 1 - 9
+	hsbp[2] = BYTESWAP(VGACMD(vga_offset_irqset+BASE_OFFSET,0)); // IRQ command (takes 9 clock cycles)
+	hsbp[3] = BYTESWAP(VGACMD(vga_offset_output+BASE_OFFSET, v->width - 2)); // missing 2 clock cycles after last pixel
 
 	// init front porch buffer
 	//  hfront must be min. 4
-	LineBufFp = BYTESWAP(VGADARK(CurVmode.hfront-4,0)); // front porch
+	*fp = BYTESWAP(VGADARK(v->hfront-4,0)); // front porch
+}
+
+// calculate size of scanline buffers (returns total size in bytes)
+//  v ... videomode
+//  dsize ... output sizes of data buffers of layers in bytes (NULL = not used)
+//  csize ... output sizes of control buffers of layers in u32 (NULL = not used)
+int VgaBufNeed(const sVmode* v, int* dsize, int* csize)
+{
+	int layer, d, c, n = 0;
+	int w = (v->width + 3) & ~3;
+	for (layer = 0; layer < LAYERS; layer++)
+	{
+		int mode = (layer == 0) ? LAYERMODE_BASE : v->mode[layer];
+
+		// base layer: image data, control pairs of HSYNC, segments, front porch and end mark
+		if (layer == 0)
+		{
+			d = w + 8;
+			c = (w + 24)/4;
+		}
+
+		// inactive overlapped layer
+		else if (mode == LAYERMODE_BASE)
+		{
+			d = 0;
+			c = 0;
+		}
+
+		// sprites and transformation matrix: init word and rendered image data
+		else if (mode >= LAYERMODE_SPRITEKEY)
+		{
+			d = w + 8;
+			c = (w + 24)/4;
+		}
+
+		// other modes: init word, data are sent directly from image
+		else
+		{
+			d = 8;
+			c = 24/4;
+		}
+
+		// limit to max. size
+		if (d > LineBufMax[layer]) d = LineBufMax[layer];
+		if (c > CtrlBufMax[layer]) c = CtrlBufMax[layer];
+		if (dsize != NULL) dsize[layer] = d;
+		if (csize != NULL) csize[layer] = c;
+		n += 2*d + 2*c*4;
+	}
+
+	// black line
+	if (w > BLACK_MAX) w = BLACK_MAX;
+	return n + w;
+}
+
+// prepare layout of scanline buffers in arena
+void VgaBufLayout(const sVmode* v)
+{
+	int layer, d = 0, c = 0;
+	VgaArenaUsed = VgaBufNeed(v, LineBufSize, CtrlBufSize);
+	VgaArenaWidth = v->width;
+	for (layer = 0; layer < LAYERS; layer++)
+	{
+		d += LineBufSize[layer];
+		c += CtrlBufSize[layer];
+	}
+
+	u8* a = (u8*)VgaArena;
+	LineBuf1 = a;
+	a += d;
+	LineBuf2 = a;
+	a += d;
+	CtrlBuf1 = (u32*)a;
+	a += c*4;
+	CtrlBuf2 = (u32*)a;
+	a += c*4;
+	LineBuf0 = a;
+	LineBuf0Size = VgaArenaUsed - (a - (u8*)VgaArena);
+}
+
+// get unused rest of arena with scanline buffers (returns NULL if none)
+u8* VgaArenaFree(int* size)
+{
+	int n = ARENA_MAX - VgaArenaUsed;
+	*size = n;
+	return (n > 0) ? ((u8*)VgaArena + VgaArenaUsed) : NULL;
+}
+
+// debug print usage of arena with scanline buffers
+void VgaArenaPrint()
+{
+	int layer;
+	printf("arena=%u used=%u free=%u width=%u\n", ARENA_MAX, VgaArenaUsed, ARENA_MAX - VgaArenaUsed, VgaArenaWidth);
+	for (layer = 0; layer < LAYERS; layer++)
+		printf("layer%u: data=%u ctrl=%u\n", layer, LineBufSize[layer], CtrlBufSize[layer]*4);
+}
+
+// initialize scanline buffers
+void VgaBufInit()
+{
+	// init HSYNC..back porch and front porch buffers
+	VgaBufHsBp(&CurVmode, LineBufHsBp, &LineBufFp);
 
 	// init dark line
 	LineBufDark[0] = BYTESWAP(VGACMD(vga_offset_sync+BASE_OFFSET,CurVmode.hsync-3)); // HSYNC
@@ -736,6 +1025,10 @@ void VgaTerm()
 {
 	int i;
 
+	// driver is stopped, pending switch of geometry will not be applied
+	VgaActive = False;
+	VmodeNextReq = False;
+
 	// abort DMA channels
 	dma_channel_abort(VGA_DMA_PIO0); // pre-abort, could be chaining right now
 	dma_channel_abort(VGA_DMA_CB0);
@@ -772,7 +1065,12 @@ void VgaTerm()
 // initialize scanline type table
 void ScanlineTypeInit(const sVmode* v)
 {
-	u8* d = ScanlineType;
+	ScanlineTypeBuild(ScanlineType, v);
+}
+
+// build scanline type table into buffer
+void ScanlineTypeBuild(u8* d, const sVmode* v)
+{
 	int i, k;
 
 	// line 0 is not used
@@ -901,15 +1199,12 @@ void ScanlineTypePrint(const u8* scan, int lines)
 
 // initialize videomode (returns False on bad configuration)
 // - All layer modes must use same layer program (LAYERMODE_BASE = overlapped layers are OFF)
-void VgaInit(const sVmode* vmode)
+void VgaInit(const sVmode* vmode, Bool clk /* = False */)
 {
 	int i;
 
-	// stop old state
-	VgaTerm();
-
-	// initialize scanline type table
-	ScanlineTypeInit(vmode);
+	// prepare scanline type table, while old videomode is still running
+	ScanlineTypeBuild(ScanlineTypeNext, vmode);
 
 	// prepare render font pixel mask
 	for (i = 0; i < 256; i++)
@@ -941,8 +1236,42 @@ void VgaInit(const sVmode* vmode)
 		while (1) {}
 	}
 
+	// wait for start of frame of old videomode, to restart driver during vertical sync
+	if (VgaActive)
+	{
+		u32 t = time_us_32();
+		while ((ScanLine != 1) && ((u32)(time_us_32() - t) < (u32)50000)) { __dmb(); }
+	}
+
+	// stop old state
+	VgaTerm();
+
+	// set system clock
+	if (clk && (clock_get_hz(clk_sys) != vmode->freq*1000))
+	{
+		set_sys_clock_pll(vmode->vco*1000, vmode->pd1, vmode->pd2);
+
+		// reinitialize stdio UART (baudrate depends on peripheral clock)
+#if PICO_STDIO_UART
+		setup_default_uart();
+#endif
+	}
+
+	// use scanline type table
+	memcpy(ScanlineType, ScanlineTypeNext, vmode->vtot+1);
+
+	// use new screen layout
+	if (ScreenNext != NULL)
+	{
+		pScreen = ScreenNext;
+		ScreenNext = NULL;
+	}
+
+	// prepare layout of scanline buffers
+	VgaBufLayout(vmode);
+
 	// clear buffer with black color
-	memset(LineBuf0, COL_BLACK, BLACK_MAX);
+	memset(LineBuf0, COL_BLACK, LineBuf0Size);
 
 	// save current videomode
 	memcpy(&CurVmode, vmode, sizeof(sVmode));
@@ -991,17 +1320,24 @@ void VgaInit(const sVmode* vmode)
 
 	// run state machines
 	pio_enable_sm_mask_in_sync(VGA_PIO, LayerMask);
+	VgaActive = True;
 }
 
 const sVmode* volatile VgaVmodeReq = NULL; // request to reinitialize videomode, 1=only stop driver
+volatile Bool VgaVmodeClk = False; // request to set system clock on reinitialization
 
-void (* volatile Core1Fnc)() = NULL; // core 1 remote function
+// core 1 job queue
+sCore1Job Core1Job[CORE1_JOBS]; // ring buffer of jobs
+volatile u32 Core1Head = 0;	// number of posted jobs (written only by core 0)
+volatile u32 Core1Tail = 0;	// number of finished jobs (written only by core 1)
 
 // VGA core
 void VgaCore()
 {
 	const sVmode* v;
-	void (*fnc)();
+	sCore1Job* job;
+	u32 tail;
+	VgaCoreRun = True;
 	while (1)
 	{
 		__dmb();
@@ -1013,19 +1349,28 @@ void VgaCore()
 			if ((u32)v == (u32)1)
 				VgaTerm(); // terminate
 			else
-				VgaInit(v);
+				VgaInit(v, VgaVmodeClk);
 			__dmb();
 			VgaVmodeReq = NULL;
 		}
 
-		// execute remote function
-		fnc = Core1Fnc;
-		if (fnc != NULL)
+		// execute all pending jobs, break on videomode request
+		tail = Core1Tail;
+		if (tail != Core1Head)
 		{
-			fnc();
-			__dmb();
-			Core1Fnc = NULL;
+			do {
+				job = &Core1Job[tail & (CORE1_JOBS-1)];
+				job->fnc(job->arg);
+				if (job->done != NULL) *job->done = True;
+				__dmb();
+				tail++;
+				Core1Tail = tail;
+			} while ((tail != Core1Head) && (VgaVmodeReq == NULL));
 		}
+
+		// queue is empty - sleep until new request (SEV) or interrupt
+		else
+			__wfe();
 	}
 }
 
@@ -1035,25 +1380,138 @@ void VgaInitReq(const sVmode* vmode)
 	if (vmode == NULL) vmode = (const sVmode*)1;
 	__dmb();
 	VgaVmodeReq = vmode;
+	__sev();
 	while (VgaVmodeReq != NULL) { __dmb(); }
 }
 
-// execute core 1 remote function
-void Core1Exec(void (*fnc)())
+// check if videomodes have compatible timings (switch between them only changes geometry)
+Bool VgaVmodeCompat(const sVmode* v1, const sVmode* v2)
+{
+	return	(v1->freq == v2->freq) && (v1->div == v2->div) && (v1->cpp == v2->cpp) &&
+		(v1->prog == v2->prog) && (memcmp(v1->mode, v2->mode, LAYERS_MAX) == 0) &&
+		(v1->htot == v2->htot) && (v1->hsync == v2->hsync) && (v1->vtot == v2->vtot) &&
+		(v1->vsync1 == v2->vsync1) && (v1->vpost1 == v2->vpost1) && (v1->vpre1 == v2->vpre1) &&
+		(v1->vsync2 == v2->vsync2) && (v1->vpost2 == v2->vpost2) && (v1->vpre2 == v2->vpre2) &&
+		(v1->inter == v2->inter) && (v1->psync == v2->psync);
+}
+
+// switch videomode without stopping VGA core (returns True if only geometry has been changed)
+Bool VgaSwitch(const sVmode* vmode, sScreen* scr /* = NULL */)
+{
+	u32 t = time_us_32();
+	Bool compat = VgaActive && VgaVmodeCompat(&CurVmode, vmode) && (vmode->width <= VgaArenaWidth);
+
+	// compatible timings - apply new geometry at start of next frame
+	if (compat)
+	{
+		// prepare scanline type table and line buffers
+		ScanlineTypeBuild(ScanlineTypeNext, vmode);
+		VgaBufHsBp(vmode, LineBufHsBpNext, &LineBufFpNext);
+		memcpy(&VmodeNext, vmode, sizeof(sVmode));
+		ScreenNext = scr;
+
+		// request and wait for the switch
+		__dmb();
+		VmodeNextReq = True;
+		while (VmodeNextReq) { __dmb(); }
+	}
+
+	// reinitialize driver during vertical sync, set system clock if needed
+	else
+	{
+		ScreenNext = scr;
+		VgaVmodeClk = True;
+		VgaInitReq(vmode);
+		VgaVmodeClk = False;
+	}
+
+	VgaSwitchTime = time_us_32() - t;
+	return compat;
+}
+
+// post job to core 1 (returns sequence number of the job)
+u32 Core1Post(void (*fnc)(void*), void* arg, volatile Bool* done /* = NULL */)
 {
+	// wait for free slot
+	u32 head = Core1Head;
+	while (head - Core1Tail >= CORE1_JOBS) { __dmb(); }
+
+	// store job
+	sCore1Job* job = &Core1Job[head & (CORE1_JOBS-1)];
+	job->fnc = fnc;
+	job->arg = arg;
+	job->done = done;
+	if (done != NULL) *done = False;
+
+	// publish job and wake up core 1
 	__dmb();
-	Core1Fnc = fnc;
+	head++;
+	Core1Head = head;
+	__sev();
+	return head;
+}
+
+// post batch of jobs to core 1 (returns sequence number of the last job)
+u32 Core1PostBatch(const sCore1Job* job, int num)
+{
+	u32 head = Core1Head;
+	sCore1Job* d;
+	while (num > 0)
+	{
+		// wait for free slot
+		while (head - Core1Tail >= CORE1_JOBS) { __dmb(); }
+
+		// store jobs while there is free space
+		do {
+			d = &Core1Job[head & (CORE1_JOBS-1)];
+			*d = *job;
+			if (job->done != NULL) *job->done = False;
+			job++;
+			head++;
+			num--;
+		} while ((num > 0) && (head - Core1Tail < CORE1_JOBS));
+
+		// publish jobs and wake up core 1
+		__dmb();
+		Core1Head = head;
+		__sev();
+	}
+	return head;
+}
+
+// check if job with given sequence number has finished (all jobs before it have finished, too)
+Bool Core1Done(u32 seq)
+{
 	__dmb();
+	return (s32)(Core1Tail - seq) >= 0;
+}
+
+// wait for job with given sequence number to finish
+void Core1WaitJob(u32 seq)
+{
+	while (!Core1Done(seq)) {}
+}
+
+// job function of Core1Exec
+static void Core1ExecJob(void* arg)
+{
+	((void (*)())arg)();
+}
+
+// execute core 1 remote function (posts job without argument)
+void Core1Exec(void (*fnc)())
+{
+	Core1Post(Core1ExecJob, (void*)fnc);
 }
 
-// check if core 1 is busy (executing remote function)
+// check if core 1 is busy (executing jobs)
 Bool Core1Busy()
 {
 	__dmb();
-	return Core1Fnc != NULL;
+	return Core1Tail != Core1Head;
 }
 
-// wait if core 1 is busy (executing remote function)
+// wait if core 1 is busy (wait for all posted jobs to finish)
 void Core1Wait()
 {
 	while (Core1Busy()) {}
@@ -1068,3 +1526,60 @@ void WaitVSync()
 	// wait for start of VSync
 	while (!VSync) { __dmb(); }
 }
+
+// request to write word at start of next frame
+void VgaSwap(void* addr, u32 val)
+{
+	int i;
+	u32* a = (u32*)addr;
+
+	// replace pending request of the same word (if VGA core takes the old value
+	// meanwhile, the new request stays pending and is written in the next frame)
+	for (i = 0; i < SWAP_MAX; i++)
+	{
+		if ((SwapAddr[i] == a) && (SwapReq[i] != SwapAck[i]))
+		{
+			SwapVal[i] = val;
+			__dmb();
+			SwapReq[i]++;
+			__dmb();
+			return;
+		}
+	}
+
+	// use free slot, wait for start of next frame if all slots are busy
+	for (;;)
+	{
+		for (i = 0; i < SWAP_MAX; i++)
+		{
+			if (SwapReq[i] == SwapAck[i])
+			{
+				SwapAddr[i] = a;
+				SwapVal[i] = val;
+				__dmb();
+				SwapReq[i]++;
+				__dmb();
+				return;
+			}
+		}
+
+		// VGA core is not running, nothing can be displayed, write immediately
+		if (!VgaCoreRun)
+		{
+			*a = val;
+			__dmb();
+			return;
+		}
+		__dmb();
+	}
+}
+
+// check if requested write of the word has been done
+Bool VgaSwapDone(const void* addr)
+{
+	int i;
+	__dmb();
+	for (i = 0; i < SWAP_MAX; i++)
+		if ((SwapAddr[i] == (u32*)addr) && (SwapReq[i] != SwapAck[i])) return False;
+	return True;
+}
@@ -30,10 +30,41 @@ extern volatile int ScanLine;	// current scan line 1...
 extern volatile u32 Frame;	// frame counter
 extern volatile int BufInx;	// current buffer set (0..1)
 extern volatile Bool VSync;	// current scan line is vsync or dark
-
-// line buffers
-extern ALIGNED u8	LineBuf1[DBUF_MAX]; // scanline 1 image data
-extern ALIGNED u8	LineBuf2[DBUF_MAX]; // scanline 2 image data
+extern volatile Bool VgaCoreRun; // VGA core is running on core 1
+extern u32 VgaSwitchTime;	// duration of last videomode switch in [us] (measured by VgaSwitch)
+
+// requests to write words at start of frame (swap of buffers or tables)
+#define SWAP_MAX	4	// max. number of pending requests
+//  Slot is busy if SwapReq != SwapAck. SwapAddr, SwapVal and SwapReq are written only
+//  by core 0 (VgaSwap), SwapAck only by VGA core, so no request can be lost.
+extern u32*	SwapAddr[SWAP_MAX];	// address of word to write
+extern volatile u32 SwapVal[SWAP_MAX];	// new value of the word
+extern volatile u32 SwapReq[SWAP_MAX];	// number of requests of the slot (written only by core 0)
+extern volatile u32 SwapAck[SWAP_MAX];	// number of done requests of the slot (written only by core 1)
+
+// core 1 job queue (ring buffer, single producer on core 0, single consumer on core 1)
+#define CORE1_JOBS	16	// max. number of pending jobs (must be power of 2)
+typedef struct {
+	void	(*fnc)(void* arg);	// job function
+	void*	arg;			// argument of job function
+	volatile Bool* done;		// completion flag, set to True after job finishes (NULL = not used)
+} sCore1Job;
+extern sCore1Job Core1Job[CORE1_JOBS]; // ring buffer of jobs
+extern volatile u32 Core1Head;	// number of posted jobs (written only by core 0)
+extern volatile u32 Core1Tail;	// number of finished jobs (written only by core 1)
+
+// arena with scanline buffers (layout is set on videomode initialization)
+// Arena is a static array of ARENA_MAX bytes (worst case of the configuration), it
+// is never returned to the heap: newlib malloc cannot take over a part of a static
+// block, and allocating on core 1 during VgaInit is not safe. Unused rest of the
+// arena is lent to the application by VgaArenaFree instead.
+extern u32	VgaArena[(ARENA_MAX+3)/4];
+extern int	VgaArenaUsed;		// used size of arena in bytes
+extern int	VgaArenaWidth;		// width of videomode the arena is prepared for
+
+// line buffers (allocated from arena)
+extern u8*	LineBuf1;		// scanline 1 image data
+extern u8*	LineBuf2;		// scanline 2 image data
 extern int	LineBufSize[LAYERS_MAX]; // size of data buffers
 extern u32	LineBufHsBp[4];		// HSYNC ... back porch-1 ... IRQ command ... image command
 extern u32	LineBufFp;		// front porch+1
@@ -45,11 +76,12 @@ extern u32	LineBufSync[10];	// vertical synchronization
 				//	1x half synchronization (HSYNC pulse/2 ... line dark/2)
 				// progressive: 1x scanline with vertical synchronization (invert line dark ... invert HSYNC pulse)
 
-extern	ALIGNED u8	LineBuf0[BLACK_MAX]; // line buffer with black color (used to clear rest of scanline)
+extern u8*	LineBuf0;		// line buffer with black color (used to clear rest of scanline)
+extern int	LineBuf0Size;		// size of line buffer with black color
 
-// control buffers
-extern u32	CtrlBuf1[CBUF_MAX];	// control pairs: u32 count, read address (must be terminated with [0,0])
-extern u32	CtrlBuf2[CBUF_MAX];	// control pairs: u32 count, read address (must be terminated with [0,0])
+// control buffers (allocated from arena)
+extern u32*	CtrlBuf1;		// control pairs: u32 count, read address (must be terminated with [0,0])
+extern u32*	CtrlBuf2;		// control pairs: u32 count, read address (must be terminated with [0,0])
 
 extern int	CtrlBufSize[LAYERS_MAX]; // size of control buffers
 
@@ -104,15 +136,49 @@ extern "C" void RenderPersp2(u8* dbuf, int y, sLayer* scr);
 // Returns new pointer to control buffer
 extern "C" u32* Render(u32* cbuf, u8* dbuf, int line, int pixnum);
 
+// apply blinking and text cursor to rendered text segment GF_ATEXT, GF_FTEXT or GF_CTEXT
+//  dbuf ... start of rendered data in data buffer
+//  x ... start X coordinate (in pixels, multiple of 4)
+//  y ... start Y coordinate (in graphics lines)
+//  w ... rendered width (multiple of 4)
+//  segm ... video segment
+extern "C" void RenderTextPost(u8* dbuf, int x, int y, int w, sSegm* segm);
+
+// calculate size of scanline buffers (returns total size in bytes)
+//  v ... videomode
+//  dsize ... output sizes of data buffers of layers in bytes (NULL = not used)
+//  csize ... output sizes of control buffers of layers in u32 (NULL = not used)
+// Sizes depend on width and on layer modes, limited by DBUFn_MAX and CBUFn_MAX.
+int VgaBufNeed(const sVmode* v, int* dsize, int* csize);
+
+// prepare layout of scanline buffers in arena (called from VgaInit)
+void VgaBufLayout(const sVmode* v);
+
+// get unused rest of arena with scanline buffers (returns NULL if none)
+//  size ... output size of free memory in bytes
+// Memory can be used by application until next initialization of videomode. It is
+// not changed by VgaSwitch with compatible timings and width not greater.
+u8* VgaArenaFree(int* size);
+
+// debug print usage of arena with scanline buffers
+void VgaArenaPrint();
+
 // initialize scanline type table
 void ScanlineTypeInit(const sVmode* v);
 
+// build scanline type table into buffer (MAXLINE entries)
+void ScanlineTypeBuild(u8* d, const sVmode* v);
+
 // print table if scanline types
 void ScanlineTypePrint(const u8* scan, int lines);
 
 // initialize videomode (returns False on bad configuration)
+//  vmode ... videomode setup
+//  clk ... set system clock to vmode->freq if it differs (changes also peripheral clock,
+//	stdio UART is reinitialized)
 // - All layer modes must use same layer program (LAYERMODE_BASE = overlapped layers are OFF)
-void VgaInit(const sVmode* vmode); //, u8 layer1mode=LAYERMODE_BASE, u8 layer2mode=LAYERMODE_BASE, u8 layer3mode=LAYERMODE_BASE);
+// - If driver is running, it is restarted at start of frame (during vertical sync).
+void VgaInit(const sVmode* vmode, Bool clk = False); //, u8 layer1mode=LAYERMODE_BASE, u8 layer2mode=LAYERMODE_BASE, u8 layer3mode=LAYERMODE_BASE);
 
 // VGA core
 void VgaCore();
@@ -120,16 +186,70 @@ void VgaCore();
 // request to initialize VGA videomode, NULL=only stop driver (wait to initialization completes)
 void VgaInitReq(const sVmode* vmode);
 
-// execute core 1 remote function
+// check if videomodes have compatible timings (switch between them only changes geometry)
+//  Timings are compatible if system clock, PIO setup, layer modes, line length, sync
+//  pulses and total number of scanlines are equal. Width, height, porches, dbly
+//  and vertical position may differ.
+Bool VgaVmodeCompat(const sVmode* v1, const sVmode* v2);
+
+// switch videomode without stopping VGA core (returns True if only geometry has been changed)
+//  vmode ... new videomode setup
+//  scr ... new screen layout, set at the same time (NULL = keep current pScreen)
+//	- prepare it in a screen that is not displayed, pScreen is replaced at start of frame
+// VGA core must be running. Function waits until the switch completes, duration
+// is stored into VgaSwitchTime. With compatible timings (see VgaVmodeCompat), new
+// scanline tables are pre-built and applied at start of next frame, PIO, DMA and
+// clocks are not touched and monitor stays in sync. Otherwise the driver is
+// reinitialized at start of frame and system clock is set if it differs.
+// Latency is the wait for next frame (up to 1 frame period) plus the switch itself
+// (table copy in the IRQ, or PIO/DMA reinitialization and PLL lock time); check
+// VgaSwitchTime on the target to get real value.
+Bool VgaSwitch(const sVmode* vmode, sScreen* scr = NULL);
+
+// post job to core 1 (returns sequence number of the job)
+//  fnc ... job function, called on core 1 from VGA core loop
+//  arg ... argument of job function
+//  done ... completion flag, cleared here and set to True after job finishes (NULL = not used)
+// Jobs are executed in order, between scanline interrupts. If queue is full, function
+// waits for a free slot. Core 1 sleeps (WFE) while queue is empty and it is woken by SEV.
+u32 Core1Post(void (*fnc)(void*), void* arg, volatile Bool* done = NULL);
+
+// post batch of jobs to core 1 (returns sequence number of the last job)
+//  job ... list of jobs
+//  num ... number of jobs (can be more than CORE1_JOBS)
+// Jobs are published together, with one memory barrier and one wake-up event per filled queue.
+u32 Core1PostBatch(const sCore1Job* job, int num);
+
+// check if job with given sequence number has finished (all jobs before it have finished, too)
+Bool Core1Done(u32 seq);
+
+// wait for job with given sequence number to finish
+void Core1WaitJob(u32 seq);
+
+// execute core 1 remote function (posts job without argument)
 void Core1Exec(void (*fnc)());
 
-// check if core 1 is busy (executing remote function)
+// check if core 1 is busy (executing jobs)
 Bool Core1Busy();
 
-// wait if core 1 is busy (executing remote function)
+// wait if core 1 is busy (wait for all posted jobs to finish)
 void Core1Wait();
 
 // wait for VSync scanline
 void WaitVSync();
 
+// request to write word at start of next frame (in vertical blanking)
+//  addr ... address of the word (e.g. &segm->data or &segm->par)
+//  val ... new value of the word
+// Pending request of the same word is replaced. Word is written by VGA core on first
+// scanline of the frame. If all SWAP_MAX slots are busy, waits for start of next frame
+// (word is written immediately if VGA core is not running). Call only from core 0.
+void VgaSwap(void* addr, u32 val);
+
+// check if requested write of the word has been done
+Bool VgaSwapDone(const void* addr);
+
+// request to swap data buffer of video segment at start of next frame
+inline void VgaSwapData(sSegm* segm, const void* data) { VgaSwap((void*)&segm->data, (u32)data); }
+
 #endif // _VGA_H
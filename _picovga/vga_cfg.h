@@ -0,0 +1,308 @@
+// ****************************************************************************
+//
+//                          VGA videomode calculation
+//
+// ****************************************************************************
+// Videomode calculation is constexpr, so fixed videomodes can be prepared at
+// compile time, without float code and PLL search at runtime:
+//
+//   constexpr sVmode MyVmode = [] {
+//	sVgaCfg cfg = {};
+//	VgaCfgDef(&cfg);
+//	cfg.video = &VideoVGA;
+//	cfg.width = 320;
+//	cfg.height = 240;
+//	cfg.dbly = True;
+//	return VgaCfgConst(&cfg); }();
+//   static_assert(VgaVmodeValid(&MyVmode), "invalid videomode");
+//
+// VgaCfg in vga_vmode.cpp is runtime variant, for dynamic videomodes.
+
+#ifndef _VGA_CFG_H
+#define _VGA_CFG_H
+
+#define VGACFG_INPUT	12000	// PLL input frequency in kHz, used at compile time (crystal 12 MHz)
+
+// initialize default VGA configuration
+constexpr void VgaCfgDef(sVgaCfg* cfg)
+{
+	cfg->width = 640;		// width in pixels
+	cfg->height = 480;		// height in lines
+	cfg->wfull = 0;			// width of full screen, corresponding to 'hfull' time (0=use 'width' parameter)
+	cfg->video = &VideoVGA;		// used video timings
+	cfg->freq = 120000;		// required minimal system frequency in kHz (real frequency can be higher)
+	cfg->fmax = 270000;		// maximal system frequency in kHz (limit resolution if needed)
+	cfg->cpuline = 0;		// required minimal system clocks per scanline, CPU budget of rendering (0=no limit)
+	cfg->mode[0] = LAYERMODE_BASE;	// modes of overlapped layers 0..3 LAYERMODE_* (LAYERMODE_BASE = layer is off)
+	cfg->mode[1] = LAYERMODE_BASE;	// - mode of layer 0 is ignored (always use LAYERMODE_BASE)
+	cfg->mode[2] = LAYERMODE_BASE;	// - all overlapped layers must use same layer program
+	cfg->mode[3] = LAYERMODE_BASE;
+	cfg->dbly = False;		// double in Y direction
+	cfg->lockfreq = False;		// lock required frequency, do not change it
+}
+
+// calculate videomode setup
+//   cfg ... required configuration
+//   vmode ... destination videomode setup for driver
+//   input ... PLL input frequency in kHz (VGACFG_INPUT, or use clock_get_hz(clk_ref)/1000)
+constexpr void VgaCfgCalc(const sVgaCfg* cfg, sVmode* vmode, u32 input)
+{
+	int i = 0;
+
+	// prepare layer program, copy layer modes
+	u8 prog = LAYERMODE_BASE;
+	vmode->mode[0] = prog;
+	for (i = 1; i < LAYERS; i++)
+	{
+		if (cfg->mode[i] != LAYERMODE_BASE) prog = LayerMode[cfg->mode[i]].prog;
+		vmode->mode[i] = cfg->mode[i];
+	}
+	vmode->prog = prog;
+
+	// prepare minimal and maximal clocks per pixel
+	int mincpp = LayerMode[LAYERMODE_BASE].mincpp;
+	int maxcpp = LayerMode[LAYERMODE_BASE].maxcpp;
+	int cpp = 0;
+	for (i = 1; i < LAYERS; i++)
+	{
+		cpp = LayerMode[cfg->mode[i]].mincpp;
+		if (cpp > mincpp) mincpp = cpp;
+		cpp = LayerMode[cfg->mode[i]].maxcpp;
+		if (cpp < maxcpp) maxcpp = cpp;
+	}
+
+	// prepare full width
+	int w = cfg->width; // required width
+	int wfull = cfg->wfull;	// full width
+	if (wfull == 0) wfull = w; // use required width as 100% width
+
+	// prepare maximal active time and maximal pixels
+	const sVideo* v = cfg->video;
+	float hmax = v->htot - v->hfront - v->hsync - v->hback;
+	float hfull = v->hfull;
+	int wmax = (int)(wfull*hmax/hfull + 0.001f);
+
+	// search best timing setup (if frequency is not locked)
+	u32 freq = 0;
+	int div = 0;
+	sVgaSolve s = {};
+	if (!cfg->lockfreq && (VgaSolve(v, wfull, cfg->freq, cfg->fmax, mincpp, maxcpp,
+		cfg->cpuline, input, &s, 1) > 0))
+	{
+		freq = s.freq;
+		vmode->freq = freq;
+		vmode->vco = s.vco;
+		vmode->fbdiv = s.fbdiv;
+		vmode->pd1 = s.pd1;
+		vmode->pd2 = s.pd2;
+		div = s.div;
+		cpp = s.cpp;
+	}
+	else
+	{
+		// calculate cpp from required frequency (rounded down), limit minimal cpp
+		freq = cfg->freq;
+		cpp = (int)(freq*hfull/1000/wfull + 0.1f);
+		if (cpp < mincpp) cpp = mincpp;
+
+		// recalculate frequency if not locked
+		if (!cfg->lockfreq)
+		{
+			int freq2 = (int)(cpp*wfull*1000/hfull + 0.5f) + 200;
+			if (freq2 < freq)
+			{
+				cpp++;
+				freq2 = (int)(cpp*wfull*1000/hfull + 0.5f) + 200;
+			}
+			if (freq2 >= freq) freq = freq2;
+			if (freq > cfg->fmax) freq = cfg->fmax;
+		}
+
+		// find sysclock setup (use set_sys_clock_pll to set sysclock)
+		u32 vco = 0;
+		u16 fbdiv = 0;
+		u8 pd1 = 0, pd2 = 0;
+		vcocalc(freq, input, 400000, 1600000, false, &freq, &vco, &fbdiv, &pd1, &pd2);
+
+		vmode->freq = freq;
+		vmode->vco = vco;
+		vmode->fbdiv = fbdiv;
+		vmode->pd1 = pd1;
+		vmode->pd2 = pd2;
+
+		// calculate divisor
+		cpp = (int)(freq*hfull/1000/wfull + 0.2f);
+		div = 1;
+		while (cpp > maxcpp)
+		{
+			div++;
+			cpp = (int)(freq*hfull/1000/wfull/div + 0.2f);
+		}
+	}
+
+	vmode->div = div;
+	vmode->cpp = cpp;
+
+	// calculate new full resolution and max resolution
+	wfull = (int)(freq*hfull/1000/cpp/div + 0.4f);
+	wmax = (int)(freq*hmax/1000/cpp/div + 0.4f);
+
+	// limit resolution
+	if (w > wmax) w = wmax;
+	w = ALIGN4(w);
+	vmode->width = w; // active width
+	vmode->wfull = wfull; // width of full screen (image should be full visible)
+	vmode->wmax = wmax; // maximal width (can be > wfull)
+
+	// horizontal timings
+	int hwidth = w*cpp; // active width in state machine clocks
+	int htot = (int)(freq*v->htot/1000/div + 0.5f);  // total state machine clocks per line
+	int hsync = (int)(freq*v->hsync/1000/div + 0.5f); // H sync pulse in state machine clocks (min. 4)
+
+	if (hsync < 4)
+	{
+		htot -= 4 - hsync;
+		hsync = 4;
+	}
+
+	int hfront = (int)(freq*v->hfront/1000/div + 0.5f); // H front porch in state machine clocks (min. 2)
+	int hback = (int)(freq*v->hback/1000/div + 0.5f); // H back porch in state machine clocks (min. 13)
+	int d = htot - hfront - hsync - hback - hwidth; // difference
+	hfront += d/2;
+	hback += (d < 0) ? (d-1)/2 : (d+1)/2;
+
+	if (hfront < 4)
+	{
+		hback -= 4 - hfront;
+		hfront = 4;
+	}
+
+	if (hback < 13)
+	{
+		hfront -= 13 - hback;
+		hback = 13;
+
+		if (hfront < 2) hfront = 2;
+	}
+
+	htot = hfront + hsync + hback + hwidth; // total state machine clocks per line
+
+	// interliced htot must be even (to enable split to half-sync)
+	if (v->inter && ((htot & 1) != 0))
+	{
+		htot--;
+		hfront++;
+	}
+
+	vmode->htot = (u16)htot; // total state machine clocks per line
+	vmode->hfront = (u16)hfront; // H front porch in state machine clocks (min. 2)
+	vmode->hsync = (u16)hsync; // H sync pulse in state machine clocks (min. 4)
+	vmode->hback = (u16)hback; // H back porch in state machine clocks (min. 13)
+
+	// vertical timings
+	int h = cfg->height; // required height
+	if (cfg->dbly) h *= 2; // use double lines
+	vmode->vmax = v->vmax; // maximal height
+	if (h > v->vmax) h = v->vmax; // limit height
+	if (cfg->dbly) h &= ~1; // must be even number if double lines
+
+	int vact1 = h;	// active lines in progress mode
+	int vact2 = 0;
+	if (v->inter) // interlaced
+	{
+		if (v->odd) // first frame is odd lines
+		{
+			vact1 = h/2;
+			vact2 = (h+1)/2; // if even lines, even frame will have more lines
+		}
+		else
+		{
+			vact1 = (h+1)/2; // if even lines, even frame will have more lines
+			vact2 = h/2;
+		}
+	}
+
+	if (cfg->dbly) h /= 2; // return double lines to single lines
+	vmode->height = h;
+
+	// vertical timings
+	vmode->vtot = v->vtot; // total scanlines
+
+	vmode->vact1 = vact1; // active scanlines of 1st subframe
+	int dh = vact1 - v->vact1; // difference
+	vmode->vsync1 = v->vsync1; // V sync (half-)pulses on subframe 1
+	vmode->vpost1 = v->vpost1; // V sync post (half-)pulses on subframe 1
+	vmode->vback1 = v->vback1 - dh/2; // V back porch (after VSYNC, before image) on subframe 1
+	vmode->vfront1 = v->vfront1 - ((dh < 0) ? (dh-1)/2 : (dh+1)/2); // V front porch (after image, before VSYNC) on subframe 1
+	vmode->vpre1 = v->vpre1; // V sync pre (half-)pulses on subframe 1
+
+	vmode->vact2 = vact2; // active scanlines of 2nd subframe
+	dh = vact2 - v->vact2; // difference
+	vmode->vsync2 = v->vsync2; // V sync half-pulses on subframe 2
+	vmode->vpost2 = v->vpost2; // V sync post half-pulses on subframe 2
+	vmode->vback2 = v->vback2 - dh/2; // V back porch (after VSYNC, before image) on subframe 2
+	vmode->vfront2 = v->vfront2 - ((dh < 0) ? (dh-1)/2 : (dh+1)/2); // V front porch (after image, before VSYNC) on subframe 2
+	vmode->vpre2 = v->vpre2; // V sync pre half-pulses on subframe 2
+
+	// frequency
+	vmode->hfreq = vmode->freq * 1000.0f / vmode->div / vmode->htot;
+	vmode->vfreq = vmode->hfreq / vmode->vtot;
+
+	// name
+	vmode->name = v->name;	// video timing name
+
+	// flags
+	vmode->lockfreq = cfg->lockfreq; // lock current frequency, do not change it
+	vmode->dbly = cfg->dbly; // double scanlines
+	vmode->inter = v->inter; // interlaced (use sub-frames)
+	vmode->psync = v->psync; // positive synchronization
+	vmode->odd = v->odd; // first sub-frame is odd lines 1, 3, 5,... (PAL)
+
+	// first active scanline
+	if (v->inter)
+	{
+		// interlaced
+		vmode->vfirst1 = (vmode->vsync1 + vmode->vpost1)/2 + vmode->vback1 + 1; 
+		vmode->vfirst2 = vmode->vfirst1 + vmode->vact1 + vmode->vfront1 + 
+			(vmode->vpre1 + vmode->vsync2 + vmode->vpost2)/2 + vmode->vback2;
+	}
+	else
+	{
+		// progressive
+		vmode->vfirst1 = vmode->vsync1 + vmode->vback1 + 1;
+		vmode->vfirst2 = 0;
+	}
+}
+
+// calculate videomode setup at compile time
+//   cfg ... required configuration
+constexpr sVmode VgaCfgConst(const sVgaCfg* cfg)
+{
+	sVmode vmode = {};
+	VgaCfgCalc(cfg, &vmode, VGACFG_INPUT);
+	return vmode;
+}
+
+// check if videomode setup is valid (use with static_assert)
+constexpr Bool VgaVmodeValid(const sVmode* vmode)
+{
+	// system clock and PLL
+	if ((vmode->freq == 0) || (vmode->vco < 400000) || (vmode->vco > 1600000) ||
+		(vmode->pd1 < 1) || (vmode->pd1 > 7) || (vmode->pd2 < 1) || (vmode->pd2 > 7)) return False;
+
+	// state machine clock
+	if ((vmode->div < 1) || (vmode->cpp < LayerMode[LAYERMODE_BASE].mincpp)) return False;
+
+	// resolution
+	if ((vmode->width == 0) || (vmode->width > vmode->wmax) || (vmode->height == 0)) return False;
+
+	// horizontal timings (PIO minimums)
+	if ((vmode->hsync < 4) || (vmode->hback < 13) || (vmode->hfront < 2)) return False;
+	if (vmode->htot != vmode->hfront + vmode->hsync + vmode->hback + vmode->width*vmode->cpp) return False;
+
+	// vertical timings
+	if ((vmode->vact1 == 0) || (vmode->vfirst1 == 0) || (vmode->vfirst1 + vmode->vact1 > vmode->vtot)) return False;
+	return True;
+}
+
+#endif // _VGA_CFG_H
@@ -121,143 +121,6 @@ const sLayerProg LayerProg[LAYERPROG_NUM] = {
 u8 LayerProgInx;		// index of current layer program (LAYERPROG_*)
 sLayerProg CurLayerProg;	// copy of current layer program
 
-// layer mode descriptors
-const sLayerMode LayerMode[LAYERMODE_NUM] = {
-
-	// LAYERMODE_BASE base layer
-	{
-		.prog=LAYERPROG_BASE,	// layer program (LAYERPROG_*)
-		.mincpp=2,		// minimal clock cycles per pixel
-		.maxcpp=17,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_KEY layers with key color
-	{
-		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
-		.mincpp=6,		// minimal clock cycles per pixel
-		.maxcpp=37,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_BLACK layers with black key color
-	{
-		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=34,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_WHITE layers with white key color
-	{
-		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=35,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_MONO layers with mono pattern
-	{
-		.prog=LAYERPROG_MONO,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=35,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_COLOR layers with simple color
-	{
-		.prog=LAYERPROG_MONO,	// layer program (LAYERPROG_*)
-		.mincpp=2,		// minimal clock cycles per pixel
-		.maxcpp=33,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_RLE layers with RLE compression
-	{
-		.prog=LAYERPROG_RLE,	// layer program (LAYERPROG_*)
-		.mincpp=3,		// minimal clock cycles per pixel
-		.maxcpp=32,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_SPRITEKEY layers with sprites with key color
-	{
-		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
-		.mincpp=6,		// minimal clock cycles per pixel
-		.maxcpp=37,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_SPRITEBLACK layers with sprites with black key color
-	{
-		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=34,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_SPRITEWHITE layers with sprites with white key color
-	{
-		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=35,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_FASTSPRITEKEY layers with fast sprites with key color
-	{
-		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
-		.mincpp=6,		// minimal clock cycles per pixel
-		.maxcpp=37,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_FASTSPRITEBLACK layers with fast sprites with black key color
-	{
-		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=34,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_FASTSPRITEWHITE layers with fast sprites with white key color
-	{
-		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=35,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_PERSPKEY layer with key color and image with transformation matrix
-	{
-		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
-		.mincpp=6,		// minimal clock cycles per pixel
-		.maxcpp=37,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_PERSPBLACK layer with black key color and image with transformation matrix
-	{
-		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=34,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_PERSPWHITE layer with white key color and image with transformation matrix
-	{
-		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=35,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_PERSP2KEY layer with key color and double pixel image with transformation matrix
-	{
-		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
-		.mincpp=6,		// minimal clock cycles per pixel
-		.maxcpp=37,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_PERSP2BLACK layer with black key color and double pixel image with transformation matrix
-	{
-		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=34,		// maximal clock cycles per pixel
-	},
-
-	// LAYERMODE_PERSP2WHITE layer with white key color and double pixel image with transformation matrix
-	{
-		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
-		.mincpp=4,		// minimal clock cycles per pixel
-		.maxcpp=35,		// maximal clock cycles per pixel
-	},
-};
-
 // current layer mode of layers
 u8 LayerModeInx[LAYERS];	// index of current layer mode (LAYERMODE_*)
 sLayerMode CurLayerMode[LAYERS]; // copy of current layer mode
@@ -66,8 +66,142 @@ typedef struct {
 	u8	maxcpp;		// maximal clock cycles per pixel
 } sLayerMode;
 
-// layer mode descriptors
-extern const sLayerMode LayerMode[LAYERMODE_NUM];
+// layer mode descriptors (constexpr, to be usable in compile-time videomode setup)
+inline constexpr sLayerMode LayerMode[LAYERMODE_NUM] = {
+
+	// LAYERMODE_BASE base layer
+	{
+		.prog=LAYERPROG_BASE,	// layer program (LAYERPROG_*)
+		.mincpp=2,		// minimal clock cycles per pixel
+		.maxcpp=17,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_KEY layers with key color
+	{
+		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
+		.mincpp=6,		// minimal clock cycles per pixel
+		.maxcpp=37,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_BLACK layers with black key color
+	{
+		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=34,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_WHITE layers with white key color
+	{
+		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=35,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_MONO layers with mono pattern
+	{
+		.prog=LAYERPROG_MONO,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=35,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_COLOR layers with simple color
+	{
+		.prog=LAYERPROG_MONO,	// layer program (LAYERPROG_*)
+		.mincpp=2,		// minimal clock cycles per pixel
+		.maxcpp=33,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_RLE layers with RLE compression
+	{
+		.prog=LAYERPROG_RLE,	// layer program (LAYERPROG_*)
+		.mincpp=3,		// minimal clock cycles per pixel
+		.maxcpp=32,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_SPRITEKEY layers with sprites with key color
+	{
+		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
+		.mincpp=6,		// minimal clock cycles per pixel
+		.maxcpp=37,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_SPRITEBLACK layers with sprites with black key color
+	{
+		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=34,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_SPRITEWHITE layers with sprites with white key color
+	{
+		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=35,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_FASTSPRITEKEY layers with fast sprites with key color
+	{
+		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
+		.mincpp=6,		// minimal clock cycles per pixel
+		.maxcpp=37,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_FASTSPRITEBLACK layers with fast sprites with black key color
+	{
+		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=34,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_FASTSPRITEWHITE layers with fast sprites with white key color
+	{
+		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=35,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_PERSPKEY layer with key color and image with transformation matrix
+	{
+		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
+		.mincpp=6,		// minimal clock cycles per pixel
+		.maxcpp=37,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_PERSPBLACK layer with black key color and image with transformation matrix
+	{
+		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=34,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_PERSPWHITE layer with white key color and image with transformation matrix
+	{
+		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=35,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_PERSP2KEY layer with key color and double pixel image with transformation matrix
+	{
+		.prog=LAYERPROG_KEY,	// layer program (LAYERPROG_*)
+		.mincpp=6,		// minimal clock cycles per pixel
+		.maxcpp=37,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_PERSP2BLACK layer with black key color and double pixel image with transformation matrix
+	{
+		.prog=LAYERPROG_BLACK,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=34,		// maximal clock cycles per pixel
+	},
+
+	// LAYERMODE_PERSP2WHITE layer with white key color and double pixel image with transformation matrix
+	{
+		.prog=LAYERPROG_WHITE,	// layer program (LAYERPROG_*)
+		.mincpp=4,		// minimal clock cycles per pixel
+		.maxcpp=35,		// maximal clock cycles per pixel
+	},
+};
 
 // current layer mode of layers
 extern u8 LayerModeInx[LAYERS];	// index of current layer mode (LAYERMODE_*)
@@ -164,6 +298,12 @@ void LayerSetup(u8 inx, const u8* img, const sVmode* vmode, u16 w, u16 h, u8 col
 void LayerPerspSetup(u8 inx, const u8* img, const sVmode* vmode, u16 w, u16 h, u8 xbits, u8 ybits,
 	s8 horiz, const int* mat, u8 col = 0);
 
+// setup overlapped layer 1..3 for LAYERMODE_PERSP* modes, with fixed-point matrix
+//  mat ... fixed-point transformation matrix (layer uses it directly, it must stay valid)
+inline void LayerPerspSetup(u8 inx, const u8* img, const sVmode* vmode, u16 w, u16 h, u8 xbits, u8 ybits,
+	s8 horiz, const cMat2Di* mat, u8 col = 0)
+	{ LayerPerspSetup(inx, img, vmode, w, h, xbits, ybits, horiz, mat->Int(), col); }
+
 // setup overlapped layer 1..3 for LAYERMODE_SPRITE* and LAYERMODE_FASTSPRITE* modes
 //  inx ... layer index 1..3
 //  sprite ... pointer to list of sprites (array of pointers to sprites; sorted by X on LAYERMODE_FASTSPRITE* modes)
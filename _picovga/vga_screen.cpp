@@ -10,6 +10,11 @@
 // current video screen
 sScreen Screen = { .num = 0 };	// default video screen
 sScreen* pScreen = &Screen;	// pointer to current video screen
+sScreen VideoScreen = { .num = 0 }; // spare video screen (Video() prepares new layout in screen not being displayed)
+
+// text cursor and blinking
+sTextCursor TextCursor = { .segm = NULL };	// text cursor
+u8 TextBlink = 5;		// text blinking, number of frame counter bits of half period (default 5 = 32 frames)
 
 // clear screen (set 0 strips, does not modify sprites)
 void ScreenClear(sScreen* s)
@@ -46,6 +51,7 @@ sSegm* ScreenAddSegm(sStrip* strip, int width)
 	g->data = NULL;
 	g->form = GF_COLOR;
 	g->dbly = false;
+	g->dblx = DBLX_1;
 	g->par = 0;
 	g->par2 = 0;
 	__dmb();
@@ -54,6 +60,53 @@ sSegm* ScreenAddSegm(sStrip* strip, int width)
 	return g;
 }
 
+// set text cursor
+//   segm = video segment with text GF_ATEXT, GF_FTEXT or GF_CTEXT
+//   x = cursor column (in characters)
+//   y = cursor row (in characters)
+//   top = first font line of cursor shape (0 = block cursor, fontheight-2 = underline cursor)
+//   bottom = last font line of cursor shape (usually fontheight-1)
+//   col = cursor color mask (XORed with pixels, 0xff = invert)
+//   blink = cursor blinking, number of frame counter bits of half period (0 = no blinking, 4 = 16 frames)
+void ScreenCursor(sSegm* segm, int x, int y, u8 top, u8 bottom, u8 col, u8 blink)
+{
+	TextCursor.segm = NULL;
+	__dmb();
+	TextCursor.x = x;
+	TextCursor.y = y;
+	TextCursor.top = top;
+	TextCursor.bottom = bottom;
+	TextCursor.col = col;
+	TextCursor.blink = blink;
+	__dmb();
+	TextCursor.segm = segm;
+	__dmb();
+}
+
+// set text cursor position
+void ScreenCursorPos(int x, int y)
+{
+	TextCursor.x = x;
+	TextCursor.y = y;
+	__dmb();
+}
+
+// hide text cursor
+void ScreenCursorOff()
+{
+	TextCursor.segm = NULL;
+	__dmb();
+}
+
+// set blinking of text segment (call after setting text format)
+//   segm = video segment with text GF_ATEXT, GF_FTEXT or GF_CTEXT
+//   mask = mask of blink bits in byte after character (0 = no blinking, 0x80 = bit 7 of attributes)
+void ScreenSegmBlink(sSegm* segm, u8 mask)
+{
+	segm->par3 = (segm->par3 & 0xff) | ((u16)mask << 8);
+	__dmb();
+}
+
 // set video segment to simple color format GF_COLOR
 //  col1 = color pattern 4-pixels even line (use macro MULTICOL)
 //  col2 = color pattern 4-pixels odd line (use macro MULTICOL)
@@ -705,3 +758,320 @@ void ScreenSegmTilePersp4(sSegm* segm, const u8* map, const u8* tiles, const int
 	segm->form = GF_TILEPERSP4;
 	__dmb();
 }
+
+// generate proportional font for function ScreenSegmPText
+//   dst = pointer to destination font buffer, size (fontheight+1)*256 bytes
+//   src = pointer to source 1-bit font of 256 characters of width 8 (total width of image 2048 pixels)
+//   fontheight = font height
+//   spacing = number of blank pixels after glyph (usually 1)
+//   space = width of empty glyphs (usually 3 or 4)
+// Glyphs are shifted left to remove empty columns and their advances (width + spacing)
+// are stored into line with index "fontheight" of destination buffer. Returns False
+// if some advance is out of range 0..PTEXT_MAXW (font is not usable).
+Bool GenPTextFont(u8* dst, const u8* src, int fontheight, int spacing, int space)
+{
+	int ch, y, left, w;
+	u8 mask;
+	for (ch = 0; ch < 256; ch++)
+	{
+		// collect pixels of all lines of the glyph
+		mask = 0;
+		for (y = 0; y < fontheight; y++) mask |= src[y*256 + ch];
+
+		// empty glyph
+		if (mask == 0)
+		{
+			for (y = 0; y < fontheight; y++) dst[y*256 + ch] = 0;
+			w = space;
+		}
+		else
+		{
+			// number of empty columns on left side
+			left = 0;
+			while ((mask & 0x80) == 0) { mask <<= 1; left++; }
+
+			// width of used columns
+			w = 8;
+			while ((mask & 1) == 0) { mask >>= 1; w--; }
+			w -= left;
+
+			// shift glyph left
+			for (y = 0; y < fontheight; y++) dst[y*256 + ch] = (u8)(src[y*256 + ch] << left);
+
+			// add spacing
+			w += spacing;
+		}
+
+		// store glyph advance
+		if ((w < 0) || (w > PTEXT_MAXW)) return False;
+		dst[fontheight*256 + ch] = (u8)w;
+	}
+	return True;
+}
+
+// get width of text in pixels, using proportional font
+//   text = text
+//   len = length of text
+//   font = pointer to proportional font (generated with GenPTextFont function)
+//   fontheight = font height
+int PTextWidth(const char* text, int len, const u8* font, int fontheight)
+{
+	const u8* wtab = &font[fontheight*256];
+	int w = 0;
+	for (; len > 0; len--) w += wtab[(u8)*text++];
+	return w;
+}
+
+// set video segment to proportional mono text
+//   data = pointer to text buffer
+//   font = pointer to proportional font (generated with GenPTextFont function)
+//   fontheight = font height
+//   bg = background color
+//   fg = foreground color
+//   wb = pitch - number of bytes between text lines
+// Text row must contain enough characters to fill whole segment width (add spaces at the end).
+// To scroll text horizontally, set wrapx to pixel width of the text row and shift offx.
+void ScreenSegmPText(sSegm* segm, const void* data, const void* font, u16 fontheight, u8 bg, u8 fg, int wb)
+{
+	segm->form = GF_COLOR;
+	__dmb();
+	segm->data = data;
+	segm->par = (u32)font;
+	segm->par2 = bg | ((u32)fg << 8);
+	segm->par3 = fontheight;
+	segm->wb = wb;
+	__dmb();
+	segm->form = GF_PTEXT;
+	__dmb();
+}
+
+// generate font with more pages for function ScreenSegmWText
+//   dst = pointer to destination font buffer, size pages*fontheight*256 bytes
+//   fonts = array of pointers to source 1-bit fonts of 256 characters of width 8
+//   pages = number of font pages
+//   fontheight = font height
+// Character code of page p and character ch is p*256+ch.
+void GenFontPages(u8* dst, const u8* const* fonts, int pages, int fontheight)
+{
+	int y, p;
+	for (y = 0; y < fontheight; y++)
+	{
+		for (p = 0; p < pages; p++)
+		{
+			memcpy(dst, &fonts[p][y*256], 256);
+			dst += 256;
+		}
+	}
+}
+
+// set video segment to 8-pixel wide character attribute text
+//   data = pointer to text buffer (16-bit character LOW and HIGH + 2x4 bit attributes)
+//   font = pointer to 1-bit font with more pages of 256 characters (generated with GenFontPages function)
+//   fontheight = font height
+//   pages = number of font pages (character code must be less than pages*256)
+//   pal = pointer to palette of 16 colors
+//   wb = pitch - number of bytes between text lines
+void ScreenSegmWText(sSegm* segm, const void* data, const void* font, u8 fontheight, u8 pages, const void* pal, int wb)
+{
+	segm->form = GF_COLOR;
+	__dmb();
+	segm->data = data;
+	segm->par = (u32)font;
+	segm->par2 = (u32)pal;
+	segm->par3 = fontheight | ((u16)pages << 8);
+	segm->wb = wb;
+	__dmb();
+	segm->form = GF_WTEXT;
+	__dmb();
+}
+
+// prepare traces of multi-trace oscilloscope (call after change of samples or trace parameters)
+//   osc = descriptor of multi-trace oscilloscope
+// Samples are converted to Y ranges of pixels (Y = off + sample*gain/256,
+// limited to 0..254) and Y ranges of 16-pixel blocks, used by renderer.
+void MOscilPrep(sMOscil* osc)
+{
+	int t, i, y, y2, lo, hi, blo, bhi;
+	int w = osc->width;
+	for (t = 0; t < osc->num; t++)
+	{
+		sMOscTrace* trace = &osc->trace[t];
+		const u8* s = trace->data;
+		u8* d = trace->buf;
+
+		// trace is off
+		if ((s == NULL) || (d == NULL))
+		{
+			trace->blk = NULL;
+			continue;
+		}
+
+		// prepare Y ranges of pixels and blocks
+		u8* blk = d + w*2;
+		int off = trace->off;
+		int gain = trace->gain;
+		y2 = off + ((s[0]*gain) >> 8);
+		if (y2 < 0) y2 = 0;
+		if (y2 > 254) y2 = 254;
+		blo = 255;
+		bhi = 0;
+		int tlo = 255;
+		int thi = 0;
+		for (i = 0; i < w; i++)
+		{
+			// current and next sample
+			y = y2;
+			if (i < w-1)
+			{
+				y2 = off + ((s[i+1]*gain) >> 8);
+				if (y2 < 0) y2 = 0;
+				if (y2 > 254) y2 = 254;
+			}
+
+			// Y range of pixel
+			lo = y;
+			hi = y;
+			if (osc->line)
+			{
+				if (y2 > y) hi = y2 - 1;
+				if (y2 < y) lo = y2 + 1;
+			}
+			d[0] = (u8)lo;
+			d[1] = (u8)(hi - lo);
+			d += 2;
+
+			// Y range of block
+			if (lo < blo) blo = lo;
+			if (hi > bhi) bhi = hi;
+			if (((i & 15) == 15) || (i == w-1))
+			{
+				if (blo < tlo) tlo = blo;
+				if (bhi > thi) thi = bhi;
+				blk[0] = (u8)blo;
+				blk[1] = (u8)(bhi - blo);
+				blk += 2;
+				blo = 255;
+				bhi = 0;
+			}
+		}
+		trace->ylo = (u8)tlo;
+		trace->ylen = (u8)(thi - tlo);
+		__dmb();
+		trace->blk = trace->buf + w*2;
+	}
+	__dmb();
+}
+
+// set video segment to multi-trace oscilloscope graph GF_MOSCIL
+//   osc = descriptor of multi-trace oscilloscope (traces must be prepared with MOscilPrep)
+// Height of the segment (wrapy) must be max. 255 lines.
+// Traces are drawn over graticule in order of their indices.
+void ScreenSegmMOscil(sSegm* segm, sMOscil* osc)
+{
+	segm->form = GF_COLOR;
+	__dmb();
+	segm->data = osc;
+	segm->par = (u32)osc;
+	__dmb();
+	segm->form = GF_MOSCIL;
+	__dmb();
+}
+
+// generate FRC palette table for function ScreenSegmFrc
+//   dst = pointer to destination FRC palette table (u8 frc[512])
+//   pal = pointer to source palette of 12-bit colors (u16 pal[256], 0x0RGB)
+//   num = number of palette entries (max. 256)
+// Each color channel is rounded to half-steps of R3G3B2 and split into 2 nearest
+// colors, which are mixed by FRC to 15x15x7 perceived levels.
+void GenFrcPal(u8* dst, const u16* pal, int num)
+{
+	int i, c, r, g, b;
+	for (i = 0; i < num; i++)
+	{
+		c = pal[i];
+
+		// channels in half-steps of output levels (R 0..14, G 0..14, B 0..6)
+		r = (((c >> 8) & 0x0f)*14 + 7)/15;
+		g = (((c >> 4) & 0x0f)*14 + 7)/15;
+		b = ((c & 0x0f)*6 + 7)/15;
+
+		// lower and higher color
+		dst[i] = (u8)(((r >> 1) << 5) | ((g >> 1) << 2) | (b >> 1));
+		dst[i + 256] = (u8)((((r + 1) >> 1) << 5) | (((g + 1) >> 1) << 2) | ((b + 1) >> 1));
+	}
+}
+
+// set video segment to 8-bit paletted graphics with temporal dithering (FRC)
+//   data = pointer to data buffer with 8-bit palette indices
+//   frc = pointer to FRC palette table (generated with GenFrcPal function)
+//   wb = pitch - number of bytes between lines
+// Pixels alternate between 2 nearest colors in checkerboard, which is inverted on each frame.
+// To scroll image, set virtual dimension wrapx and wrapy, then shift offx and offy.
+void ScreenSegmFrc(sSegm* segm, const void* data, const void* frc, int wb)
+{
+	segm->form = GF_COLOR;
+	__dmb();
+	segm->data = data;
+	segm->par = (u32)frc;
+	segm->wb = wb;
+	__dmb();
+	segm->form = GF_FRC;
+	__dmb();
+}
+
+// generate 16-color planes translation table for function ScreenSegmPlane4
+//  trans = pointer to destination translation table (u8 trans[PLANE4_TRANSSIZE])
+//  pal = pointer to source palette of 16 colors (u8 pal[16])
+// To change palette later, use GenPal16Trans((u16*)(trans + PLANE4_PALOFF), pal).
+void GenPal16Plane(u8* trans, const u8* pal)
+{
+	int i, j;
+	u32 k;
+	u32* e = (u32*)trans;
+	for (i = 0; i < 256; i++)
+	{
+		// offset of 16-color palette table
+		k = B9 | B25;
+
+		// pixel 0 -> bits 5,6
+		j = ((i >> 3) & 1) | ((i >> 6) & 2);
+		k |= (u32)j << 5;
+
+		// pixel 1 -> bits 1,2
+		j = ((i >> 2) & 1) | ((i >> 5) & 2);
+		k |= (u32)j << 1;
+
+		// pixel 2 -> bits 21,22
+		j = ((i >> 1) & 1) | ((i >> 4) & 2);
+		k |= (u32)j << 21;
+
+		// pixel 3 -> bits 17,18
+		j = (i & 1) | ((i >> 3) & 2);
+		k |= (u32)j << 17;
+
+		e[i] = k;
+	}
+
+	// 16-color palette translation table
+	GenPal16Trans((u16*)(trans + PLANE4_PALOFF), pal);
+}
+
+// set video segment to 16-color on 4-planes graphics
+//   data = pointer to data buffer
+//   plane = offset of next graphics plane (in bytes), size of one graphics plane
+//   trans = pointer to 16-color planes translation table (generated with GenPal16Plane function)
+//   wb = pitch - number of bytes between lines
+// Planes 0..3 follow at distance 'plane', bit of plane N is bit N of color index.
+// To scroll image, set virtual dimension wrapx and wrapy, then shift offx and offy.
+void ScreenSegmPlane4(sSegm* segm, const void* data, int plane, const void* trans, int wb)
+{
+	segm->form = GF_COLOR;
+	__dmb();
+	segm->data = data;
+	segm->par = plane;
+	segm->par2 = (u32)trans;
+	segm->wb = wb;
+	__dmb();
+	segm->form = GF_PLANE4;
+	__dmb();
+}
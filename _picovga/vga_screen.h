@@ -19,7 +19,8 @@ typedef struct {
 	u16	wrapy;	// SSEGM_WRAPY wrap width in Y direction (number of lines, cannot be 0)
 	const void* data; // SSEGM_DATA pointer to video buffer with image data
 	u8	form;	// SSEGM_FORM graphics format GF_*
-	bool	dbly;	// SSEGM_DBLY double Y (2 scanlines per 1 image line)
+	u8	dbly:1;	// SSEGM_DBLY bit 0: double Y (2 scanlines per 1 image line)
+	u8	dblx:2;	// SSEGM_DBLY bits 1..2: repeat pixels in X direction DBLX_*
 	u16	par3;	// SSEGM_PAR3 parameter 3
 	u32	par;	// SSEGM_PAR parameter 1
 	u32	par2;	// SSEGM_PAR2 parameter 2
@@ -42,6 +43,7 @@ typedef struct {
 // current video screen
 extern sScreen Screen;		// default video screen
 extern sScreen* pScreen;	// pointer to current video screen
+extern sScreen VideoScreen;	// spare video screen (Video() prepares new layout in screen not being displayed)
 
 // clear screen (set 0 strips, does not modify sprites)
 void ScreenClear(sScreen* s);
@@ -52,6 +54,44 @@ sStrip* ScreenAddStrip(sScreen* s, int height);
 // add empty segment to video strip (returns pointer to the segment and initialises is to defaults)
 sSegm* ScreenAddSegm(sStrip* strip, int width);
 
+// text cursor (used by text formats GF_ATEXT, GF_FTEXT and GF_CTEXT)
+typedef struct {
+	sSegm*	segm;	// video segment with cursor (NULL = cursor is off)
+	u16	x;	// cursor column (in characters)
+	u16	y;	// cursor row (in characters)
+	u8	top;	// first font line of cursor shape
+	u8	bottom;	// last font line of cursor shape
+	u8	col;	// cursor color mask (XORed with pixels, 0xff = invert)
+	u8	blink;	// cursor blinking, number of frame counter bits of half period (0 = no blinking)
+} sTextCursor;
+
+extern sTextCursor TextCursor;	// text cursor
+extern u8 TextBlink;		// text blinking, number of frame counter bits of half period (default 5 = 32 frames)
+
+// set text cursor
+//   segm = video segment with text GF_ATEXT, GF_FTEXT or GF_CTEXT
+//   x = cursor column (in characters)
+//   y = cursor row (in characters)
+//   top = first font line of cursor shape (0 = block cursor, fontheight-2 = underline cursor)
+//   bottom = last font line of cursor shape (usually fontheight-1)
+//   col = cursor color mask (XORed with pixels, 0xff = invert)
+//   blink = cursor blinking, number of frame counter bits of half period (0 = no blinking, 4 = 16 frames)
+void ScreenCursor(sSegm* segm, int x, int y, u8 top, u8 bottom, u8 col, u8 blink);
+
+// set text cursor position
+void ScreenCursorPos(int x, int y);
+
+// hide text cursor
+void ScreenCursorOff();
+
+// set blinking of text segment (call after setting text format)
+//   segm = video segment with text GF_ATEXT, GF_FTEXT or GF_CTEXT
+//   mask = mask of blink bits in byte after character (0 = no blinking, 0x80 = bit 7 of attributes)
+// Byte after character is tested: GF_ATEXT attributes, GF_FTEXT foreground color, GF_CTEXT background color.
+// During hidden phase of blinking characters are displayed with background color only.
+// With GF_ATEXT and mask 0x80, set palette entries 8..15 the same as 0..7 to get PC-like blinking.
+void ScreenSegmBlink(sSegm* segm, u8 mask);
+
 // set video segment to simple color format GF_COLOR
 //  col1 = color pattern 4-pixels even line (use macro MULTICOL)
 //  col2 = color pattern 4-pixels odd line (use macro MULTICOL)
@@ -304,4 +344,118 @@ void ScreenSegmTilePersp3(sSegm* segm, const u8* map, const u8* tiles, const int
 void ScreenSegmTilePersp4(sSegm* segm, const u8* map, const u8* tiles, const int* mat, 
 	u8 mapwbits, u8 maphbits, u8 tilebits, s8 horizon);
 
+// generate proportional font for function ScreenSegmPText
+//   dst = pointer to destination font buffer, size (fontheight+1)*256 bytes
+//   src = pointer to source 1-bit font of 256 characters of width 8 (total width of image 2048 pixels)
+//   fontheight = font height
+//   spacing = number of blank pixels after glyph (usually 1)
+//   space = width of empty glyphs (usually 3 or 4)
+// Glyphs are shifted left to remove empty columns and their advances (width + spacing)
+// are stored into line with index "fontheight" of destination buffer. Returns False
+// if some advance is out of range 0..PTEXT_MAXW (font is not usable).
+Bool GenPTextFont(u8* dst, const u8* src, int fontheight, int spacing, int space);
+
+// get width of text in pixels, using proportional font
+//   text = text
+//   len = length of text
+//   font = pointer to proportional font (generated with GenPTextFont function)
+//   fontheight = font height
+int PTextWidth(const char* text, int len, const u8* font, int fontheight);
+
+// set video segment to proportional mono text
+//   data = pointer to text buffer
+//   font = pointer to proportional font (generated with GenPTextFont function)
+//   fontheight = font height
+//   bg = background color
+//   fg = foreground color
+//   wb = pitch - number of bytes between text lines
+// Text row must contain enough characters to fill whole segment width (add spaces at the end).
+// To scroll text horizontally, set wrapx to pixel width of the text row and shift offx.
+void ScreenSegmPText(sSegm* segm, const void* data, const void* font, u16 fontheight, u8 bg, u8 fg, int wb);
+
+// generate font with more pages for function ScreenSegmWText
+//   dst = pointer to destination font buffer, size pages*fontheight*256 bytes
+//   fonts = array of pointers to source 1-bit fonts of 256 characters of width 8
+//   pages = number of font pages
+//   fontheight = font height
+// Character code of page p and character ch is p*256+ch.
+void GenFontPages(u8* dst, const u8* const* fonts, int pages, int fontheight);
+
+// set video segment to 8-pixel wide character attribute text
+//   data = pointer to text buffer (16-bit character LOW and HIGH + 2x4 bit attributes)
+//   font = pointer to 1-bit font with more pages of 256 characters (generated with GenFontPages function)
+//   fontheight = font height
+//   pages = number of font pages (character code must be less than pages*256)
+//   pal = pointer to palette of 16 colors
+//   wb = pitch - number of bytes between text lines
+void ScreenSegmWText(sSegm* segm, const void* data, const void* font, u8 fontheight, u8 pages, const void* pal, int wb);
+
+// oscilloscope trace (on change update SMOSCTRACE_* in define.h)
+typedef struct {
+	const u8* data;	// SMOSCTRACE_DATA source samples 0..255 (NULL = trace is off)
+	u8*	buf;	// SMOSCTRACE_BUF buffer of Y ranges of pixels, MOSCIL_BUFSIZE(width) bytes
+	u8*	blk;	// SMOSCTRACE_BLK pointer to Y ranges of 16-pixel blocks (prepared by MOscilPrep, NULL = trace is off)
+	s16	off;	// SMOSCTRACE_OFF Y offset of sample 0 (in lines from bottom)
+	s16	gain;	// SMOSCTRACE_GAIN gain (256 = 1 line per sample step, negative = inverted)
+	u8	col;	// SMOSCTRACE_COL trace color
+	u8	ylo;	// SMOSCTRACE_YLO first line of Y range of whole trace (prepared by MOscilPrep)
+	u8	ylen;	// SMOSCTRACE_YLEN number of lines - 1 of Y range of whole trace (prepared by MOscilPrep)
+	u8	res;	// ...reserved, structure align
+} sMOscTrace;
+
+// multi-trace oscilloscope (on change update SMOSCIL_* in define.h)
+typedef struct {
+	u16	width;	// SMOSCIL_WIDTH number of samples (= wrapx of the segment)
+	u8	num;	// SMOSCIL_NUM number of traces (0..MOSCIL_MAX)
+	u8	bg;	// SMOSCIL_BG background color
+	u8	grid;	// SMOSCIL_GRID graticule color
+	u8	gridx;	// SMOSCIL_GRIDX X step of graticule in pixels (0 = no vertical lines)
+	u8	gridy;	// SMOSCIL_GRIDY Y step of graticule in lines (0 = no horizontal lines)
+	u8	line;	// SMOSCIL_LINE True = connect samples with lines, False = pixels
+	sMOscTrace trace[MOSCIL_MAX]; // SMOSCIL_TRACE traces
+} sMOscil;
+
+// prepare traces of multi-trace oscilloscope (call after change of samples or trace parameters)
+//   osc = descriptor of multi-trace oscilloscope
+// Samples are converted to Y ranges of pixels (Y = off + sample*gain/256,
+// limited to 0..254) and Y ranges of 16-pixel blocks, used by renderer.
+void MOscilPrep(sMOscil* osc);
+
+// set video segment to multi-trace oscilloscope graph GF_MOSCIL
+//   osc = descriptor of multi-trace oscilloscope (traces must be prepared with MOscilPrep)
+// Height of the segment (wrapy) must be max. 255 lines.
+// Traces are drawn over graticule in order of their indices.
+void ScreenSegmMOscil(sSegm* segm, sMOscil* osc);
+
+// generate FRC palette table for function ScreenSegmFrc
+//   dst = pointer to destination FRC palette table (u8 frc[512])
+//   pal = pointer to source palette of 12-bit colors (u16 pal[256], 0x0RGB)
+//   num = number of palette entries (max. 256)
+// Each color channel is rounded to half-steps of R3G3B2 and split into 2 nearest
+// colors, which are mixed by FRC to 15x15x7 perceived levels.
+void GenFrcPal(u8* dst, const u16* pal, int num);
+
+// set video segment to 8-bit paletted graphics with temporal dithering (FRC)
+//   data = pointer to data buffer with 8-bit palette indices
+//   frc = pointer to FRC palette table (generated with GenFrcPal function)
+//   wb = pitch - number of bytes between lines
+// Pixels alternate between 2 nearest colors in checkerboard, which is inverted on each frame.
+// To scroll image, set virtual dimension wrapx and wrapy, then shift offx and offy.
+void ScreenSegmFrc(sSegm* segm, const void* data, const void* frc, int wb);
+
+// generate 16-color planes translation table for function ScreenSegmPlane4
+//  trans = pointer to destination translation table (u8 trans[PLANE4_TRANSSIZE])
+//  pal = pointer to source palette of 16 colors (u8 pal[16])
+// To change palette later, use GenPal16Trans((u16*)(trans + PLANE4_PALOFF), pal).
+void GenPal16Plane(u8* trans, const u8* pal);
+
+// set video segment to 16-color on 4-planes graphics
+//   data = pointer to data buffer
+//   plane = offset of next graphics plane (in bytes), size of one graphics plane
+//   trans = pointer to 16-color planes translation table (generated with GenPal16Plane function)
+//   wb = pitch - number of bytes between lines
+// Planes 0..3 follow at distance 'plane', bit of plane N is bit N of color index.
+// To scroll image, set virtual dimension wrapx and wrapy, then shift offx and offy.
+void ScreenSegmPlane4(sSegm* segm, const void* data, int plane, const void* trans, int wb);
+
 #endif // _VGA_SCREEN_H
@@ -48,39 +48,395 @@ typedef struct {
 	bool	odd;		// first sub-frame is odd lines 1, 3, 5,... (PAL)
 } sVideo;
 
+// Video timings are constexpr, to be usable in compile-time videomode setup.
+
 // === TV videomodes
 
 // TV PAL interlaced 5:4 720x576 (4:3 768x576, 16:9 1024x576)
-extern const sVideo VideoPAL;
+inline constexpr sVideo VideoPAL = {
+	// horizontal (horizontal frequency 15625 Hz, effective sync pulses 16000 Hz)
+	.htot=   64.00000f,	// total scanline in [us]
+	.hfront=  1.65000f,	// H front porch (after image, before HSYNC) in [us]
+	.hsync=   4.70000f,	// H sync pulse in [us]
+	.hback=   5.70000f,	// H back porch (after HSYNC, before image) in [us]
+	.hfull=  47.36000f,	// H full visible in [us] (formally should be 51.95 us) 
+
+	// vertical (vertical frequency 50 Hz)
+	.vtot=625,		// total scanlines (both subframes)
+	.vmax=576,		// maximal height
+
+	// subframe 1
+	.vsync1=5,		// V sync (half-)pulses on subframe 1
+	.vpost1=5,		// V sync post half-pulses on subframe 1
+	.vback1=18+23,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=240,		// active visible scanlines, subframe 1 (formally should be 288, 576 total)
+	.vfront1=24,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=5,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=5,		// V sync half-pulses on subframe 2
+	.vpost2=4,		// V sync post half-pulses on subframe 2
+	.vback2=18+23,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=240,		// active visible scanlines, subframe 2 (formally should be 288, 576 total)
+	.vfront2=24,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=6,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "PAL  ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=True,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=True,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // TV PAL progressive 5:4 360x288 (4:3 384x288, 16:9 512x288)
-extern const sVideo VideoPALp;
+inline constexpr sVideo VideoPALp = {
+	// horizontal (horizontal frequency 15625 Hz)
+	.htot=   64.00000f,	// total scanline in [us]
+	.hfront=  1.65000f,	// H front porch (after image, before HSYNC) in [us]
+	.hsync=   4.70000f,	// H sync pulse in [us]
+	.hback=   5.70000f,	// H back porch (after HSYNC, before image) in [us]
+	.hfull=  47.36000f,	// H full visible in [us] (formally should be 51.95 us) 
+
+	// vertical (vertical frequency 50 Hz)
+	.vtot=312,		// total scanlines (both subframes)
+	.vmax=288,		// maximal height
+
+	// subframe 1
+	.vsync1=2,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=18+23+2,	// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=240,		// active visible scanlines, subframe 1 (formally should be 288, 576 total)
+	.vfront1=24+3,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2 (formally should be 288, 576 total)
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=0,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "PALp ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=True,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // TV NTSC interlaced 4:3 640x480 (5:4 600x480, 16:9 848x480)
-extern const sVideo VideoNTSC;
+//   serration pulses (half vsync): 27.3 us low, 4.5 us high
+//   equalizing pulses (half hsync): 2.3 us low, 29.5 us high
+//   blanked video (hsync pulses): 4.7 us low, 58.9 us high
+inline constexpr sVideo VideoNTSC = {
+	// horizontal (horizontal frequency 15734 Hz, effective sync pulses 16274 Hz)
+	.htot=   63.55582f,	// total scanline in [us]
+	.hfront=  1.50000f,	// H front porch (after image, before HSYNC) in [us]
+	.hsync=   4.70000f,	// H sync pulse in [us]
+	.hback=   4.50000f,	// H back porch (after HSYNC, before image) in [us]
+	.hfull=  47.03130f,	// H full visible in [us]
+
+	// vertical
+	.vtot=525,		// total scanlines (both subframes)
+	.vmax=480,		// maximal height
+
+	// subframe 1
+	.vsync1=6,		// V sync (half-)pulses on subframe 1
+	.vpost1=6,		// V sync post half-pulses on subframe 1
+	.vback1=10+2,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=240,		// active visible scanlines, subframe 1
+	.vfront1=1,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=7,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=6,		// V sync half-pulses on subframe 2
+	.vpost2=5,		// V sync post half-pulses on subframe 2
+	.vback2=11+2,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=240,		// active visible scanlines, subframe 2
+	.vfront2=1,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=6,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "NTSC ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=True,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // TV NTSC progressive 4:3 320x240 (5:4 300x240, 16:9 424x240)
-extern const sVideo VideoNTSCp;
+inline constexpr sVideo VideoNTSCp = {
+	// horizontal (horizontal frequency 15734 Hz)
+	.htot=   63.55582f,	// total scanline in [us]
+	.hfront=  1.50000f,	// H front porch (after image, before HSYNC) in [us]
+	.hsync=   4.70000f,	// H sync pulse in [us]
+	.hback=   4.50000f,	// H back porch (after HSYNC, before image) in [us]
+	.hfull=  47.03130f,	// H full visible in [us]
+
+	// vertical
+	.vtot=262,		// total scanlines (both subframes)
+	.vmax=240,		// maximal height
+
+	// subframe 1
+	.vsync1=3,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=10+2+3,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=240,		// active visible scanlines, subframe 1
+	.vfront1=1+3,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=6,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "NTSCp",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // === Monitor videomodes
 
 // EGA 8:5 640x400 (5:4 500x400, 4:3 528x400, 16:9 704x400), vert. 70 Hz, hor. 31.4685 kHz, pixel clock 25.175 MHz
-extern const sVideo VideoEGA;
+inline constexpr sVideo VideoEGA = {
+	// horizontal
+	.htot=   31.77781f,	// total scanline in [us]
+	.hfront=  0.63556f,	// H front porch (after image, before HSYNC) in [us]
+	.hsync=   3.81334f,	// H sync pulse in [us]
+	.hback=   1.90667f,	// H back porch (after HSYNC, before image) in [us]
+	.hfull=  25.42224f,	// H full visible in [us]
+
+	// vertical
+	.vtot=449,		// total scanlines (both subframes)
+	.vmax=400,		// maximal height
+
+	// subframe 1
+	.vsync1=2,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=35,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=400,		// active visible scanlines, subframe 1
+	.vfront1=12,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=0,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "EGA  ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // VGA 4:3 640x480 (16:9 848x480), vert. 60 Hz, hor. 31.4685 kHz, pixel clock 25.175 MHz
-extern const sVideo VideoVGA;
+inline constexpr sVideo VideoVGA = {
+	// horizontal
+	.htot=   31.77781f,	// total scanline in [us] (800 pixels)
+	.hfront=  0.63556f,	// H front porch (after image, before HSYNC) in [us] (16 pixels)
+	.hsync=   3.81334f,	// H sync pulse in [us] (96 pixels)
+	.hback=   1.90667f,	// H back porch (after HSYNC, before image) in [us] (48 pixels)
+	.hfull=  25.42224f,	// H full visible in [us] (640 pixels)
+
+	// vertical
+	.vtot=525,		// total scanlines (both subframes)
+	.vmax=480,		// maximal height
+
+	// subframe 1
+	.vsync1=2,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=33,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=480,		// active visible scanlines, subframe 1
+	.vfront1=10,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=0,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "VGA  ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // SVGA 4:3 800x600 (16:9 1064x600), vert. 60 Hz, hor. 37.897 kHz, pixel clock 40 MHz
-extern const sVideo VideoSVGA;
+inline constexpr sVideo VideoSVGA = {
+	// horizontal
+	.htot=   26.40000f,	// total scanline in [us] (1056 pixels)
+	.hfront=  1.00000f,	// H front porch (after image, before HSYNC) in [us] (40 pixels)
+	.hsync=   3.20000f,	// H sync pulse in [us] (128 pixels)
+	.hback=   2.20000f,	// H back porch (after HSYNC, before image) in [us] (88 pixels)
+	.hfull=  20.00000f,	// H full visible in [us] (800 pixels)
+
+	// vertical
+	.vtot=628,		// total scanlines (both subframes)
+	.vmax=600,		// maximal height
+
+	// subframe 1
+	.vsync1=4,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=23,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=600,		// active visible scanlines, subframe 1
+	.vfront1=1,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=0,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "SVGA ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=True,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // XGA 4:3 1024x768 (16:9 1360x768), vert. 60 Hz, hor. 48.36310 kHz, pixel clock 65 MHz
-extern const sVideo VideoXGA;
+inline constexpr sVideo VideoXGA = {
+	// horizontal
+	.htot=   20.67692f,	// total scanline in [us] (1344 pixels)
+	.hfront=  0.36923f,	// H front porch (after image, before HSYNC) in [us] (24 pixels)
+	.hsync=   2.09231f,	// H sync pulse in [us] (136 pixels)
+	.hback=   2.46154f,	// H back porch (after HSYNC, before image) in [us] (160 pixels)
+	.hfull=  15.75385f,	// H full visible in [us] (1024 pixels)
+
+	// vertical
+	.vtot=806,		// total scanlines (both subframes)
+	.vmax=768,		// maximal height
+
+	// subframe 1
+	.vsync1=6,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=29,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=768,		// active visible scanlines, subframe 1
+	.vfront1=3,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=0,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "XGA  ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // VESA 4:3 1152x864, vert. 60 Hz, hor. 53.697 kHz, pixel clock 81.62 MHz
-extern const sVideo VideoVESA;
+inline constexpr sVideo VideoVESA = {
+	// horizontal
+	.htot=   18.62289f,	// total scanline in [us] (1520 pixels)
+	.hfront=  0.78412f,	// H front porch (after image, before HSYNC) in [us] (64 pixels)
+	.hsync=   1.47023f,	// H sync pulse in [us] (120 pixels)
+	.hback=   2.25435f,	// H back porch (after HSYNC, before image) in [us] (184 pixels)
+	.hfull=  14.11419f,	// H full visible in [us] (1152 pixels)
+
+	// vertical
+	.vtot=895,		// total scanlines (both subframes)
+	.vmax=864,		// maximal height
+
+	// subframe 1
+	.vsync1=3,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=27,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=864,		// active visible scanlines, subframe 1
+	.vfront1=1,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=0,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "VESA ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=True,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // HD 4:3 1280x960, vert. 53 Hz, hor. 51.858 kHz, pixel clock 102.1 MHz
-extern const sVideo VideoHD;
+#define HD_SLOW 1.15f
+inline constexpr sVideo VideoHD = {
+	// horizontal
+	.htot=   16.76787f*HD_SLOW,	// total scanline in [us] (1712 pixels)
+	.hfront=  0.78355f*HD_SLOW,	// H front porch (after image, before HSYNC) in [us] (80 pixels)
+	.hsync=   1.33203f*HD_SLOW,	// H sync pulse in [us] (136 pixels)
+	.hback=   2.11557f*HD_SLOW,	// H back porch (after HSYNC, before image) in [us] (216 pixels)
+	.hfull=  12.53673f*HD_SLOW,	// H full visible in [us] (1280 pixels)
+
+	// vertical
+	.vtot=994-10,		// total scanlines (both subframes)
+	.vmax=960,		// maximal height
+
+	// subframe 1
+	.vsync1=3,		// V sync (half-)pulses on subframe 1
+	.vpost1=0,		// V sync post half-pulses on subframe 1
+	.vback1=30-10,		// V back porch (after VSYNC, before image) on subframe 1
+	.vact1=960,		// active visible scanlines, subframe 1
+	.vfront1=1,		// V front porch (after image, before VSYNC) on subframe 1
+	.vpre1=0,		// V sync pre half-pulses on subframe 1
+
+	// subframe 2 (ignored if not interlaced)
+	.vsync2=0,		// V sync half-pulses on subframe 2
+	.vpost2=0,		// V sync post half-pulses on subframe 2
+	.vback2=0,		// V back porch (after VSYNC, before image) on subframe 2
+	.vact2=0,		// active visible scanlines, subframe 2
+	.vfront2=0,		// V front porch (after image, before VSYNC) on subframe 2
+	.vpre2=0,		// V sync pre half-pulses on subframe 2
+
+	// name
+	.name = "HD   ",	// video timing name (VIDEO_NAME_LEN characters + terminating 0)
+
+	// flags
+	.inter=False,		// interlaced (use subframes)
+	.psync=False,		// positive synchronization
+	.odd=False,		// first sub-frame is odd lines 1, 3, 5,... (PAL)
+};
 
 // required configuration to initialize VGA output
 typedef struct {
@@ -90,6 +446,7 @@ typedef struct {
 	const sVideo*	video;		// used video timings
 	u32	freq;			// required minimal system frequency in kHz (real frequency can be higher)
 	u32	fmax;			// maximal system frequency in kHz (limit resolution if needed)
+	u32	cpuline;		// required minimal system clocks per scanline, CPU budget of rendering (0=no limit)
 	u8	mode[LAYERS_MAX];	// modes of overlapped layers 0..3 LAYERMODE_* (LAYERMODE_BASE = layer is off)
 					//  - mode of layer 0 is ignored (always use LAYERMODE_BASE)
 					//  - all overlapped layers must use same layer program
@@ -210,13 +567,10 @@ extern sCanvas Canvas; // canvas of draw box
 // 16-color palette translation table
 extern u16 Pal16Trans[256];
 
-// initialize default VGA configuration
-void VgaCfgDef(sVgaCfg* cfg);
-
 // debug print videomode setup
 void VgaPrintCfg(const sVmode* vmode);
 
-// calculate videomode setup
+// calculate videomode setup at runtime (see VgaCfgConst in vga_cfg.h for compile-time setup)
 //   cfg ... required configuration
 //   vmode ... destination videomode setup for driver
 void VgaCfg(const sVgaCfg* cfg, sVmode* vmode);
@@ -232,6 +586,8 @@ void VgaCfg(const sVgaCfg* cfg, sVmode* vmode);
 //		- copy font to 4KB or 2 KB RAM buffer with ALIGNED attribute
 //		- text uses color attributes PC_*
 //	FORM_RLE: pointer to image rows (ALIGNED attribute, should be in RAM)
+// New layout is prepared in Screen or VideoScreen, whichever is not displayed, and pScreen
+// is switched to it by VgaSwitch, so the running VGA core never sees a half-built layout.
 void Video(u8 dev, u8 res, u8 form, u8* buf, const void* buf2 = FontBoldB8x16);
 
 #endif // _VGA_VMODE_H
@@ -275,7 +275,14 @@ extern const ALIGNED u8 FontThin8x8[2048];
 #include "_picovga/util/pwmsnd.h" // PWM sound output
 #include "_picovga/vga_pal.h"	// VGA colors and palettes
 #include "_picovga/vga_vmode.h"	// VGA videomodes
+#include "_picovga/util/vgasolve.h" // videomode timing solver
 #include "_picovga/vga_layer.h"	// VGA layers
+#include "_picovga/vga_cfg.h"	// VGA videomode calculation
 #include "_picovga/vga_screen.h" // VGA screen layout
 #include "_picovga/vga_util.h"	// VGA utilities
 #include "_picovga/vga.h"	 // VGA output
+#include "_picovga/util/term.h"	 // VT100/ANSI terminal
+#include "_picovga/util/osccap.h" // oscilloscope capture
+#include "_picovga/util/palanim.h" // palette animation
+#include "_picovga/util/modeline.h" // video timings from modeline and CVT
+#include "_picovga/util/drawlist.h" // deferred draw lists
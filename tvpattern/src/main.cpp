@@ -10,7 +10,7 @@
 /*
  n | timing | Hres | Vres |ratio|  scan | FPS | sysclk
 ---+--------+------+------+-----+-------+-----+-------
-00 | NTSCp  |  320 |  240 | 4:3 | 15734 |  60 | 122666
+00 | NTSCp  |  320 |  240 | 4:3 | 15735 |  60 | 122400
 01 | VGA    |  320 |  240 | 4:3 | 31469 |  60 | 126000
 */
 
@@ -31,13 +31,36 @@ typedef struct {
 } sMono;
 
 // available videomodes
-sMono Mono[] = {
+constexpr sMono Mono[] = {
 	{ 320, 240, 320, &VideoNTSCp, False }, // 4:3
 	{ 320, 240, 320, &VideoVGA,   True }, // 4:3
 };
 
 #define MONO_NUM count_of(Mono) // number of videomodes
 
+// prepare videomode setup (at compile time)
+constexpr sVmode MonoSetup(const sMono* mono)
+{
+	sVgaCfg cfg = {};
+	VgaCfgDef(&cfg); // get default configuration
+	cfg.video = mono->video; // video timings
+	cfg.width = mono->width; // screen width
+	cfg.height = mono->height; // screen height
+	cfg.wfull = mono->full; // full width
+	cfg.dbly = mono->dbly; // double Y
+	cfg.mode[IMG_LAYER] = LAYERMODE_RLE; // layer mode
+	return VgaCfgConst(&cfg); // calculate videomode setup
+}
+
+// videomode setups, prepared at compile time
+constexpr sVmode MonoVmode[] = {
+	MonoSetup(&Mono[0]),
+	MonoSetup(&Mono[1]),
+};
+
+static_assert(count_of(MonoVmode) == MONO_NUM, "MonoVmode must follow Mono table");
+static_assert(VgaVmodeValid(&MonoVmode[0]) && VgaVmodeValid(&MonoVmode[1]), "invalid videomode");
+
 struct ImageInfo
 {
 	int		imgsize;	// image size
@@ -68,15 +91,7 @@ void DisplayImage(const ImageInfo& image, const sMono& mono)
 // prepare videomode configuration
 void MonoCfg(int inx)
 {
-	sMono* mono = &Mono[inx]; // selected videomode
-	VgaCfgDef(&Cfg); // get default configuration
-	Cfg.video = mono->video; // video timings
-	Cfg.width = mono->width; // screen width
-	Cfg.height = mono->height; // screen height
-	Cfg.wfull = mono->full; // full width
-	Cfg.dbly = mono->dbly; // double Y
-	Cfg.mode[IMG_LAYER] = LAYERMODE_RLE; // layer mode
-	VgaCfg(&Cfg, &Vmode); // calculate videomode setup
+	Vmode = MonoVmode[inx]; // videomode setup prepared at compile time
 }
 
 // init videomode
@@ -25,6 +25,8 @@
 //	GF_TILE64 ... control buffer "width/8"+8 bytes
 //	GF_PROGRESS ... control buffer 24 bytes
 //	other formats: data buffer "width" bytes, control buffer 16 bytes
+//    Buffers are allocated from arena of this max. size, by width of current videomode
+//    and active layer modes. Unused rest of the arena is available with VgaArenaFree.
 #define DBUF0_MAX	(MAXX+8)	// max. size of data buffer of layer 0
 #define CBUF0_MAX	((MAXX+24)/4)	// max. size of control buffer of layer 0
 